@@ -1,11 +1,17 @@
+newoption {
+   trigger = "profiler",
+   description = "Compile in CPU scopes and GPU timestamps, shown in the title and exported with P"
+}
+
 workspace "Advanced technics"
    configurations { "Debug", "Release" }
    language "C++"
    architecture "x64"
    systemversion "latest"
-   toolset "v141"
+   cppdialect "C++20"
    optimize "Speed"
-   links { "d3d12", "dxgi", "d3dcompiler" }
+   filter("system:windows")
+      toolset "v142"
    filter("configurations:Debug")
       defines({ "DEBUG" })
       symbols("On")
@@ -15,16 +21,52 @@ workspace "Advanced technics"
       defines({ "NDEBUG" })
       symbols("On")
       targetdir ("bin/release")
+   filter("options:profiler")
+      defines({ "ENABLE_PROFILER" })
 
    project "DX12 window"
       kind "WindowedApp"
       entrypoint "WinMainCRTStartup"
+      links { "d3d12", "dxgi", "d3dcompiler" }
       includedirs { "src" }
       includedirs { "libs/D3DX12" }
       includedirs { "libs/tinyobjloader" }
       includedirs { "libs/stb" }
       files { "src/dx12_labs.h" }
       files { "src/renderer.h", "src/renderer.cpp"}
+      files { "src/ring_allocator.h", "src/ring_allocator.cpp"}
+      files { "src/upload_ring_buffer.h", "src/upload_ring_buffer.cpp"}
+      files { "src/upload_scheduler.h", "src/upload_scheduler.cpp"}
+      files { "src/copy_queue_uploader.h", "src/copy_queue_uploader.cpp"}
+      files { "src/linear_allocator.h", "src/linear_allocator.cpp"}
+      files { "src/constant_buffer_allocator.h", "src/constant_buffer_allocator.cpp"}
+      files { "src/heap_allocator.h", "src/heap_allocator.cpp"}
+      files { "src/indirect_draw_builder.h", "src/indirect_draw_builder.cpp"}
+      files { "src/bindless_texture_table.h", "src/bindless_texture_table.cpp"}
+      files { "src/draw_packet.h", "src/draw_packet.cpp"}
+      files { "src/occlusion_culler.h", "src/occlusion_culler.cpp"}
+      files { "src/frustum_culler.h", "src/frustum_culler.cpp"}
+      files { "src/frame_stages.h", "src/frame_stages.cpp"}
+      files { "src/frame_scheduler.h", "src/frame_scheduler.cpp"}
+      files { "src/camera_controller.h", "src/camera_controller.cpp"}
+      files { "src/spsc_queue.h", "src/triple_buffer.h"}
+      files { "src/job_system.h", "src/job_system.cpp"}
+      files { "src/async_task.h", "src/async_scheduler.h", "src/async_scheduler.cpp"}
+      files { "src/asset_loader.h", "src/asset_loader.cpp"}
+      files { "src/render_graph.h", "src/render_graph.cpp"}
+      files { "src/transient_heap_planner.h", "src/transient_heap_planner.cpp"}
+      files { "src/descriptor_allocator.h", "src/descriptor_allocator.cpp"}
+      files { "src/descriptor_heap_layout.h", "src/descriptor_heap_layout.cpp"}
+      files { "src/descriptor_heap_manager.h", "src/descriptor_heap_manager.cpp"}
+      files { "src/deferred_release_queue.h", "src/deferred_release_queue.cpp"}
+      files { "src/gpu_memory_allocator.h", "src/gpu_memory_allocator.cpp"}
+      files { "src/profiler.h", "src/profiler.cpp"}
+      files { "src/gpu_profiler.h", "src/gpu_profiler.cpp"}
+      files { "src/frame_statistics.h", "src/frame_statistics.cpp"}
+      files { "src/camera_path.h", "src/camera_path.cpp"}
+      files { "src/camera_benchmark.h", "src/camera_benchmark.cpp"}
+      files { "src/command_recorder.h", "src/frame_graph.h", "src/frame_graph.cpp"}
+      files { "src/d3d12_command_recorder.h", "src/d3d12_command_recorder.cpp"}
       files { "libs/tinyobjloader/tiny_obj_loader.h"}
       files { "libs/stb/stb_image.h" }
       --files { "src/model_loader.h", "src/model_loader.cpp"}
@@ -36,4 +78,97 @@ workspace "Advanced technics"
          "{COPY} models/**.mtl \"%{cfg.buildtarget.directory}\"",
          "{COPY} models/**.jpg \"%{cfg.buildtarget.directory}\"",
          "{COPY} models/**.png \"%{cfg.buildtarget.directory}\""
-       }
\ No newline at end of file
+       }
+
+   -- Frame loop on the null device, builds on any platform
+   project "Headless"
+      kind "ConsoleApp"
+      includedirs { "src" }
+      files { "src/draw_packet.h", "src/draw_packet.cpp"}
+      files { "src/occlusion_culler.h", "src/occlusion_culler.cpp"}
+      files { "src/frustum_culler.h", "src/frustum_culler.cpp"}
+      files { "src/frame_stages.h", "src/frame_stages.cpp"}
+      files { "src/camera_controller.h", "src/camera_controller.cpp"}
+      files { "src/job_system.h", "src/job_system.cpp"}
+      files { "src/render_graph.h", "src/render_graph.cpp"}
+      files { "src/transient_heap_planner.h", "src/transient_heap_planner.cpp"}
+      files { "src/descriptor_allocator.h", "src/descriptor_allocator.cpp"}
+      files { "src/linear_allocator.h", "src/linear_allocator.cpp"}
+      files { "src/profiler.h", "src/profiler.cpp"}
+      files { "src/frame_statistics.h", "src/frame_statistics.cpp"}
+      files { "src/camera_path.h", "src/camera_path.cpp"}
+      files { "src/camera_benchmark.h", "src/camera_benchmark.cpp"}
+      files { "src/command_recorder.h", "src/frame_graph.h", "src/frame_graph.cpp"}
+      files { "src/null_device.h", "src/null_device.cpp"}
+      files { "src/headless_renderer.h", "src/headless_renderer.cpp"}
+      files { "src/headless_main.cpp" }
+      filter("system:linux")
+         links { "pthread" }
+
+   -- CPU-side unit tests, run with an optional name filter
+   project "Tests"
+      kind "ConsoleApp"
+      includedirs { "src", "tests" }
+      files { "tests/test.h", "tests/test_main.cpp" }
+      files { "src/heap_allocator.h", "src/heap_allocator.cpp"}
+      files { "tests/heap_allocator_tests.cpp" }
+      files { "src/ring_allocator.h", "src/ring_allocator.cpp"}
+      files { "tests/ring_allocator_tests.cpp" }
+      files { "src/upload_scheduler.h", "src/upload_scheduler.cpp"}
+      files { "tests/upload_scheduler_tests.cpp" }
+      files { "src/indirect_draw_builder.h", "src/indirect_draw_builder.cpp"}
+      files { "tests/indirect_draw_builder_tests.cpp" }
+      files { "src/bindless_texture_table.h", "src/bindless_texture_table.cpp"}
+      files { "tests/bindless_texture_table_tests.cpp" }
+      files { "src/draw_packet.h", "src/draw_packet.cpp"}
+      files { "tests/draw_packet_tests.cpp" }
+      files { "src/job_system.h", "src/job_system.cpp"}
+      files { "src/occlusion_culler.h", "src/occlusion_culler.cpp"}
+      files { "tests/test_camera.h", "tests/occlusion_culler_tests.cpp" }
+      files { "src/frustum_culler.h", "src/frustum_culler.cpp"}
+      files { "tests/frustum_culler_tests.cpp" }
+      files { "src/async_task.h", "src/async_scheduler.h", "src/async_scheduler.cpp"}
+      files { "tests/async_task_tests.cpp" }
+      files { "src/render_graph.h", "src/render_graph.cpp"}
+      files { "src/transient_heap_planner.h", "src/transient_heap_planner.cpp"}
+      files { "src/command_recorder.h", "src/frame_graph.h", "src/frame_graph.cpp"}
+      files { "src/null_device.h", "src/null_device.cpp"}
+      files { "tests/render_graph_tests.cpp" }
+      files { "tests/transient_heap_planner_tests.cpp" }
+      files { "src/descriptor_allocator.h", "src/descriptor_allocator.cpp"}
+      files { "tests/descriptor_allocator_tests.cpp" }
+      files { "src/descriptor_heap_layout.h", "src/descriptor_heap_layout.cpp"}
+      files { "tests/descriptor_heap_layout_tests.cpp" }
+      files { "src/deferred_release_queue.h", "src/deferred_release_queue.cpp"}
+      files { "tests/deferred_release_queue_tests.cpp" }
+      files { "src/profiler.h", "src/profiler.cpp"}
+      files { "tests/profiler_tests.cpp" }
+      files { "src/frame_scheduler.h", "src/frame_scheduler.cpp"}
+      files { "tests/frame_scheduler_tests.cpp" }
+      files { "src/frame_statistics.h", "src/frame_statistics.cpp"}
+      files { "tests/frame_statistics_tests.cpp" }
+      files { "src/frame_stages.h", "src/frame_stages.cpp"}
+      files { "tests/test_scene.h", "tests/frame_stages_tests.cpp" }
+      files { "src/linear_allocator.h", "src/linear_allocator.cpp"}
+      files { "src/headless_renderer.h", "src/headless_renderer.cpp"}
+      files { "tests/headless_renderer_tests.cpp" }
+      filter("system:linux")
+         links { "pthread" }
+
+   -- CPU-side micro-benchmarks, run with an optional name filter
+   project "Benchmarks"
+      kind "ConsoleApp"
+      includedirs { "src", "tests", "benchmarks" }
+      files { "benchmarks/benchmark.h", "benchmarks/benchmark_main.cpp" }
+      files { "src/heap_allocator.h", "src/heap_allocator.cpp"}
+      files { "benchmarks/heap_allocator_benchmarks.cpp" }
+      files { "src/draw_packet.h", "src/draw_packet.cpp"}
+      files { "benchmarks/draw_packet_benchmarks.cpp" }
+      files { "src/job_system.h", "src/job_system.cpp"}
+      files { "benchmarks/job_system_benchmarks.cpp" }
+      files { "src/occlusion_culler.h", "src/occlusion_culler.cpp"}
+      files { "benchmarks/occlusion_culler_benchmarks.cpp" }
+      files { "src/frustum_culler.h", "src/frustum_culler.cpp"}
+      files { "benchmarks/frustum_culler_benchmarks.cpp" }
+      filter("system:linux")
+         links { "pthread" }
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Benchmarks register like tests and print their own results. Timings are
+// the best of a few repetitions, the machine is rarely quiet enough for means.
+struct BenchmarkCase
+{
+	const char* name;
+	void (*function)();
+};
+
+std::vector<BenchmarkCase>& GetBenchmarkCases();
+
+struct BenchmarkRegistration
+{
+	BenchmarkRegistration(const char* name, void (*function)()) { GetBenchmarkCases().push_back({ name, function }); }
+};
+
+#define BENCHMARK(name) \
+	static void name(); \
+	static BenchmarkRegistration name##_registration(#name, name); \
+	static void name()
+
+// Milliseconds of the fastest of repetition_num calls
+template<typename Function>
+double MeasureBest(uint32_t repetition_num, Function&& function)
+{
+	double best_time = 1e30;
+	for (uint32_t repetition = 0; repetition < repetition_num; repetition++)
+	{
+		const std::chrono::high_resolution_clock::time_point start_time = std::chrono::high_resolution_clock::now();
+		function();
+		const std::chrono::duration<double, std::milli> time = std::chrono::high_resolution_clock::now() - start_time;
+		best_time = time.count() < best_time ? time.count() : best_time;
+	}
+	return best_time;
+}
+
+// Keeps the optimizer from dropping work whose result is unused
+template<typename T>
+void KeepValue(const T& value)
+{
+	static volatile T sink;
+	sink = value;
+	(void)sink;
+}
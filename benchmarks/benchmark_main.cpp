@@ -0,0 +1,25 @@
+#include "benchmark.h"
+
+#include <cstring>
+
+std::vector<BenchmarkCase>& GetBenchmarkCases()
+{
+	static std::vector<BenchmarkCase> benchmark_cases;
+	return benchmark_cases;
+}
+
+// Runs every benchmark, or the ones whose name contains the first argument
+int main(int argument_num, char** argument_values)
+{
+	const char* filter = argument_num > 1 ? argument_values[1] : "";
+	for (const BenchmarkCase& benchmark_case : GetBenchmarkCases())
+	{
+		if (!strstr(benchmark_case.name, filter))
+		{
+			continue;
+		}
+		printf("%s\n", benchmark_case.name);
+		benchmark_case.function();
+	}
+	return 0;
+}
@@ -0,0 +1,41 @@
+#include "benchmark.h"
+#include "test_camera.h"
+#include "frustum_culler.h"
+#include "job_system.h"
+
+#include <random>
+
+// 1M boxes around the camera, about a fifth inside the frustum
+BENCHMARK(FrustumCullKernels)
+{
+	float view_projection[16];
+	MakePerspective(view_projection, 1.f, 16.f / 9.f);
+	const FrustumPlanes planes = FrustumPlanes::FromViewProjection(view_projection);
+	const uint32_t instance_num = 1000000;
+	InstanceBounds bounds;
+	bounds.Resize(instance_num);
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> position(-100.f, 100.f);
+	for (uint32_t instance = 0; instance < instance_num; instance++)
+	{
+		const float center[3] = { position(random), position(random) * 0.2f, position(random) };
+		const float min[3] = { center[0] - 0.5f, center[1] - 0.5f, center[2] - 0.5f };
+		const float max[3] = { center[0] + 0.5f, center[1] + 0.5f, center[2] + 0.5f };
+		bounds.Set(instance, min, max);
+	}
+
+	const char* kernel_names[] = { "scalar", "sse2", "avx2" };
+	const uint32_t kernel_num = FrustumCuller::HasAvx2() ? 3 : 2;
+	JobSystem jobs(4);
+	FrustumCuller culler;
+	std::vector<uint8_t> visible(instance_num);
+	for (uint32_t kernel = 0; kernel < kernel_num; kernel++)
+	{
+		culler.SetKernel(static_cast<FrustumCuller::Kernel>(kernel));
+		uint32_t visible_num = 0;
+		const double single_time = MeasureBest(10, [&]() { visible_num = culler.CullRange(planes, bounds, 0, instance_num, visible.data()); });
+		const double jobs_time = MeasureBest(10, [&]() { visible_num = culler.Cull(planes, bounds, instance_num, visible.data(), jobs); });
+		printf("  %-6s 1 thread: %.3f ms, %.0f instances/ms; 4 workers: %.3f ms, %.0f instances/ms; %u visible\n",
+			kernel_names[kernel], single_time, instance_num / single_time, jobs_time, instance_num / jobs_time, visible_num);
+	}
+}
@@ -0,0 +1,49 @@
+#include "benchmark.h"
+#include "heap_allocator.h"
+
+#include <random>
+
+// Placed-resource sized requests, a 256 MB heap with 64K minimum blocks like GPU heaps
+BENCHMARK(BuddyAllocatorStress)
+{
+	const uint64_t heap_size = 256ull * 1024 * 1024;
+	const uint64_t min_block_size = 64 * 1024;
+	const uint32_t operation_num = 200000;
+	HeapAllocatorStatistics statistics = {};
+	uint32_t failed_num = 0;
+	const double time = MeasureBest(3, [&]()
+	{
+		BuddyAllocator allocator(heap_size, min_block_size);
+		std::mt19937 random(1);
+		std::vector<uint64_t> live;
+		failed_num = 0;
+		for (uint32_t operation = 0; operation < operation_num; operation++)
+		{
+			if (live.empty() || random() % 5 < 3)
+			{
+				// Mostly small buffers, now and then a texture of a few MB
+				const uint64_t size = random() % 8 == 0 ? (1 + random() % 4) * 1024 * 1024 : 1 + random() % (256 * 1024);
+				const uint64_t offset = allocator.Allocate(size, min_block_size);
+				if (offset == HeapAllocator::invalid_offset)
+				{
+					failed_num++;
+					continue;
+				}
+				live.push_back(offset);
+			}
+			else
+			{
+				const size_t index = random() % live.size();
+				allocator.Free(live[index]);
+				live[index] = live.back();
+				live.pop_back();
+			}
+		}
+		statistics = allocator.GetStatistics();
+	});
+	printf("  %u operations: %.2f ms, %.1f ns per operation, %u failed\n",
+		operation_num, time, time * 1e6 / operation_num, failed_num);
+	printf("  end state: %llu allocations, utilization %.3f, fragmentation %.3f, %llu free blocks\n",
+		static_cast<unsigned long long>(statistics.allocation_num), statistics.GetUtilization(),
+		statistics.GetFragmentation(), static_cast<unsigned long long>(statistics.free_block_num));
+}
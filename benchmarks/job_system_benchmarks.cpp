@@ -0,0 +1,76 @@
+#include "benchmark.h"
+#include "job_system.h"
+
+#include <cmath>
+
+// Cost of one empty job from Spawn to finished, spawned by an outside thread and by a worker
+BENCHMARK(JobSpawnOverhead)
+{
+	const uint32_t job_num = 10000;
+	JobSystem jobs(4);
+	std::vector<JobHandle> handles(job_num);
+	const double outside_time = MeasureBest(10, [&]()
+	{
+		for (JobHandle& handle : handles)
+		{
+			handle = jobs.Spawn([]() {});
+		}
+		jobs.Wait(handles);
+	});
+	// Jobs spawned from a job land in the worker's own deque
+	const double nested_time = MeasureBest(10, [&]()
+	{
+		jobs.Wait(jobs.Spawn([&]()
+		{
+			for (JobHandle& handle : handles)
+			{
+				handle = jobs.Spawn([]() {});
+			}
+			jobs.Wait(handles);
+		}));
+	});
+	// A chain where every job depends on the previous one
+	const double chain_time = MeasureBest(10, [&]()
+	{
+		JobHandle previous = jobs.Spawn([]() {});
+		for (uint32_t job = 1; job < job_num; job++)
+		{
+			previous = jobs.Spawn([]() {}, { previous });
+		}
+		jobs.Wait(previous);
+	});
+
+	printf("  outside thread: %.3f us per job\n", outside_time * 1000.0 / job_num);
+	printf("  from a worker:  %.3f us per job\n", nested_time * 1000.0 / job_num);
+	printf("  dependency chain: %.3f us per job\n", chain_time * 1000.0 / job_num);
+}
+
+// The same 4096 tasks of fixed arithmetic on 1, 2, 4 and 8 threads
+BENCHMARK(JobParallelForScaling)
+{
+	const uint32_t task_num = 4096;
+	std::vector<float> results(task_num);
+	const auto task = [&](uint32_t index)
+	{
+		float value = static_cast<float>(index);
+		for (uint32_t step = 0; step < 2000; step++)
+		{
+			value = std::sqrt(value * value + 1.f);
+		}
+		results[index] = value;
+	};
+
+	double single_time = 0.0;
+	for (uint32_t thread_num : { 1u, 2u, 4u, 8u })
+	{
+		JobSystem jobs(thread_num);
+		const double time = MeasureBest(10, [&]() { jobs.ParallelFor(task_num, task); });
+		if (thread_num == 1)
+		{
+			single_time = time;
+		}
+		printf("  %u threads: %.3f ms, %.2fx\n", thread_num, time, single_time / time);
+	}
+	KeepValue(results[task_num - 1]);
+	printf("  %u hardware threads\n", std::thread::hardware_concurrency());
+}
@@ -0,0 +1,72 @@
+#include "benchmark.h"
+#include "test_camera.h"
+#include "occlusion_culler.h"
+#include "frustum_culler.h"
+#include "job_system.h"
+
+#include <random>
+
+// A street of 64 wall quads in front of 100k small boxes, 4 workers
+BENCHMARK(OcclusionRasterizeAndTest)
+{
+	float view_projection[16];
+	MakePerspective(view_projection, 1.f, 16.f / 9.f);
+	std::vector<float> positions;
+	std::vector<uint32_t> indices;
+	for (uint32_t wall = 0; wall < 64; wall++)
+	{
+		const float x = (wall % 16) * 2.f - 16.f;
+		const float z = 5.f + (wall / 16) * 8.f;
+		const uint32_t base = static_cast<uint32_t>(positions.size() / 3);
+		const float corners[12] = { x, -1.f, z, x + 1.5f, -1.f, z, x + 1.5f, 2.f, z, x, 2.f, z };
+		positions.insert(positions.end(), corners, corners + 12);
+		const uint32_t quad[6] = { base, base + 2, base + 1, base, base + 3, base + 2 };
+		indices.insert(indices.end(), quad, quad + 6);
+	}
+
+	const uint32_t box_num = 100000;
+	std::mt19937 random(3);
+	std::uniform_real_distribution<float> spread(-30.f, 30.f);
+	std::uniform_real_distribution<float> distance(1.f, 90.f);
+	std::vector<OcclusionBounds> bounds(box_num);
+	for (OcclusionBounds& box : bounds)
+	{
+		const float center[3] = { spread(random), spread(random) * 0.1f, distance(random) };
+		for (uint32_t axis = 0; axis < 3; axis++)
+		{
+			box.min[axis] = center[axis] - 0.25f;
+			box.max[axis] = center[axis] + 0.25f;
+		}
+	}
+
+	JobSystem jobs(4);
+	OcclusionCuller culler;
+	std::vector<uint8_t> visible(box_num);
+	const auto rasterize = [&]()
+	{
+		culler.BeginFrame(view_projection);
+		culler.AddOccluder(positions.data(), 3 * sizeof(float), indices.data(), static_cast<uint32_t>(indices.size()), 0);
+		culler.Rasterize(jobs);
+	};
+	culler.SetKernel(OcclusionCuller::KERNEL_SSE2);
+	const double sse2_rasterize_time = MeasureBest(20, rasterize);
+	double avx2_rasterize_time = 0.0;
+	if (FrustumCuller::HasAvx2())
+	{
+		culler.SetKernel(OcclusionCuller::KERNEL_AVX2);
+		avx2_rasterize_time = MeasureBest(20, rasterize);
+	}
+	const double test_time = MeasureBest(20, [&]()
+	{
+		std::fill(visible.begin(), visible.end(), uint8_t(1));
+		culler.TestVisibility(bounds.data(), box_num, visible.data(), jobs);
+	});
+	uint32_t visible_num = 0;
+	for (uint8_t box_visible : visible)
+	{
+		visible_num += box_visible;
+	}
+
+	printf("  rasterize %u triangles: SSE2 %.3f ms, AVX2 %.3f ms\n", culler.GetTriangleNum(), sse2_rasterize_time, avx2_rasterize_time);
+	printf("  test %u boxes: %.3f ms, %.0f boxes/ms, %u visible\n", box_num, test_time, box_num / test_time, visible_num);
+}
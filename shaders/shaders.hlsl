@@ -1,9 +1,19 @@
-cbuffer ConstantBuffer: register(b0)
+cbuffer PassConstants: register(b0)
 {
-	float4x4 mwpMatrix;
+	float4x4 vpMatrix;
 }
 
-Texture2D g_texture : register(t0);
+cbuffer DrawConstants: register(b1)
+{
+	float4x4 worldMatrix;
+}
+
+cbuffer MaterialConstants: register(b2)
+{
+	uint textureIndex;
+}
+
+Texture2D g_textures[] : register(t0);
 SamplerState g_sampler: register(s0);
 
 struct PSInput
@@ -18,7 +28,7 @@ PSInput VSMain(float4 position : POSITION, float4 diffuse : DIFFUSE, float4 norm
 	PSInput result;
 
 
-	result.position = mul(mwpMatrix, position);
+	result.position = mul(vpMatrix, mul(worldMatrix, position));
 	result.color = diffuse;
 	result.uv = texcoord.xy;
 
@@ -27,5 +37,5 @@ PSInput VSMain(float4 position : POSITION, float4 diffuse : DIFFUSE, float4 norm
 
 float4 PSMain(PSInput input) : SV_TARGET
 {
-	return 0.5f * input.color + 0.5f * g_texture.Sample(g_sampler, input.uv);
+	return 0.5f * input.color + 0.5f * g_textures[textureIndex].Sample(g_sampler, input.uv);
 }
@@ -0,0 +1,52 @@
+#include "asset_loader.h"
+
+#include "model_loader.h"
+#include "profiler.h"
+#include "stb_image.h"
+
+TextureImage::TextureImage(unsigned char* pixels, uint32_t width, uint32_t height) :
+	pixels(pixels), width(width), height(height)
+{
+}
+
+TextureImage::~TextureImage()
+{
+	stbi_image_free(pixels);
+}
+
+AssetLoader::AssetLoader(JobSystem& jobs, AsyncScheduler& scheduler) :
+	jobs(jobs), scheduler(scheduler)
+{
+}
+
+Task<std::shared_ptr<ModelLoader>> AssetLoader::LoadModelAsync(std::string path, LoadPriority priority, CancellationToken token)
+{
+	co_await scheduler.Schedule(priority, token);
+
+	std::shared_ptr<ModelLoader> model = std::make_shared<ModelLoader>();
+	if (FAILED(model->LoadModel(path, &jobs)))
+	{
+		throw AssetLoadError(path, "the OBJ file could not be read");
+	}
+	co_return model;
+}
+
+Task<std::shared_ptr<TextureImage>> AssetLoader::LoadTextureAsync(std::string path, LoadPriority priority, CancellationToken token)
+{
+	co_await scheduler.Schedule(priority, token);
+
+	PROFILE_SCOPE("Decode texture");
+	int tex_width, tex_height, tex_channels;
+	unsigned char* pixels = stbi_load(
+		path.c_str(),
+		&tex_width,
+		&tex_height,
+		&tex_channels,
+		STBI_rgb_alpha
+	);
+	if (!pixels)
+	{
+		throw AssetLoadError(path, stbi_failure_reason());
+	}
+	co_return std::make_shared<TextureImage>(pixels, static_cast<uint32_t>(tex_width), static_cast<uint32_t>(tex_height));
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "async_scheduler.h"
+#include "async_task.h"
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+class ModelLoader;
+
+// Thrown from a load whose file is missing or cannot be decoded
+class AssetLoadError : public std::runtime_error
+{
+public:
+	AssetLoadError(const std::string& path, const std::string& reason) :
+		std::runtime_error("Failed to load " + path + ": " + reason), path(path) {}
+
+	const std::string& GetPath() const { return path; }
+
+protected:
+	std::string path;
+};
+
+// RGBA8 pixels decoded by stb_image
+class TextureImage
+{
+public:
+	TextureImage(unsigned char* pixels, uint32_t width, uint32_t height);
+	~TextureImage();
+	TextureImage(const TextureImage&) = delete;
+	TextureImage& operator=(const TextureImage&) = delete;
+
+	const unsigned char* GetPixels() const { return pixels; }
+	uint32_t GetWidth() const { return width; }
+	uint32_t GetHeight() const { return height; }
+	uint32_t GetRowPitch() const { return width * 4; }
+
+protected:
+	unsigned char* pixels;
+	uint32_t width;
+	uint32_t height;
+};
+
+// Awaitable CPU side of asset loading. Every load first waits for a
+// scheduler slot of its priority, so dependent loads read as straight line
+// code without blocking a worker, and a cancelled load throws LoadCancelled
+// before it touches the file. Failed loads throw AssetLoadError.
+class AssetLoader
+{
+public:
+	AssetLoader(JobSystem& jobs, AsyncScheduler& scheduler);
+
+	Task<std::shared_ptr<ModelLoader>> LoadModelAsync(std::string path,
+		LoadPriority priority = LoadPriority::Normal, CancellationToken token = CancellationToken());
+	Task<std::shared_ptr<TextureImage>> LoadTextureAsync(std::string path,
+		LoadPriority priority = LoadPriority::Normal, CancellationToken token = CancellationToken());
+
+protected:
+	JobSystem& jobs;
+	AsyncScheduler& scheduler;
+};
@@ -0,0 +1,64 @@
+#include "async_scheduler.h"
+
+AsyncScheduler::AsyncScheduler(JobSystem& jobs, uint32_t max_in_flight) :
+	jobs(jobs), max_in_flight(max_in_flight > 0 ? max_in_flight : 1), next_sequence(0), in_flight_num(0)
+{
+}
+
+uint32_t AsyncScheduler::GetQueuedNum() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return static_cast<uint32_t>(queue.size());
+}
+
+void AsyncScheduler::Enqueue(std::coroutine_handle<> handle, LoadPriority priority, const CancellationToken& token)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		Entry entry = { handle, priority, next_sequence++, token };
+		queue.push(entry);
+	}
+	Dispatch();
+}
+
+void AsyncScheduler::Dispatch()
+{
+	std::vector<std::pair<std::coroutine_handle<>, bool>> ready;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		while (!queue.empty())
+		{
+			const Entry& entry = queue.top();
+			// Cancelled loads only throw, they need no slot
+			const bool holds_slot = !entry.token.IsCancelled();
+			if (holds_slot && in_flight_num >= max_in_flight)
+			{
+				break;
+			}
+			if (holds_slot)
+			{
+				in_flight_num++;
+			}
+			ready.emplace_back(entry.handle, holds_slot);
+			queue.pop();
+		}
+	}
+	for (const std::pair<std::coroutine_handle<>, bool>& run : ready)
+	{
+		jobs.Spawn([this, run] { Run(run.first, run.second); });
+	}
+}
+
+void AsyncScheduler::Run(std::coroutine_handle<> handle, bool holds_slot)
+{
+	// The slot is held until the coroutine suspends again or finishes
+	handle.resume();
+	if (holds_slot)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			in_flight_num--;
+		}
+		Dispatch();
+	}
+}
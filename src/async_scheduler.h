@@ -0,0 +1,122 @@
+#pragma once
+
+#include "job_system.h"
+
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <vector>
+
+enum class LoadPriority : uint32_t
+{
+	Background,
+	Normal,
+	Urgent,
+};
+
+// Thrown from co_await AsyncScheduler::Schedule once the load has been cancelled
+class LoadCancelled : public std::exception
+{
+public:
+	const char* what() const noexcept override { return "Load cancelled"; }
+};
+
+// Read side of a CancellationSource. A default token is never cancelled.
+class CancellationToken
+{
+public:
+	CancellationToken() = default;
+	explicit CancellationToken(std::shared_ptr<const std::atomic<bool>> cancelled) : cancelled(std::move(cancelled)) {}
+
+	bool IsCancelled() const { return cancelled && cancelled->load(std::memory_order_acquire); }
+
+protected:
+	std::shared_ptr<const std::atomic<bool>> cancelled;
+};
+
+class CancellationSource
+{
+public:
+	CancellationSource() : cancelled(std::make_shared<std::atomic<bool>>(false)) {}
+
+	void Cancel() { cancelled->store(true, std::memory_order_release); }
+	CancellationToken GetToken() const { return CancellationToken(cancelled); }
+
+protected:
+	std::shared_ptr<std::atomic<bool>> cancelled;
+};
+
+// Moves coroutines onto the job system in priority order. At most
+// max_in_flight of them run at a time, so a burst of background streaming
+// leaves workers free for culling and recording, and an urgent load queued
+// later still starts before the backlog.
+class AsyncScheduler
+{
+public:
+	class ScheduleAwaiter
+	{
+	public:
+		ScheduleAwaiter(AsyncScheduler& scheduler, LoadPriority priority, CancellationToken token) :
+			scheduler(scheduler), priority(priority), token(std::move(token)) {}
+
+		bool await_ready() const { return token.IsCancelled(); }
+		void await_suspend(std::coroutine_handle<> handle) { scheduler.Enqueue(handle, priority, token); }
+		void await_resume() const
+		{
+			if (token.IsCancelled())
+			{
+				throw LoadCancelled();
+			}
+		}
+
+	protected:
+		AsyncScheduler& scheduler;
+		LoadPriority priority;
+		CancellationToken token;
+	};
+
+	explicit AsyncScheduler(JobSystem& jobs, uint32_t max_in_flight = 4);
+
+	// Resumes the awaiting coroutine on a worker, throws LoadCancelled if cancelled meanwhile.
+	// Every scheduled coroutine has to drain before the scheduler is destroyed.
+	ScheduleAwaiter Schedule(LoadPriority priority = LoadPriority::Normal, CancellationToken token = CancellationToken())
+	{
+		return ScheduleAwaiter(*this, priority, std::move(token));
+	}
+
+	uint32_t GetQueuedNum() const;
+
+protected:
+	struct Entry
+	{
+		std::coroutine_handle<> handle;
+		LoadPriority priority;
+		// Ties keep submission order
+		uint64_t sequence;
+		CancellationToken token;
+
+		bool operator<(const Entry& other) const
+		{
+			if (priority != other.priority)
+			{
+				return priority < other.priority;
+			}
+			return sequence > other.sequence;
+		}
+	};
+
+	void Enqueue(std::coroutine_handle<> handle, LoadPriority priority, const CancellationToken& token);
+	void Dispatch();
+	void Run(std::coroutine_handle<> handle, bool holds_slot);
+
+	JobSystem& jobs;
+	uint32_t max_in_flight;
+	mutable std::mutex mutex;
+	std::priority_queue<Entry> queue;
+	uint64_t next_sequence;
+	uint32_t in_flight_num;
+};
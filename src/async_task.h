@@ -0,0 +1,266 @@
+#pragma once
+
+#include "job_system.h"
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+#include <vector>
+
+template<typename T>
+class Task;
+
+// Shared by every promise: who resumes whom once the coroutine finishes
+class TaskPromiseBase
+{
+public:
+	enum State : uint32_t
+	{
+		STATE_RUNNING,
+		STATE_AWAITED,
+		STATE_FINISHED,
+	};
+
+	struct FinalAwaiter
+	{
+		bool await_ready() const noexcept { return false; }
+
+		template<typename Promise>
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) const noexcept
+		{
+			// Whoever arrives second resumes the awaiting coroutine
+			TaskPromiseBase& promise = handle.promise();
+			if (promise.state.exchange(STATE_FINISHED, std::memory_order_acq_rel) == STATE_AWAITED)
+			{
+				return promise.continuation;
+			}
+			return std::noop_coroutine();
+		}
+
+		void await_resume() const noexcept {}
+	};
+
+	std::suspend_always initial_suspend() const noexcept { return {}; }
+	FinalAwaiter final_suspend() const noexcept { return {}; }
+	void unhandled_exception() { exception = std::current_exception(); }
+
+	// False when the task had already finished, the awaiting coroutine then continues at once
+	bool SetContinuation(std::coroutine_handle<> awaiting)
+	{
+		continuation = awaiting;
+		uint32_t expected = STATE_RUNNING;
+		return state.compare_exchange_strong(expected, STATE_AWAITED, std::memory_order_acq_rel);
+	}
+
+	bool IsFinished() const { return state.load(std::memory_order_acquire) == STATE_FINISHED; }
+
+protected:
+	std::atomic<uint32_t> state{ STATE_RUNNING };
+	std::coroutine_handle<> continuation;
+	std::exception_ptr exception;
+};
+
+template<typename T>
+class TaskPromise : public TaskPromiseBase
+{
+public:
+	Task<T> get_return_object();
+	void return_value(T result) { value.emplace(std::move(result)); }
+
+	T GetResult()
+	{
+		if (exception)
+		{
+			std::rethrow_exception(exception);
+		}
+		return std::move(*value);
+	}
+
+protected:
+	std::optional<T> value;
+};
+
+template<>
+class TaskPromise<void> : public TaskPromiseBase
+{
+public:
+	Task<void> get_return_object();
+	void return_void() {}
+
+	void GetResult()
+	{
+		if (exception)
+		{
+			std::rethrow_exception(exception);
+		}
+	}
+};
+
+// Lazily started coroutine producing one T. Awaiting a task starts it if
+// needed and resumes the awaiting coroutine wherever the task finishes.
+// A started task has to finish before it is destroyed.
+template<typename T>
+class Task
+{
+public:
+	typedef TaskPromise<T> promise_type;
+
+	Task() : started(false) {}
+	explicit Task(std::coroutine_handle<promise_type> handle) : handle(handle), started(false) {}
+	Task(Task&& other) noexcept : handle(std::exchange(other.handle, nullptr)), started(other.started) {}
+	Task(const Task&) = delete;
+	~Task()
+	{
+		if (handle)
+		{
+			handle.destroy();
+		}
+	}
+
+	Task& operator=(Task&& other) noexcept
+	{
+		if (this != &other)
+		{
+			if (handle)
+			{
+				handle.destroy();
+			}
+			handle = std::exchange(other.handle, nullptr);
+			started = other.started;
+		}
+		return *this;
+	}
+	Task& operator=(const Task&) = delete;
+
+	// Runs the task on the calling thread up to its first suspension
+	void Start()
+	{
+		if (!started)
+		{
+			started = true;
+			handle.resume();
+		}
+	}
+
+	bool IsReady() const { return started && handle.promise().IsFinished(); }
+	T GetResult() { return handle.promise().GetResult(); }
+
+	bool await_ready() const noexcept { return IsReady(); }
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) { return Await(awaiting); }
+	T await_resume() { return GetResult(); }
+
+	// Awaits completion but leaves the result, or exception, in the task
+	struct ReadyAwaiter
+	{
+		Task& task;
+
+		bool await_ready() const noexcept { return task.IsReady(); }
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) { return task.Await(awaiting); }
+		void await_resume() const noexcept {}
+	};
+	ReadyAwaiter WhenReady() { return ReadyAwaiter{ *this }; }
+
+protected:
+	std::coroutine_handle<> Await(std::coroutine_handle<> awaiting)
+	{
+		if (!handle.promise().SetContinuation(awaiting))
+		{
+			return awaiting;
+		}
+		if (!started)
+		{
+			started = true;
+			return handle;
+		}
+		return std::noop_coroutine();
+	}
+
+	std::coroutine_handle<promise_type> handle;
+	bool started;
+};
+
+// Fire and forget coroutine, its frame frees itself on completion
+struct DetachedTask
+{
+	struct promise_type
+	{
+		DetachedTask get_return_object() const noexcept { return {}; }
+		std::suspend_never initial_suspend() const noexcept { return {}; }
+		std::suspend_never final_suspend() const noexcept { return {}; }
+		void return_void() const noexcept {}
+		void unhandled_exception() const noexcept { std::terminate(); }
+	};
+};
+
+template<typename T>
+Task<T> TaskPromise<T>::get_return_object()
+{
+	return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object()
+{
+	return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+// Starts every task before awaiting any, so they run side by side.
+// All of them finish before the first exception is rethrown.
+template<typename T>
+Task<std::vector<T>> WhenAll(std::vector<Task<T>> tasks)
+{
+	for (Task<T>& task : tasks)
+	{
+		task.Start();
+	}
+	std::vector<T> results;
+	results.reserve(tasks.size());
+	std::exception_ptr exception;
+	for (Task<T>& task : tasks)
+	{
+		try
+		{
+			results.push_back(co_await task);
+		}
+		catch (...)
+		{
+			if (!exception)
+			{
+				exception = std::current_exception();
+			}
+		}
+	}
+	if (exception)
+	{
+		std::rethrow_exception(exception);
+	}
+	co_return results;
+}
+
+template<typename T>
+DetachedTask SignalWhenReady(Task<T>& task, std::atomic<bool>& done)
+{
+	co_await task.WhenReady();
+	// Last touch of anything the waiting thread owns
+	done.store(true, std::memory_order_release);
+}
+
+// Blocks a thread outside coroutines until the task is done, running jobs meanwhile.
+// A waiter coroutine signals completion, polling the task itself would race
+// with the worker still leaving the task frame.
+template<typename T>
+T SyncWait(JobSystem& jobs, Task<T>& task)
+{
+	std::atomic<bool> done(false);
+	SignalWhenReady(task, done);
+	jobs.WaitFor([&done] { return done.load(std::memory_order_acquire); });
+	return task.GetResult();
+}
+
+template<typename T>
+T SyncWait(JobSystem& jobs, Task<T>&& task)
+{
+	Task<T> waited = std::move(task);
+	return SyncWait(jobs, waited);
+}
@@ -0,0 +1,51 @@
+#include "bindless_texture_table.h"
+
+BindlessTextureTable::BindlessTextureTable(uint32_t empty_index, uint32_t first_index) :
+	empty_index(empty_index), first_index(first_index)
+{
+}
+
+void BindlessTextureTable::Clear()
+{
+	indices.clear();
+	texture_paths.clear();
+}
+
+void BindlessTextureTable::Reset(uint32_t empty_index, uint32_t first_index)
+{
+	this->empty_index = empty_index;
+	this->first_index = first_index;
+	Clear();
+}
+
+uint32_t BindlessTextureTable::Assign(const std::string& texture_path, bool& is_new)
+{
+	is_new = false;
+	if (texture_path.empty())
+	{
+		return empty_index;
+	}
+
+	auto index = indices.find(texture_path);
+	if (index != indices.end())
+	{
+		return index->second;
+	}
+
+	const uint32_t new_index = first_index + GetTextureNum();
+	indices[texture_path] = new_index;
+	texture_paths.push_back(texture_path);
+	is_new = true;
+	return new_index;
+}
+
+std::vector<uint32_t> BindlessTextureTable::GetMaterialDescriptors() const
+{
+	std::vector<uint32_t> descriptors(1 + GetTextureNum());
+	descriptors[0] = empty_index;
+	for (uint32_t texture = 0; texture < GetTextureNum(); texture++)
+	{
+		descriptors[1 + texture] = first_index + texture;
+	}
+	return descriptors;
+}
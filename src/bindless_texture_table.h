@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Assigns descriptor indices inside the bindless SRV range. Materials that
+// share a texture file share its descriptor, materials without one point
+// at the empty SRV.
+class BindlessTextureTable
+{
+public:
+	explicit BindlessTextureTable(uint32_t empty_index = 0, uint32_t first_index = 1);
+
+	void Clear();
+	// Moves the table to another descriptor range, dropping every assignment
+	void Reset(uint32_t empty_index, uint32_t first_index);
+
+	// Returns the descriptor index for the texture; is_new tells whether a view has to be created
+	uint32_t Assign(const std::string& texture_path, bool& is_new);
+
+	// Dense id of a descriptor index from Assign, 0 for the empty view and 1 + n for the n-th texture
+	uint32_t GetMaterialId(uint32_t descriptor_index) const { return descriptor_index == empty_index ? 0 : descriptor_index - first_index + 1; }
+	// Descriptor index of every material id, what draw keys resolve through
+	std::vector<uint32_t> GetMaterialDescriptors() const;
+
+	uint32_t GetEmptyIndex() const { return empty_index; }
+	uint32_t GetTextureNum() const { return static_cast<uint32_t>(texture_paths.size()); }
+	const std::vector<std::string>& GetTexturePaths() const { return texture_paths; }
+
+protected:
+	uint32_t empty_index;
+	uint32_t first_index;
+	std::unordered_map<std::string, uint32_t> indices;
+	std::vector<std::string> texture_paths;
+};
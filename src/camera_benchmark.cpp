@@ -0,0 +1,144 @@
+#include "camera_benchmark.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+	void WriteJsonString(std::ostream& stream, const std::string& text)
+	{
+		stream << '"';
+		for (char c : text)
+		{
+			if (c == '"' || c == '\\')
+			{
+				stream << '\\';
+			}
+			stream << c;
+		}
+		stream << '"';
+	}
+}
+
+BenchmarkOptions ParseBenchmarkOptions(const std::vector<std::string>& arguments)
+{
+	BenchmarkOptions options;
+	for (size_t i = 0; i < arguments.size(); i++)
+	{
+		const std::string& argument = arguments[i];
+		const bool has_value = i + 1 < arguments.size() && arguments[i + 1].compare(0, 2, "--") != 0;
+		if (argument == "--benchmark")
+		{
+			options.enabled = true;
+			if (has_value)
+			{
+				options.path_file = arguments[++i];
+			}
+		}
+		else if (argument == "--model" && has_value)
+		{
+			options.model_file = arguments[++i];
+		}
+		else if (argument == "--report" && has_value)
+		{
+			options.report_file = arguments[++i];
+		}
+		else if (argument == "--timestep" && has_value)
+		{
+			const float time_step = static_cast<float>(atof(arguments[++i].c_str()));
+			if (time_step > 0.f)
+			{
+				options.time_step = time_step;
+			}
+		}
+	}
+	return options;
+}
+
+CameraBenchmark::CameraBenchmark(CameraPath path, float time_step, uint32_t warmup_frame_num) :
+	path(std::move(path)), time_step(time_step), warmup_frame_num(warmup_frame_num), step_num(0), version(1)
+{
+}
+
+CameraSnapshot CameraBenchmark::Step()
+{
+	step_num++;
+	const CameraKeyframe keyframe = path.Evaluate(GetTime());
+	CameraSnapshot camera = {};
+	camera.eye_position[0] = keyframe.eye_position[0];
+	camera.eye_position[1] = keyframe.eye_position[1];
+	camera.eye_position[2] = keyframe.eye_position[2];
+	camera.angle = keyframe.angle;
+	camera.moving = true;
+	camera.version = ++version;
+	return camera;
+}
+
+void CameraBenchmark::AddFrame(uint64_t frame)
+{
+	if (step_num > warmup_frame_num)
+	{
+		frames.push_back({ frame, GetTime() });
+	}
+}
+
+float CameraBenchmark::GetTime() const
+{
+	// Multiplied rather than accumulated, so long paths do not drift
+	return step_num > warmup_frame_num ? (step_num - warmup_frame_num - 1) * time_step : 0.f;
+}
+
+void CameraBenchmark::WriteReport(std::ostream& stream, const FrameStatistics& statistics, const std::string& model,
+	const BenchmarkMemory& memory) const
+{
+	const std::vector<FrameSample> samples = statistics.GetSamples();
+	// Samples are in frame order, so each benchmark frame is found by binary search
+	auto find_sample = [&samples](uint64_t frame) -> const FrameSample*
+	{
+		auto found = std::lower_bound(samples.begin(), samples.end(), frame,
+			[](const FrameSample& sample, uint64_t value) { return sample.frame < value; });
+		return found != samples.end() && found->frame == frame ? &*found : nullptr;
+	};
+	auto collect = [&](float begin_time, float end_time, bool include_end)
+	{
+		std::vector<FrameSample> segment_samples;
+		for (const BenchmarkFrame& frame : frames)
+		{
+			const bool inside = frame.time >= begin_time && (frame.time < end_time || (include_end && frame.time <= end_time));
+			const FrameSample* sample = inside ? find_sample(frame.frame) : nullptr;
+			if (sample)
+			{
+				segment_samples.push_back(*sample);
+			}
+		}
+		return segment_samples;
+	};
+
+	char number[64];
+	stream << "{\"model\":";
+	WriteJsonString(stream, model);
+	snprintf(number, sizeof(number), "%.6f", time_step);
+	stream << ",\"time_step\":" << number;
+	stream << ",\"warmup_frames\":" << warmup_frame_num;
+	stream << ",\"frames\":" << frames.size();
+	stream << ",\"upload_ring\":{\"size\":" << memory.upload_ring_size <<
+		",\"high_water_mark\":" << memory.upload_ring_high_water_mark << "}";
+	stream << ",\n\"total\":";
+	FrameStatistics::WriteJson(stream, FrameStatistics::Summarize(collect(0.f, path.GetDuration(), true)));
+	stream << ",\n\"segments\":[";
+	const std::vector<CameraPathSegment> segments = path.GetSegments();
+	for (size_t i = 0; i < segments.size(); i++)
+	{
+		const CameraPathSegment& segment = segments[i];
+		stream << (i > 0 ? ",\n" : "\n") << "{\"name\":";
+		WriteJsonString(stream, segment.name);
+		snprintf(number, sizeof(number), ",\"begin\":%.3f,\"end\":%.3f", segment.begin_time, segment.end_time);
+		stream << number << ",\"statistics\":";
+		// The last segment keeps the final frame at the path end
+		const bool include_end = segment.end_time >= path.GetDuration();
+		FrameStatistics::WriteJson(stream, FrameStatistics::Summarize(collect(segment.begin_time, segment.end_time, include_end)));
+		stream << "}";
+	}
+	stream << "\n]}\n";
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "camera_controller.h"
+#include "camera_path.h"
+#include "frame_statistics.h"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Command line of a benchmark run:
+//   --benchmark [camera path file]  play a path, the built-in orbit without a file
+//   --model <obj file>              model to load instead of the default
+//   --report <json file>            where the report goes
+//   --timestep <seconds>            path time advanced per frame
+struct BenchmarkOptions
+{
+	bool enabled = false;
+	std::string path_file;
+	std::string model_file;
+	std::string report_file;
+	float time_step = 1.f / 60.f;
+};
+
+// Peak memory use of the run, reported next to the frame statistics
+struct BenchmarkMemory
+{
+	uint64_t upload_ring_size = 0;
+	uint64_t upload_ring_high_water_mark = 0;
+};
+
+// Unknown arguments are skipped, the window build has no other options
+BenchmarkOptions ParseBenchmarkOptions(const std::vector<std::string>& arguments);
+
+// Plays a camera path with a fixed time step per frame, so a run renders the
+// same camera sequence however fast the machine is, and reports frame
+// statistics per path segment. Warm-up frames hold the first keyframe while
+// pipelines and caches settle and are not reported.
+class CameraBenchmark
+{
+public:
+	CameraBenchmark(CameraPath path = CameraPath(), float time_step = 1.f / 60.f, uint32_t warmup_frame_num = 60);
+
+	// Camera of the next frame, call once per rendered frame
+	CameraSnapshot Step();
+	// Ties a frame statistics id to the path time of the last step
+	void AddFrame(uint64_t frame);
+	// True once the next step would pass the path end
+	bool IsFinished() const { return step_num > warmup_frame_num && GetTime() + time_step > path.GetDuration(); }
+
+	float GetTime() const;
+	uint32_t GetStepNum() const { return step_num; }
+	// Frames the statistics ring must still hold when the report is written
+	uint32_t GetReportedFrameNum() const { return static_cast<uint32_t>(frames.size()); }
+
+	// Machine-readable report, one statistics object per segment and one for the whole path.
+	// The path must fit in the statistics ring, frames that left it are missing from the report.
+	void WriteReport(std::ostream& stream, const FrameStatistics& statistics, const std::string& model,
+		const BenchmarkMemory& memory = BenchmarkMemory()) const;
+
+protected:
+	struct BenchmarkFrame
+	{
+		uint64_t frame;
+		float time;
+	};
+
+	CameraPath path;
+	float time_step;
+	uint32_t warmup_frame_num;
+	uint32_t step_num;
+	uint64_t version;
+	std::vector<BenchmarkFrame> frames;
+};
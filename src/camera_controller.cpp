@@ -0,0 +1,74 @@
+#include "camera_controller.h"
+
+#include <algorithm>
+#include <cmath>
+
+CameraController::CameraController(float x, float y, float z, float angle) :
+	delta_forward(0.f), delta_rotation(0.f)
+{
+	snapshot.eye_position[0] = x;
+	snapshot.eye_position[1] = y;
+	snapshot.eye_position[2] = z;
+	snapshot.angle = angle;
+	snapshot.moving = false;
+	snapshot.version = 1;
+}
+
+void CameraController::OnKeyDown(uint8_t key)
+{
+	switch (key)
+	{
+	case 'D':
+		delta_rotation = 1.f;
+		break;
+	case 'A':
+		delta_rotation = -1.f;
+		break;
+	case 'W':
+		delta_forward = 1.f;
+		break;
+	case 'S':
+		delta_forward = -1.f;
+		break;
+	default:
+		break;
+	}
+}
+
+void CameraController::OnKeyUp(uint8_t key)
+{
+	switch (key)
+	{
+	case 'D':
+	case 'A':
+		delta_rotation = 0.f;
+		break;
+	case 'W':
+	case 'S':
+		delta_forward = 0.f;
+		break;
+	default:
+		break;
+	}
+}
+
+bool CameraController::Update(float time_passed)
+{
+	const bool was_moving = snapshot.moving;
+	snapshot.moving = IsMoving();
+	if (!snapshot.moving)
+	{
+		if (was_moving)
+		{
+			snapshot.version++;
+		}
+		return was_moving;
+	}
+
+	time_passed = std::min(time_passed, max_update_time);
+	snapshot.angle += delta_rotation * time_passed;
+	snapshot.eye_position[0] += std::sin(snapshot.angle) * delta_forward * time_passed;
+	snapshot.eye_position[2] += std::cos(snapshot.angle) * delta_forward * time_passed;
+	snapshot.version++;
+	return true;
+}
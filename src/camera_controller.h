@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+
+// Camera state handed from the window thread to the render thread
+struct CameraSnapshot
+{
+	float eye_position[3];
+	float angle;
+	bool moving;
+	// Changes whenever the camera state does
+	uint64_t version;
+};
+
+// Walk camera driven by WASD: W/S move along the view direction, A/D turn.
+// Lives on the window thread so input is applied however long frames take.
+class CameraController
+{
+public:
+	CameraController(float x = 0.f, float y = 1.f, float z = -5.f, float angle = 0.f);
+
+	// Key codes are the upper case letters, as in Win32 virtual keys
+	void OnKeyDown(uint8_t key);
+	void OnKeyUp(uint8_t key);
+
+	// Integrates the motion, returns true if the snapshot changed
+	bool Update(float time_passed);
+
+	bool IsMoving() const { return delta_forward != 0.f || delta_rotation != 0.f; }
+	const CameraSnapshot& GetSnapshot() const { return snapshot; }
+
+	// Longest step integrated at once, a stalled thread would jump the camera otherwise
+	static constexpr float max_update_time = 0.1f;
+
+protected:
+	CameraSnapshot snapshot;
+	float delta_forward;
+	float delta_rotation;
+};
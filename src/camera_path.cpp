@@ -0,0 +1,140 @@
+#include "camera_path.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace
+{
+	float CatmullRom(float p0, float p1, float p2, float p3, float t)
+	{
+		const float t2 = t * t;
+		const float t3 = t2 * t;
+		return 0.5f * (2.f * p1 + (p2 - p0) * t + (2.f * p0 - 5.f * p1 + 4.f * p2 - p3) * t2 + (3.f * p1 - p0 - 3.f * p2 + p3) * t3);
+	}
+}
+
+bool CameraPath::Load(std::istream& stream)
+{
+	keyframes.clear();
+	segments.clear();
+
+	std::string line;
+	while (std::getline(stream, line))
+	{
+		line = line.substr(0, line.find('#'));
+		std::istringstream entry(line);
+		std::string type;
+		if (!(entry >> type))
+		{
+			continue;
+		}
+		if (type == "key")
+		{
+			CameraKeyframe keyframe = {};
+			if (!(entry >> keyframe.time >> keyframe.eye_position[0] >> keyframe.eye_position[1] >> keyframe.eye_position[2] >> keyframe.angle))
+			{
+				return false;
+			}
+			if (!keyframes.empty() && keyframe.time <= keyframes.back().time)
+			{
+				return false;
+			}
+			keyframes.push_back(keyframe);
+		}
+		else if (type == "segment")
+		{
+			CameraPathSegment segment;
+			if (!(entry >> segment.name >> segment.begin_time >> segment.end_time) || segment.end_time < segment.begin_time)
+			{
+				return false;
+			}
+			segments.push_back(segment);
+		}
+		else
+		{
+			return false;
+		}
+	}
+	return !keyframes.empty();
+}
+
+CameraKeyframe CameraPath::Evaluate(float time) const
+{
+	if (keyframes.empty())
+	{
+		return CameraKeyframe{ time, { 0.f, 0.f, 0.f }, 0.f };
+	}
+	if (time <= keyframes.front().time || keyframes.size() == 1)
+	{
+		CameraKeyframe result = keyframes.front();
+		result.time = time;
+		return result;
+	}
+	if (time >= keyframes.back().time)
+	{
+		CameraKeyframe result = keyframes.back();
+		result.time = time;
+		return result;
+	}
+
+	// Keyframe i starts the span holding the time, its neighbours are clamped at the ends
+	const size_t next = std::upper_bound(keyframes.begin(), keyframes.end(), time,
+		[](float value, const CameraKeyframe& keyframe) { return value < keyframe.time; }) - keyframes.begin();
+	const size_t i = next - 1;
+	const CameraKeyframe& k0 = keyframes[i > 0 ? i - 1 : i];
+	const CameraKeyframe& k1 = keyframes[i];
+	const CameraKeyframe& k2 = keyframes[next];
+	const CameraKeyframe& k3 = keyframes[std::min(next + 1, keyframes.size() - 1)];
+	const float t = (time - k1.time) / (k2.time - k1.time);
+
+	CameraKeyframe result = {};
+	result.time = time;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		result.eye_position[axis] = CatmullRom(k0.eye_position[axis], k1.eye_position[axis], k2.eye_position[axis], k3.eye_position[axis], t);
+	}
+	result.angle = CatmullRom(k0.angle, k1.angle, k2.angle, k3.angle, t);
+	return result;
+}
+
+std::vector<CameraPathSegment> CameraPath::GetSegments() const
+{
+	if (segments.empty())
+	{
+		return { CameraPathSegment{ "path", 0.f, GetDuration() } };
+	}
+	return segments;
+}
+
+CameraPath CameraPath::MakeOrbit(float far_radius, float near_radius, float height)
+{
+	// The camera looks along (sin angle, cos angle), so sitting at -(sin, cos) * radius faces the origin
+	const float pi = 3.14159265f;
+	CameraPath path;
+	auto add_key = [&](float time, float radius, float angle)
+	{
+		path.AddKeyframe({ time, { -std::sin(angle) * radius, height, -std::cos(angle) * radius }, angle });
+	};
+
+	// A full circle far out, one keyframe per eighth
+	for (int step = 0; step <= 8; step++)
+	{
+		add_key(step * 1.f, far_radius, step * pi / 4.f);
+	}
+	// Straight in at the start angle
+	for (int step = 1; step <= 4; step++)
+	{
+		add_key(8.f + step * 1.f, far_radius + (near_radius - far_radius) * step / 4.f, 2.f * pi);
+	}
+	// Half a circle close up
+	for (int step = 1; step <= 4; step++)
+	{
+		add_key(12.f + step * 1.f, near_radius, 2.f * pi + step * pi / 4.f);
+	}
+
+	path.AddSegment({ "orbit_far", 0.f, 8.f });
+	path.AddSegment({ "approach", 8.f, 12.f });
+	path.AddSegment({ "orbit_near", 12.f, 16.f });
+	return path;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <istream>
+#include <string>
+#include <vector>
+
+struct CameraKeyframe
+{
+	float time;
+	float eye_position[3];
+	float angle;
+};
+
+// Named time range of a path, benchmark statistics are reported per segment
+struct CameraPathSegment
+{
+	std::string name;
+	float begin_time;
+	float end_time;
+};
+
+// Camera spline through keyframes, Catmull-Rom on position and angle so the
+// motion has no kinks at keyframes. Sampling depends only on the time, which
+// makes playback with a fixed step identical from run to run.
+class CameraPath
+{
+public:
+	// Text format, one entry per line, '#' starts a comment:
+	//   key <time> <x> <y> <z> <angle>
+	//   segment <name> <begin time> <end time>
+	// Keyframes must be in increasing time order
+	bool Load(std::istream& stream);
+
+	void AddKeyframe(const CameraKeyframe& keyframe) { keyframes.push_back(keyframe); }
+	void AddSegment(const CameraPathSegment& segment) { segments.push_back(segment); }
+
+	// Position and angle at a time, clamped to the path ends
+	CameraKeyframe Evaluate(float time) const;
+
+	float GetDuration() const { return keyframes.empty() ? 0.f : keyframes.back().time; }
+	const std::vector<CameraKeyframe>& GetKeyframes() const { return keyframes; }
+	// Falls back to a single segment over the whole path when none were given
+	std::vector<CameraPathSegment> GetSegments() const;
+
+	// Orbits the origin far out, moves in and orbits close, facing the origin throughout
+	static CameraPath MakeOrbit(float far_radius = 5.f, float near_radius = 2.f, float height = 1.f);
+
+protected:
+	std::vector<CameraKeyframe> keyframes;
+	std::vector<CameraPathSegment> segments;
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "draw_packet.h"
+#include "render_graph.h"
+
+#include <cstdint>
+
+// Backend-neutral command stream of a frame. The renderer records through
+// D3D12CommandRecorder, headless runs through NullCommandList. Resources are
+// render graph ids, descriptors are indices into the shader-visible heap and
+// draws are the draw ids of the packet stream.
+class CommandRecorder : public DrawCommandSink
+{
+public:
+	virtual void Barriers(const RenderGraphBarrier* barriers, uint32_t barrier_num) = 0;
+	virtual void ClearRenderTarget(uint32_t resource) = 0;
+	virtual void ClearDepthStencil(uint32_t resource) = 0;
+	// Binds the attachments and the start of the texture table material indices point into
+	virtual void BeginDraws(uint32_t render_target, uint32_t depth_stencil, uint32_t descriptor_table) = 0;
+
+	// One barrier call for a batch of the graph, nothing for an empty batch
+	void RecordBatch(const RenderGraph& graph, uint32_t batch)
+	{
+		const std::vector<RenderGraphBarrier>& barriers = graph.GetBarriers(batch);
+		if (!barriers.empty())
+		{
+			Barriers(barriers.data(), static_cast<uint32_t>(barriers.size()));
+		}
+	}
+};
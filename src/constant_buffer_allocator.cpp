@@ -0,0 +1,55 @@
+#include "constant_buffer_allocator.h"
+
+ConstantBufferAllocator::ConstantBufferAllocator() : constant_buffer_data_begin(nullptr)
+{
+}
+
+ConstantBufferAllocator::~ConstantBufferAllocator()
+{
+	Destroy();
+}
+
+void ConstantBufferAllocator::Create(ID3D12Device* device, UINT64 size)
+{
+	ThrowIfFailed(device->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(size),
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&constant_buffer)));
+	constant_buffer->SetName(L"Frame constant buffer");
+
+	CD3DX12_RANGE read_range(0, 0);
+	ThrowIfFailed(constant_buffer->Map(0, &read_range, reinterpret_cast<void**>(&constant_buffer_data_begin)));
+
+	allocator.Reset(size);
+}
+
+void ConstantBufferAllocator::Destroy()
+{
+	if (constant_buffer && constant_buffer_data_begin)
+	{
+		constant_buffer->Unmap(0, nullptr);
+	}
+	constant_buffer_data_begin = nullptr;
+	constant_buffer.Reset();
+	allocator.Reset(0);
+}
+
+void ConstantBufferAllocator::Reset()
+{
+	allocator.Reset();
+}
+
+D3D12_GPU_VIRTUAL_ADDRESS ConstantBufferAllocator::Allocate(const void* data, UINT64 size)
+{
+	const UINT64 offset = allocator.Allocate(size, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+	if (offset == LinearAllocator::invalid_offset)
+	{
+		ThrowIfFailed(E_OUTOFMEMORY);
+	}
+
+	memcpy(constant_buffer_data_begin + offset, data, static_cast<size_t>(size));
+	return constant_buffer->GetGPUVirtualAddress() + offset;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "dx12_labs.h"
+#include "linear_allocator.h"
+
+// Persistently mapped upload buffer handing out CBV-aligned slices for one
+// frame. The owner resets it once the frame fence has retired.
+class ConstantBufferAllocator
+{
+public:
+	ConstantBufferAllocator();
+	~ConstantBufferAllocator();
+
+	void Create(ID3D12Device* device, UINT64 size);
+	void Destroy();
+	void Reset();
+
+	D3D12_GPU_VIRTUAL_ADDRESS Allocate(const void* data, UINT64 size);
+
+	template<typename T>
+	D3D12_GPU_VIRTUAL_ADDRESS Allocate(const T& data)
+	{
+		return Allocate(&data, sizeof(T));
+	}
+
+	ID3D12Resource* GetResource() const { return constant_buffer.Get(); }
+	UINT64 GetOffset(D3D12_GPU_VIRTUAL_ADDRESS address) const { return address - constant_buffer->GetGPUVirtualAddress(); }
+	UINT64 GetHighWaterMark() const { return allocator.GetHighWaterMark(); }
+
+protected:
+	ComPtr<ID3D12Resource> constant_buffer;
+	UINT8* constant_buffer_data_begin;
+	LinearAllocator allocator;
+};
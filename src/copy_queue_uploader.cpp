@@ -0,0 +1,158 @@
+#include "copy_queue_uploader.h"
+
+CopyQueueUploader::CopyQueueUploader() : fence_event(nullptr), scheduler(*this)
+{
+}
+
+CopyQueueUploader::~CopyQueueUploader()
+{
+	Destroy();
+}
+
+void CopyQueueUploader::Create(ID3D12Device* device, ID3D12CommandQueue* direct_queue, UINT64 ring_size)
+{
+	this->device = device;
+	this->direct_queue = direct_queue;
+
+	D3D12_COMMAND_QUEUE_DESC queue_descriptor = {};
+	queue_descriptor.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+	queue_descriptor.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+	ThrowIfFailed(device->CreateCommandQueue(&queue_descriptor, IID_PPV_ARGS(&copy_queue)));
+	copy_queue->SetName(L"Copy queue");
+
+	ThrowIfFailed(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence)));
+	fence_event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+	if (fence_event == nullptr)
+	{
+		ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+	}
+
+	upload_ring.Create(device, ring_size);
+}
+
+void CopyQueueUploader::Destroy()
+{
+	if (copy_queue)
+	{
+		WaitForIdle();
+	}
+	if (fence_event)
+	{
+		CloseHandle(fence_event);
+		fence_event = nullptr;
+	}
+	region_releases.Flush();
+	upload_ring.Destroy();
+	command_list.Reset();
+	command_allocators.clear();
+	fence.Reset();
+	copy_queue.Reset();
+	direct_queue.Reset();
+	device.Reset();
+}
+
+void CopyQueueUploader::UploadBuffer(ID3D12Resource* destination, const void* data, UINT64 size)
+{
+	BeginBatch();
+	if (!upload_ring.UploadBuffer(command_list.Get(), destination, data, size))
+	{
+		// The ring is full of pending copies, drain it and try again
+		WaitForFence(Submit());
+		BeginBatch();
+		if (!upload_ring.UploadBuffer(command_list.Get(), destination, data, size))
+		{
+			ThrowIfFailed(E_OUTOFMEMORY);
+		}
+	}
+}
+
+void CopyQueueUploader::UploadTexture(ID3D12Resource* destination, const D3D12_SUBRESOURCE_DATA& data)
+{
+	BeginBatch();
+	if (!upload_ring.UploadTexture(command_list.Get(), destination, data))
+	{
+		WaitForFence(Submit());
+		BeginBatch();
+		if (!upload_ring.UploadTexture(command_list.Get(), destination, data))
+		{
+			ThrowIfFailed(E_OUTOFMEMORY);
+		}
+	}
+}
+
+UINT64 CopyQueueUploader::Submit()
+{
+	if (!scheduler.IsBatchOpen())
+	{
+		return scheduler.GetLastSubmittedValue();
+	}
+
+	ThrowIfFailed(command_list->Close());
+	ID3D12CommandList* command_lists[] = { command_list.Get() };
+	copy_queue->ExecuteCommandLists(_countof(command_lists), command_lists);
+
+	const UINT64 fence_value = scheduler.SubmitBatch();
+	const UINT64 region_size = upload_ring.GetOpenRegionSize();
+	upload_ring.FinishRegion(fence_value);
+	region_releases.Release(fence_value, [this, fence_value]() { upload_ring.Retire(fence_value); }, region_size);
+	return fence_value;
+}
+
+void CopyQueueUploader::WaitForIdle()
+{
+	WaitForFence(Submit());
+}
+
+void CopyQueueUploader::SignalCopy(uint64_t fence_value)
+{
+	ThrowIfFailed(copy_queue->Signal(fence.Get(), fence_value));
+}
+
+void CopyQueueUploader::WaitForCopyOnDirect(uint64_t fence_value)
+{
+	ThrowIfFailed(direct_queue->Wait(fence.Get(), fence_value));
+}
+
+uint64_t CopyQueueUploader::GetCompletedCopyValue() const
+{
+	return fence->GetCompletedValue();
+}
+
+void CopyQueueUploader::BeginBatch()
+{
+	if (scheduler.IsBatchOpen())
+	{
+		return;
+	}
+
+	region_releases.Retire(fence->GetCompletedValue());
+
+	const uint32_t allocator_index = scheduler.BeginBatch();
+	if (allocator_index == command_allocators.size())
+	{
+		ComPtr<ID3D12CommandAllocator> command_allocator;
+		ThrowIfFailed(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&command_allocator)));
+		command_allocators.push_back(command_allocator);
+	}
+	ID3D12CommandAllocator* command_allocator = command_allocators[allocator_index].Get();
+
+	if (!command_list)
+	{
+		ThrowIfFailed(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, command_allocator,
+			nullptr, IID_PPV_ARGS(&command_list)));
+		command_list->SetName(L"Copy command list");
+		return;
+	}
+	ThrowIfFailed(command_allocator->Reset());
+	ThrowIfFailed(command_list->Reset(command_allocator, nullptr));
+}
+
+void CopyQueueUploader::WaitForFence(UINT64 fence_value)
+{
+	if (fence->GetCompletedValue() < fence_value)
+	{
+		ThrowIfFailed(fence->SetEventOnCompletion(fence_value, fence_event));
+		WaitForSingleObject(fence_event, INFINITE);
+	}
+	region_releases.Retire(fence->GetCompletedValue());
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "dx12_labs.h"
+#include "deferred_release_queue.h"
+#include "upload_ring_buffer.h"
+#include "upload_scheduler.h"
+
+// Records CPU -> GPU copies on a dedicated copy queue so transfers overlap
+// with rendering. Destination resources must be created in COMMON state:
+// they decay back to COMMON after the copy and get promoted implicitly on
+// first use on the direct queue.
+class CopyQueueUploader : public QueueSync
+{
+public:
+	CopyQueueUploader();
+	~CopyQueueUploader();
+
+	void Create(ID3D12Device* device, ID3D12CommandQueue* direct_queue, UINT64 ring_size);
+	void Destroy();
+
+	void UploadBuffer(ID3D12Resource* destination, const void* data, UINT64 size);
+	void UploadTexture(ID3D12Resource* destination, const D3D12_SUBRESOURCE_DATA& data);
+	UINT64 Submit();
+
+	// Make the next direct queue submission wait for this upload fence value
+	void RequireUpload(UINT64 fence_value) { scheduler.RequireUpload(fence_value); }
+	void InsertWaits() { scheduler.InsertWaits(); }
+	void WaitForIdle();
+	bool IsUploadComplete(UINT64 fence_value) const { return scheduler.IsComplete(fence_value); }
+
+	UINT64 GetRingSize() const { return upload_ring.GetSize(); }
+	// Most ring bytes ever in flight at once, tells whether the ring is sized right
+	UINT64 GetRingHighWaterMark() const { return upload_ring.GetHighWaterMark(); }
+
+	void SignalCopy(uint64_t fence_value) override;
+	void WaitForCopyOnDirect(uint64_t fence_value) override;
+	uint64_t GetCompletedCopyValue() const override;
+
+protected:
+	void BeginBatch();
+	void WaitForFence(UINT64 fence_value);
+
+	ComPtr<ID3D12Device> device;
+	ComPtr<ID3D12CommandQueue> copy_queue;
+	ComPtr<ID3D12CommandQueue> direct_queue;
+	std::vector<ComPtr<ID3D12CommandAllocator>> command_allocators;
+	ComPtr<ID3D12GraphicsCommandList> command_list;
+	ComPtr<ID3D12Fence> fence;
+	HANDLE fence_event;
+
+	UploadRingBuffer upload_ring;
+	// Ring regions wait here for the copy fence value of their batch
+	DeferredReleaseQueue region_releases;
+	UploadScheduler scheduler;
+};
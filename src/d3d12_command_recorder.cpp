@@ -0,0 +1,94 @@
+#include "d3d12_command_recorder.h"
+
+#include <model_loader.h>
+
+D3D12CommandRecorder::D3D12CommandRecorder(ID3D12GraphicsCommandList* list, const D3D12RecordingContext& context,
+	const std::vector<D3D12_GPU_VIRTUAL_ADDRESS>* draw_constants) :
+	list(list), context(context), draw_constants(draw_constants)
+{
+}
+
+void D3D12CommandRecorder::Barriers(const RenderGraphBarrier* graph_barriers, uint32_t barrier_num)
+{
+	// One call per batch, the runtime handles the whole set at once
+	const std::vector<ID3D12Resource*>& resources = *context.resources;
+	std::vector<D3D12_RESOURCE_BARRIER> barriers;
+	barriers.reserve(barrier_num);
+	for (uint32_t barrier = 0; barrier < barrier_num; barrier++)
+	{
+		const RenderGraphBarrier& graph_barrier = graph_barriers[barrier];
+		ID3D12Resource* resource = resources[graph_barrier.resource];
+		if (graph_barrier.type == RenderGraphBarrier::TYPE_UAV)
+		{
+			barriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(resource));
+			continue;
+		}
+		if (graph_barrier.type == RenderGraphBarrier::TYPE_ALIASING)
+		{
+			ID3D12Resource* aliased_resource = graph_barrier.aliased_resource == RenderGraphBarrier::any_resource ?
+				nullptr : resources[graph_barrier.aliased_resource];
+			barriers.push_back(CD3DX12_RESOURCE_BARRIER::Aliasing(aliased_resource, resource));
+			continue;
+		}
+		D3D12_RESOURCE_BARRIER_FLAGS flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+		if (graph_barrier.type == RenderGraphBarrier::TYPE_BEGIN_ONLY)
+		{
+			flags = D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY;
+		}
+		else if (graph_barrier.type == RenderGraphBarrier::TYPE_END_ONLY)
+		{
+			flags = D3D12_RESOURCE_BARRIER_FLAG_END_ONLY;
+		}
+		barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(
+			resource,
+			static_cast<D3D12_RESOURCE_STATES>(graph_barrier.state_before),
+			static_cast<D3D12_RESOURCE_STATES>(graph_barrier.state_after),
+			D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES,
+			flags));
+	}
+	list->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
+}
+
+void D3D12CommandRecorder::ClearRenderTarget(uint32_t resource)
+{
+	const float clear_color[] = { 0.f, 0.f, 0.f, 1.f };
+	list->ClearRenderTargetView((*context.views)[resource], clear_color, 0, nullptr);
+}
+
+void D3D12CommandRecorder::ClearDepthStencil(uint32_t resource)
+{
+	list->ClearDepthStencilView((*context.views)[resource], D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
+}
+
+void D3D12CommandRecorder::BeginDraws(uint32_t render_target, uint32_t depth_stencil, uint32_t descriptor_table)
+{
+	const D3D12_CPU_DESCRIPTOR_HANDLE rtv_handle = (*context.views)[render_target];
+	const D3D12_CPU_DESCRIPTOR_HANDLE dsv_handle = (*context.views)[depth_stencil];
+	list->OMSetRenderTargets(1, &rtv_handle, FALSE, &dsv_handle);
+	list->SetGraphicsRootDescriptorTable(texture_table_parameter, context.descriptor_heap->GetGpuHandle(descriptor_table));
+}
+
+void D3D12CommandRecorder::SetPass(uint32_t pass)
+{
+	// Render targets are bound per list, there is a single pass
+}
+
+void D3D12CommandRecorder::SetPipeline(uint32_t pipeline)
+{
+	list->SetPipelineState(context.pipeline_state);
+}
+
+void D3D12CommandRecorder::SetMaterial(uint32_t material)
+{
+	list->SetGraphicsRoot32BitConstant(texture_index_parameter, (*context.material_descriptors)[material], 0);
+}
+
+void D3D12CommandRecorder::Draw(uint32_t draw_id)
+{
+	if (draw_constants)
+	{
+		list->SetGraphicsRootConstantBufferView(draw_constants_parameter, (*draw_constants)[draw_id]);
+	}
+	DrawCallParams params = context.model_loader->GetDrawCallParams(draw_id);
+	list->DrawIndexedInstanced(params.index_num, 1, params.start_index, params.start_vertex, 0);
+}
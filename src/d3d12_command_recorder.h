@@ -0,0 +1,50 @@
+#pragma once
+
+#include "dx12_labs.h"
+#include "command_recorder.h"
+#include "descriptor_heap_manager.h"
+
+class ModelLoader;
+
+// What graph ids, descriptor indices and draw ids resolve to on the device
+struct D3D12RecordingContext
+{
+	// Indexed by graph resource id, views are RTVs or DSVs matching the resource
+	const std::vector<ID3D12Resource*>* resources;
+	const std::vector<D3D12_CPU_DESCRIPTOR_HANDLE>* views;
+	const DescriptorHeapManager* descriptor_heap;
+	// Descriptor index of every draw key material id, relative to the bound table
+	const std::vector<UINT>* material_descriptors;
+	ID3D12PipelineState* pipeline_state;
+	const ModelLoader* model_loader;
+};
+
+// Records into a command list or bundle. Bundles only take the draw stream.
+class D3D12CommandRecorder : public CommandRecorder
+{
+public:
+	// Root parameters the recorder binds, see Renderer::LoadAssets
+	static const UINT texture_table_parameter = 1;
+	static const UINT draw_constants_parameter = 2;
+	static const UINT texture_index_parameter = 3;
+
+	// With draw_constants, each draw binds the slice of its draw id. Without, draws keep
+	// the slice bound by the calling list, as bundles recorded once must.
+	D3D12CommandRecorder(ID3D12GraphicsCommandList* list, const D3D12RecordingContext& context,
+		const std::vector<D3D12_GPU_VIRTUAL_ADDRESS>* draw_constants = nullptr);
+
+	void Barriers(const RenderGraphBarrier* barriers, uint32_t barrier_num) override;
+	void ClearRenderTarget(uint32_t resource) override;
+	void ClearDepthStencil(uint32_t resource) override;
+	void BeginDraws(uint32_t render_target, uint32_t depth_stencil, uint32_t descriptor_table) override;
+
+	void SetPass(uint32_t pass) override;
+	void SetPipeline(uint32_t pipeline) override;
+	void SetMaterial(uint32_t material) override;
+	void Draw(uint32_t draw_id) override;
+
+protected:
+	ID3D12GraphicsCommandList* list;
+	const D3D12RecordingContext& context;
+	const std::vector<D3D12_GPU_VIRTUAL_ADDRESS>* draw_constants;
+};
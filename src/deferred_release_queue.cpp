@@ -0,0 +1,46 @@
+#include "deferred_release_queue.h"
+
+#include <utility>
+
+DeferredReleaseQueue::DeferredReleaseQueue() : recording_fence_value(0), pending_size(0)
+{
+}
+
+void DeferredReleaseQueue::Release(uint64_t fence_value, std::function<void()> release, uint64_t size)
+{
+	PendingRelease pending = { fence_value, size, std::move(release) };
+	releases.push_back(std::move(pending));
+	pending_size += size;
+}
+
+uint64_t DeferredReleaseQueue::Retire(uint64_t completed_fence_value)
+{
+	// Completed entries are taken out first, a release may queue new ones
+	std::deque<PendingRelease> completed;
+	for (auto pending = releases.begin(); pending != releases.end();)
+	{
+		if (pending->fence_value <= completed_fence_value)
+		{
+			completed.push_back(std::move(*pending));
+			pending = releases.erase(pending);
+		}
+		else
+		{
+			++pending;
+		}
+	}
+
+	uint64_t freed_size = 0;
+	for (PendingRelease& pending : completed)
+	{
+		pending.release();
+		freed_size += pending.size;
+	}
+	pending_size -= freed_size;
+	return freed_size;
+}
+
+uint64_t DeferredReleaseQueue::Flush()
+{
+	return Retire(~0ull);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+
+// Defers destruction until the GPU is done with an object. Every release is
+// tagged with a fence value and runs once Retire sees that value completed,
+// so replacing a resource never needs a full GPU flush. Objects are kept
+// alive by the release function itself, captured by value.
+class DeferredReleaseQueue
+{
+public:
+	DeferredReleaseQueue();
+
+	// Fence value the next submission signals, untagged releases wait for it
+	void SetRecordingFenceValue(uint64_t fence_value) { recording_fence_value = fence_value; }
+	uint64_t GetRecordingFenceValue() const { return recording_fence_value; }
+
+	void Release(uint64_t fence_value, std::function<void()> release, uint64_t size = 0);
+	void Release(std::function<void()> release, uint64_t size = 0) { Release(recording_fence_value, std::move(release), size); }
+
+	// Holds a copy of the object, a COM reference for example, until the fence passes
+	template<typename T>
+	void ReleaseObject(T object, uint64_t size = 0)
+	{
+		Release([object]() {}, size);
+	}
+
+	// Runs every release whose fence value completed and returns the bytes freed
+	uint64_t Retire(uint64_t completed_fence_value);
+	// Runs everything, for after a full GPU flush
+	uint64_t Flush();
+
+	uint64_t GetPendingSize() const { return pending_size; }
+	size_t GetPendingNum() const { return releases.size(); }
+
+protected:
+	struct PendingRelease
+	{
+		uint64_t fence_value;
+		uint64_t size;
+		std::function<void()> release;
+	};
+
+	uint64_t recording_fence_value;
+	uint64_t pending_size;
+	// Tagged in nondecreasing fence order in practice, Retire does not rely on it
+	std::deque<PendingRelease> releases;
+};
@@ -0,0 +1,116 @@
+#include "descriptor_allocator.h"
+
+#include <algorithm>
+
+DescriptorFreeList::DescriptorFreeList() : size(0), allocated_num(0)
+{
+}
+
+DescriptorFreeList::DescriptorFreeList(uint32_t size) : size(0), allocated_num(0)
+{
+	Reset(size);
+}
+
+void DescriptorFreeList::Reset(uint32_t size)
+{
+	this->size = size;
+	allocated_num = 0;
+	free_ranges.clear();
+	if (size > 0)
+	{
+		free_ranges[0] = size;
+	}
+}
+
+void DescriptorFreeList::Grow(uint32_t new_size)
+{
+	if (new_size <= size)
+	{
+		return;
+	}
+	const uint32_t old_size = size;
+	size = new_size;
+	AddFreeRange(old_size, new_size - old_size);
+}
+
+uint32_t DescriptorFreeList::Allocate(uint32_t count)
+{
+	if (count == 0)
+	{
+		return invalid_index;
+	}
+	for (auto range = free_ranges.begin(); range != free_ranges.end(); ++range)
+	{
+		if (range->second < count)
+		{
+			continue;
+		}
+		const uint32_t first = range->first;
+		const uint32_t remaining = range->second - count;
+		free_ranges.erase(range);
+		if (remaining > 0)
+		{
+			free_ranges[first + count] = remaining;
+		}
+		allocated_num += count;
+		return first;
+	}
+	return invalid_index;
+}
+
+void DescriptorFreeList::Free(uint32_t first, uint32_t count)
+{
+	if (count == 0)
+	{
+		return;
+	}
+	allocated_num -= count;
+	AddFreeRange(first, count);
+}
+
+void DescriptorFreeList::AddFreeRange(uint32_t first, uint32_t count)
+{
+	auto next = free_ranges.lower_bound(first);
+	if (next != free_ranges.end() && first + count == next->first)
+	{
+		count += next->second;
+		next = free_ranges.erase(next);
+	}
+	if (next != free_ranges.begin())
+	{
+		auto previous = std::prev(next);
+		if (previous->first + previous->second == first)
+		{
+			previous->second += count;
+			return;
+		}
+	}
+	free_ranges[first] = count;
+}
+
+uint32_t DescriptorFreeList::GetLargestFreeRange() const
+{
+	uint32_t largest = 0;
+	for (const auto& range : free_ranges)
+	{
+		largest = std::max(largest, range.second);
+	}
+	return largest;
+}
+
+void CoalesceDescriptorRanges(std::vector<uint32_t>& indices, std::vector<DescriptorRange>& ranges)
+{
+	ranges.clear();
+	std::sort(indices.begin(), indices.end());
+	indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+	for (uint32_t index : indices)
+	{
+		if (!ranges.empty() && ranges.back().first + ranges.back().count == index)
+		{
+			ranges.back().count++;
+			continue;
+		}
+		DescriptorRange range = { index, 1 };
+		ranges.push_back(range);
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+struct DescriptorRange
+{
+	uint32_t first;
+	uint32_t count;
+};
+
+// First-fit allocator for contiguous descriptor ranges. Freed ranges merge
+// with their neighbours, Grow appends space at the end.
+class DescriptorFreeList
+{
+public:
+	static const uint32_t invalid_index = ~0u;
+
+	DescriptorFreeList();
+	explicit DescriptorFreeList(uint32_t size);
+
+	void Reset(uint32_t size);
+	void Grow(uint32_t new_size);
+
+	uint32_t Allocate(uint32_t count);
+	void Free(uint32_t first, uint32_t count);
+
+	uint32_t GetSize() const { return size; }
+	uint32_t GetAllocatedNum() const { return allocated_num; }
+	uint32_t GetFreeRangeNum() const { return static_cast<uint32_t>(free_ranges.size()); }
+	uint32_t GetLargestFreeRange() const;
+
+protected:
+	void AddFreeRange(uint32_t first, uint32_t count);
+
+	uint32_t size;
+	uint32_t allocated_num;
+	// First index to count of every free range
+	std::map<uint32_t, uint32_t> free_ranges;
+};
+
+// Sorts and deduplicates indices, then merges consecutive ones into ranges
+void CoalesceDescriptorRanges(std::vector<uint32_t>& indices, std::vector<DescriptorRange>& ranges);
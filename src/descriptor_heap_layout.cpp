@@ -0,0 +1,80 @@
+#include "descriptor_heap_layout.h"
+
+#include <algorithm>
+
+DescriptorHeapLayout::DescriptorHeapLayout() : transient_num(0), generation(0)
+{
+}
+
+void DescriptorHeapLayout::Reset(uint32_t persistent_num, uint32_t transient_num)
+{
+	this->transient_num = transient_num;
+	persistent.Reset(persistent_num);
+	transient.Reset(transient_num);
+	staged_indices.clear();
+	staged_ranges.clear();
+	generation++;
+}
+
+uint32_t DescriptorHeapLayout::AllocatePersistent(uint32_t count)
+{
+	const uint32_t first = persistent.Allocate(count);
+	return first == DescriptorFreeList::invalid_index ? invalid_index : first;
+}
+
+void DescriptorHeapLayout::FreePersistent(uint32_t first, uint32_t count)
+{
+	persistent.Free(first, count);
+}
+
+uint32_t DescriptorHeapLayout::GetGrownPersistentNum(uint32_t count) const
+{
+	const uint32_t min_persistent_num = persistent.GetAllocatedNum() + count;
+	uint32_t persistent_num = std::max(persistent.GetSize() * 2, 1u);
+	while (persistent_num < min_persistent_num)
+	{
+		persistent_num *= 2;
+	}
+	return persistent_num;
+}
+
+DescriptorRange DescriptorHeapLayout::Grow(uint32_t persistent_num)
+{
+	// Staged but uncommitted views come along with the staging heap copy
+	const DescriptorRange copied = { 0, persistent.GetSize() };
+	persistent.Grow(persistent_num);
+	generation++;
+	return copied;
+}
+
+void DescriptorHeapLayout::Stage(uint32_t index)
+{
+	staged_indices.push_back(index);
+}
+
+const std::vector<DescriptorRange>& DescriptorHeapLayout::TakeStagedRanges()
+{
+	CoalesceDescriptorRanges(staged_indices, staged_ranges);
+	staged_indices.clear();
+	return staged_ranges;
+}
+
+uint32_t DescriptorHeapLayout::AllocateTransient(uint32_t count)
+{
+	const uint64_t offset = transient.Allocate(count);
+	if (offset == RingAllocator::invalid_offset)
+	{
+		return invalid_index;
+	}
+	return persistent.GetSize() + static_cast<uint32_t>(offset);
+}
+
+void DescriptorHeapLayout::FinishFrame(uint64_t fence_value)
+{
+	transient.FinishRegion(fence_value);
+}
+
+void DescriptorHeapLayout::Retire(uint64_t completed_fence_value)
+{
+	transient.Retire(completed_fence_value);
+}
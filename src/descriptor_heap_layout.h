@@ -0,0 +1,57 @@
+#pragma once
+
+#include "descriptor_allocator.h"
+#include "ring_allocator.h"
+
+#include <cstdint>
+#include <vector>
+
+// Device-free bookkeeping of DescriptorHeapManager. The shader-visible heap
+// holds the persistent free list first and the per-frame transient ring
+// behind it, the staging heap only the persistent part. The manager turns
+// what this returns into descriptor heaps and copies.
+class DescriptorHeapLayout
+{
+public:
+	static const uint32_t invalid_index = ~0u;
+
+	DescriptorHeapLayout();
+
+	// Forgets every allocation and staged index, a new heap pair gets a new generation
+	void Reset(uint32_t persistent_num, uint32_t transient_num);
+
+	// invalid_index when the persistent range is full, Grow to GetGrownPersistentNum first
+	uint32_t AllocatePersistent(uint32_t count);
+	void FreePersistent(uint32_t first, uint32_t count);
+	// Twice the persistent range, or more until count more descriptors fit
+	uint32_t GetGrownPersistentNum(uint32_t count) const;
+	// Moves the transient ring behind the larger persistent range and bumps the generation.
+	// Returns the range the new heaps copy from the old staging heap.
+	DescriptorRange Grow(uint32_t persistent_num);
+
+	void Stage(uint32_t index);
+	// What Commit copies: staged indices merged into ranges, the staging list starts over
+	const std::vector<DescriptorRange>& TakeStagedRanges();
+
+	// Heap index of count consecutive transient slots, invalid_index when the ring is full.
+	// The slots come back once the fence value of the frame they were allocated in completes.
+	uint32_t AllocateTransient(uint32_t count);
+	void FinishFrame(uint64_t fence_value);
+	void Retire(uint64_t completed_fence_value);
+
+	uint32_t GetHeapSize() const { return persistent.GetSize() + transient_num; }
+	uint32_t GetPersistentCapacity() const { return persistent.GetSize(); }
+	uint32_t GetPersistentNum() const { return persistent.GetAllocatedNum(); }
+	uint32_t GetTransientCapacity() const { return transient_num; }
+	uint32_t GetTransientNum() const { return static_cast<uint32_t>(transient.GetUsedSize()); }
+	// Changes whenever the heaps are replaced
+	uint32_t GetGeneration() const { return generation; }
+
+protected:
+	DescriptorFreeList persistent;
+	RingAllocator transient;
+	uint32_t transient_num;
+	uint32_t generation;
+	std::vector<uint32_t> staged_indices;
+	std::vector<DescriptorRange> staged_ranges;
+};
@@ -0,0 +1,151 @@
+#include "descriptor_heap_manager.h"
+
+DescriptorHeapManager::DescriptorHeapManager() : descriptor_size(0), releases(nullptr)
+{
+}
+
+DescriptorHeapManager::~DescriptorHeapManager()
+{
+	Destroy();
+}
+
+void DescriptorHeapManager::Create(ID3D12Device* device, UINT persistent_num, UINT transient_num, DeferredReleaseQueue& releases)
+{
+	this->device = device;
+	this->releases = &releases;
+	descriptor_size = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	layout.Reset(persistent_num, transient_num);
+	CreateHeaps(heap, staging_heap);
+}
+
+void DescriptorHeapManager::Destroy()
+{
+	layout.Reset(0, 0);
+	staging_heap.Reset();
+	heap.Reset();
+	device.Reset();
+}
+
+UINT DescriptorHeapManager::AllocatePersistent(UINT count)
+{
+	UINT first = layout.AllocatePersistent(count);
+	if (first == DescriptorHeapLayout::invalid_index)
+	{
+		Grow(layout.GetGrownPersistentNum(count));
+		first = layout.AllocatePersistent(count);
+	}
+	return first;
+}
+
+void DescriptorHeapManager::FreePersistent(UINT first, UINT count)
+{
+	releases->Release([this, first, count]() { layout.FreePersistent(first, count); }, static_cast<UINT64>(count) * descriptor_size);
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE DescriptorHeapManager::StageDescriptor(UINT index)
+{
+	layout.Stage(index);
+	return GetCpuHandle(staging_heap.Get(), index);
+}
+
+void DescriptorHeapManager::Commit()
+{
+	const std::vector<DescriptorRange>& staged_ranges = layout.TakeStagedRanges();
+	if (staged_ranges.empty())
+	{
+		return;
+	}
+
+	// Source and destination ranges line up, both heaps share the persistent layout
+	std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> destination_starts;
+	std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> source_starts;
+	std::vector<UINT> range_sizes;
+	for (const DescriptorRange& range : staged_ranges)
+	{
+		destination_starts.push_back(GetCpuHandle(heap.Get(), range.first));
+		source_starts.push_back(GetCpuHandle(staging_heap.Get(), range.first));
+		range_sizes.push_back(range.count);
+	}
+	const UINT range_num = static_cast<UINT>(range_sizes.size());
+	device->CopyDescriptors(range_num, destination_starts.data(), range_sizes.data(),
+		range_num, source_starts.data(), range_sizes.data(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+}
+
+UINT DescriptorHeapManager::AllocateTransientTable(const UINT* persistent_indices, UINT count)
+{
+	const UINT first = layout.AllocateTransient(count);
+	if (first == DescriptorHeapLayout::invalid_index)
+	{
+		ThrowIfFailed(E_OUTOFMEMORY);
+	}
+
+	// One destination range gathers single descriptors from anywhere in the staging heap
+	std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> source_starts(count);
+	for (UINT i = 0; i < count; i++)
+	{
+		source_starts[i] = GetCpuHandle(staging_heap.Get(), persistent_indices[i]);
+	}
+	const D3D12_CPU_DESCRIPTOR_HANDLE destination_start = GetCpuHandle(heap.Get(), first);
+	device->CopyDescriptors(1, &destination_start, &count, count, source_starts.data(), nullptr,
+		D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	return first;
+}
+
+void DescriptorHeapManager::FinishFrame(UINT64 fence_value)
+{
+	layout.FinishFrame(fence_value);
+}
+
+void DescriptorHeapManager::Retire(UINT64 completed_fence_value)
+{
+	layout.Retire(completed_fence_value);
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE DescriptorHeapManager::GetGpuHandle(UINT index) const
+{
+	return CD3DX12_GPU_DESCRIPTOR_HANDLE(heap->GetGPUDescriptorHandleForHeapStart(), index, descriptor_size);
+}
+
+void DescriptorHeapManager::Grow(UINT persistent_num)
+{
+	ComPtr<ID3D12DescriptorHeap> new_heap;
+	ComPtr<ID3D12DescriptorHeap> new_staging_heap;
+	const UINT old_heap_size = layout.GetHeapSize();
+	const DescriptorRange copied = layout.Grow(persistent_num);
+	CreateHeaps(new_heap, new_staging_heap);
+
+	// Transient slots stay behind, the frames using them still bind the old heap
+	if (copied.count > 0)
+	{
+		device->CopyDescriptorsSimple(copied.count, GetCpuHandle(new_staging_heap.Get(), copied.first),
+			GetCpuHandle(staging_heap.Get(), copied.first), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+		device->CopyDescriptorsSimple(copied.count, GetCpuHandle(new_heap.Get(), copied.first),
+			GetCpuHandle(staging_heap.Get(), copied.first), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	}
+
+	releases->ReleaseObject(heap, static_cast<UINT64>(old_heap_size) * descriptor_size);
+	heap = new_heap;
+	staging_heap = new_staging_heap;
+}
+
+void DescriptorHeapManager::CreateHeaps(ComPtr<ID3D12DescriptorHeap>& new_heap, ComPtr<ID3D12DescriptorHeap>& new_staging_heap)
+{
+	D3D12_DESCRIPTOR_HEAP_DESC heap_descriptor = {};
+	heap_descriptor.NumDescriptors = std::max(layout.GetHeapSize(), 1u);
+	heap_descriptor.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+	heap_descriptor.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+	ThrowIfFailed(device->CreateDescriptorHeap(&heap_descriptor, IID_PPV_ARGS(&new_heap)));
+	new_heap->SetName(L"Shader visible descriptor heap");
+
+	D3D12_DESCRIPTOR_HEAP_DESC staging_heap_descriptor = {};
+	staging_heap_descriptor.NumDescriptors = std::max(layout.GetPersistentCapacity(), 1u);
+	staging_heap_descriptor.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+	staging_heap_descriptor.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+	ThrowIfFailed(device->CreateDescriptorHeap(&staging_heap_descriptor, IID_PPV_ARGS(&new_staging_heap)));
+	new_staging_heap->SetName(L"Staging descriptor heap");
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE DescriptorHeapManager::GetCpuHandle(ID3D12DescriptorHeap* descriptor_heap, UINT index) const
+{
+	return CD3DX12_CPU_DESCRIPTOR_HANDLE(descriptor_heap->GetCPUDescriptorHandleForHeapStart(), index, descriptor_size);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "dx12_labs.h"
+#include "deferred_release_queue.h"
+#include "descriptor_heap_layout.h"
+
+// The shader-visible CBV/SRV/UAV heap: persistent descriptors from a free
+// list at the start, a per-frame transient ring behind them. Persistent
+// views are created in a CPU-only staging heap with the same layout, since
+// shader-visible heaps are slow to read, and copied in by Commit. Running
+// out of persistent space recreates both heaps twice as large. The old
+// shader-visible heap goes to the deferred release queue.
+class DescriptorHeapManager
+{
+public:
+	DescriptorHeapManager();
+	~DescriptorHeapManager();
+
+	void Create(ID3D12Device* device, UINT persistent_num, UINT transient_num, DeferredReleaseQueue& releases);
+	void Destroy();
+
+	UINT AllocatePersistent(UINT count = 1);
+	// The range is reused only after the submissions that may read it have retired
+	void FreePersistent(UINT first, UINT count = 1);
+	// Queues the descriptor for the next Commit and returns where to create its view
+	D3D12_CPU_DESCRIPTOR_HANDLE StageDescriptor(UINT index);
+	// Copies every descriptor staged since the last call in one CopyDescriptors call
+	void Commit();
+
+	// Copies persistent descriptors into consecutive ring slots, valid until the frame retires
+	UINT AllocateTransientTable(const UINT* persistent_indices, UINT count);
+	// Tags the transient slots of the frame just submitted, they come back once it retires
+	void FinishFrame(UINT64 fence_value);
+	void Retire(UINT64 completed_fence_value);
+
+	ID3D12DescriptorHeap* GetHeap() const { return heap.Get(); }
+	D3D12_GPU_DESCRIPTOR_HANDLE GetGpuHandle(UINT index) const;
+	// Changes whenever the shader-visible heap is replaced, lists recorded earlier still bind the old one
+	UINT GetGeneration() const { return layout.GetGeneration(); }
+	UINT GetPersistentCapacity() const { return layout.GetPersistentCapacity(); }
+	UINT GetPersistentNum() const { return layout.GetPersistentNum(); }
+
+protected:
+	void Grow(UINT persistent_num);
+	// Sized for the current layout
+	void CreateHeaps(ComPtr<ID3D12DescriptorHeap>& new_heap, ComPtr<ID3D12DescriptorHeap>& new_staging_heap);
+	D3D12_CPU_DESCRIPTOR_HANDLE GetCpuHandle(ID3D12DescriptorHeap* descriptor_heap, UINT index) const;
+
+	ComPtr<ID3D12Device> device;
+	ComPtr<ID3D12DescriptorHeap> heap;
+	ComPtr<ID3D12DescriptorHeap> staging_heap;
+	UINT descriptor_size;
+	DescriptorHeapLayout layout;
+	DeferredReleaseQueue* releases;
+};
@@ -0,0 +1,120 @@
+#include "draw_packet.h"
+
+#include <cstring>
+#include <utility>
+
+uint64_t DrawKey::Make(uint32_t pass, uint32_t pipeline, uint32_t material, float depth)
+{
+	// Non-negative floats order the same as their bit patterns
+	uint32_t depth_bits = 0;
+	if (depth > 0.f)
+	{
+		std::memcpy(&depth_bits, &depth, sizeof(depth_bits));
+	}
+	return (static_cast<uint64_t>(pass & 0xF) << 60) |
+		(static_cast<uint64_t>(pipeline & 0xFFF) << 48) |
+		(static_cast<uint64_t>(material & 0xFFFF) << 32) |
+		depth_bits;
+}
+
+void RadixSortDrawPackets(std::vector<DrawPacket>& packets, std::vector<DrawPacket>& scratch)
+{
+	const size_t packet_num = packets.size();
+	if (packet_num < 2)
+	{
+		return;
+	}
+	scratch.resize(packet_num);
+
+	static const uint32_t digit_num = sizeof(uint64_t);
+	uint32_t histograms[digit_num][256] = {};
+	for (const DrawPacket& packet : packets)
+	{
+		uint64_t key = packet.key;
+		for (uint32_t digit = 0; digit < digit_num; digit++)
+		{
+			histograms[digit][key & 0xFF]++;
+			key >>= 8;
+		}
+	}
+
+	DrawPacket* source = packets.data();
+	DrawPacket* destination = scratch.data();
+	for (uint32_t digit = 0; digit < digit_num; digit++)
+	{
+		uint32_t* histogram = histograms[digit];
+		const uint32_t shift = digit * 8;
+		// Every key has the same digit here, the pass would not move anything
+		if (histogram[(source[0].key >> shift) & 0xFF] == packet_num)
+		{
+			continue;
+		}
+
+		uint32_t offset = 0;
+		for (uint32_t bucket = 0; bucket < 256; bucket++)
+		{
+			const uint32_t count = histogram[bucket];
+			histogram[bucket] = offset;
+			offset += count;
+		}
+		for (size_t i = 0; i < packet_num; i++)
+		{
+			destination[histogram[(source[i].key >> shift) & 0xFF]++] = source[i];
+		}
+		std::swap(source, destination);
+	}
+
+	if (source != packets.data())
+	{
+		packets.swap(scratch);
+	}
+}
+
+DrawStateChanges SubmitDrawPackets(const DrawPacket* first, const DrawPacket* last, DrawCommandSink* sink)
+{
+	DrawStateChanges changes = {};
+	bool has_state = false;
+	uint32_t pass = 0;
+	uint32_t pipeline = 0;
+	uint32_t material = 0;
+	for (const DrawPacket* packet = first; packet != last; packet++)
+	{
+		const uint32_t packet_pass = DrawKey::GetPass(packet->key);
+		const uint32_t packet_pipeline = DrawKey::GetPipeline(packet->key);
+		const uint32_t packet_material = DrawKey::GetMaterial(packet->key);
+		if (!has_state || packet_pass != pass)
+		{
+			pass = packet_pass;
+			changes.pass_changes++;
+			if (sink)
+			{
+				sink->SetPass(pass);
+			}
+		}
+		if (!has_state || packet_pipeline != pipeline)
+		{
+			pipeline = packet_pipeline;
+			changes.pipeline_changes++;
+			if (sink)
+			{
+				sink->SetPipeline(pipeline);
+			}
+		}
+		if (!has_state || packet_material != material)
+		{
+			material = packet_material;
+			changes.material_changes++;
+			if (sink)
+			{
+				sink->SetMaterial(material);
+			}
+		}
+		has_state = true;
+		changes.draw_num++;
+		if (sink)
+		{
+			sink->Draw(packet->draw_id);
+		}
+	}
+	return changes;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// 64-bit sort key, most significant first:
+// pass (4 bits) | pipeline (12 bits) | material (16 bits) | depth (32 bits).
+// Sorting the keys ascending groups draws by state and orders each state
+// bucket front to back. The material is a dense id, the recorder maps it to
+// descriptors; a bindless heap index would not fit the 16 bits.
+struct DrawKey
+{
+	static const uint32_t pass_bits = 4;
+	static const uint32_t pipeline_bits = 12;
+	static const uint32_t material_bits = 16;
+
+	static uint64_t Make(uint32_t pass, uint32_t pipeline, uint32_t material, float depth);
+	static uint32_t GetPass(uint64_t key) { return static_cast<uint32_t>(key >> 60); }
+	static uint32_t GetPipeline(uint64_t key) { return static_cast<uint32_t>(key >> 48) & 0xFFF; }
+	static uint32_t GetMaterial(uint64_t key) { return static_cast<uint32_t>(key >> 32) & 0xFFFF; }
+};
+
+struct DrawPacket
+{
+	uint64_t key;
+	uint32_t draw_id;
+};
+
+// LSD radix sort on 8-bit digits. Histograms for all digits are built in one
+// pass over the keys and digits shared by every key are skipped, so a frame
+// with a single pipeline and pass pays for the material and depth bytes only.
+// scratch is resized as needed and kept by the caller between frames.
+void RadixSortDrawPackets(std::vector<DrawPacket>& packets, std::vector<DrawPacket>& scratch);
+
+struct DrawStateChanges
+{
+	uint32_t pass_changes;
+	uint32_t pipeline_changes;
+	uint32_t material_changes;
+	uint32_t draw_num;
+
+	uint32_t GetTotal() const { return pass_changes + pipeline_changes + material_changes; }
+};
+
+// Receives the state changes and draws of a packet stream
+class DrawCommandSink
+{
+public:
+	virtual ~DrawCommandSink() {}
+	virtual void SetPass(uint32_t pass) = 0;
+	virtual void SetPipeline(uint32_t pipeline) = 0;
+	virtual void SetMaterial(uint32_t material) = 0;
+	virtual void Draw(uint32_t draw_id) = 0;
+};
+
+// Emits packets [first, last) into the sink, skipping state the sink already has.
+// The sink is assumed to start with no state bound, like a fresh command list.
+DrawStateChanges SubmitDrawPackets(const DrawPacket* first, const DrawPacket* last, DrawCommandSink* sink);
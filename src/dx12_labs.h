@@ -4,6 +4,10 @@
 #define UNICODE
 #endif
 
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
 #include <Windows.h>
 
 #include <wrl.h>
@@ -18,6 +22,9 @@
 
 #include <iostream>
 #include <chrono>
+#include <algorithm>
+#include <cfloat>
+#include <vector>
 
 #include <exception>
 
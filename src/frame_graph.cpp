@@ -0,0 +1,38 @@
+#include "frame_graph.h"
+
+FrameGraph BuildFrameGraph(RenderGraph& graph, uint64_t depth_size, uint64_t depth_alignment)
+{
+	FrameGraph frame_graph = {};
+	graph.Clear();
+	frame_graph.back_buffer_resource = graph.ImportResource("Back buffer", RESOURCE_STATE_PRESENT, RESOURCE_STATE_PRESENT);
+	frame_graph.depth_resource = graph.CreateTransient("Depth stencil", depth_size, depth_alignment);
+
+	// Clear is the first use of the depth memory, which aliasing leaves undefined
+	frame_graph.clear_pass = graph.AddPass("Clear");
+	graph.Write(frame_graph.clear_pass, frame_graph.back_buffer_resource, RESOURCE_STATE_RENDER_TARGET);
+	graph.Write(frame_graph.clear_pass, frame_graph.depth_resource, RESOURCE_STATE_DEPTH_WRITE);
+
+	frame_graph.scene_pass = graph.AddPass("Scene");
+	graph.Write(frame_graph.scene_pass, frame_graph.back_buffer_resource, RESOURCE_STATE_RENDER_TARGET);
+	graph.Write(frame_graph.scene_pass, frame_graph.depth_resource, RESOURCE_STATE_DEPTH_WRITE);
+
+	graph.Compile();
+	return frame_graph;
+}
+
+void RecordClearPass(CommandRecorder& recorder, const RenderGraph& graph, const FrameGraph& frame_graph)
+{
+	recorder.RecordBatch(graph, frame_graph.clear_pass);
+	recorder.ClearRenderTarget(frame_graph.back_buffer_resource);
+	recorder.ClearDepthStencil(frame_graph.depth_resource);
+}
+
+void BeginSceneDraws(CommandRecorder& recorder, const FrameGraph& frame_graph)
+{
+	recorder.BeginDraws(frame_graph.back_buffer_resource, frame_graph.depth_resource, 0);
+}
+
+void RecordFrameEnd(CommandRecorder& recorder, const RenderGraph& graph)
+{
+	recorder.RecordBatch(graph, graph.GetPassNum());
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "command_recorder.h"
+#include "render_graph.h"
+
+#include <cstdint>
+
+// Graph ids of the frame's passes and attachments
+struct FrameGraph
+{
+	uint32_t back_buffer_resource;
+	uint32_t depth_resource;
+	uint32_t clear_pass;
+	uint32_t scene_pass;
+};
+
+// Declares and compiles the frame: a clear pass, then the scene pass drawing
+// into the imported back buffer and a transient depth buffer. Shared by the
+// D3D12 renderer and headless runs, so both validate the same barriers.
+FrameGraph BuildFrameGraph(RenderGraph& graph, uint64_t depth_size, uint64_t depth_alignment);
+
+// The clear pass: its barriers, then both attachments cleared
+void RecordClearPass(CommandRecorder& recorder, const RenderGraph& graph, const FrameGraph& frame_graph);
+// Binds the scene pass attachments for a draw list. Material indices are absolute heap indices, so the table starts at 0.
+void BeginSceneDraws(CommandRecorder& recorder, const FrameGraph& frame_graph);
+// Barriers after the last pass return imported resources to their final states
+void RecordFrameEnd(CommandRecorder& recorder, const RenderGraph& graph);
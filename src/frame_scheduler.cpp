@@ -0,0 +1,45 @@
+#include "frame_scheduler.h"
+
+uint64_t SteadyClock::Now() const
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+FrameScheduler::FrameScheduler(const Clock& clock, uint32_t target_fps) :
+	clock(clock), frame_interval(0), last_frame_time(0), frame_num(0), frame_requested(true), animating(false)
+{
+	SetTargetFps(target_fps);
+}
+
+void FrameScheduler::SetTargetFps(uint32_t target_fps)
+{
+	frame_interval = target_fps > 0 ? 1000000 / target_fps : 0;
+}
+
+bool FrameScheduler::ShouldRender() const
+{
+	return GetWaitTime() == 0;
+}
+
+uint64_t FrameScheduler::GetWaitTime() const
+{
+	if (IsIdle())
+	{
+		return infinite_wait;
+	}
+	if (frame_num == 0)
+	{
+		return 0;
+	}
+	const uint64_t now = clock.Now();
+	const uint64_t next_frame_time = last_frame_time + frame_interval;
+	return now >= next_frame_time ? 0 : next_frame_time - now;
+}
+
+void FrameScheduler::OnFrameRendered()
+{
+	last_frame_time = clock.Now();
+	frame_num++;
+	frame_requested = false;
+}
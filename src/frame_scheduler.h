@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+// Time source of the scheduler in microseconds
+class Clock
+{
+public:
+	virtual ~Clock() {};
+	virtual uint64_t Now() const = 0;
+};
+
+class SteadyClock : public Clock
+{
+public:
+	uint64_t Now() const override;
+};
+
+// Only moves when told to, for deterministic tests
+class ManualClock : public Clock
+{
+public:
+	explicit ManualClock(uint64_t time = 0) : time(time) {}
+
+	uint64_t Now() const override { return time; }
+	void Advance(uint64_t microseconds) { time += microseconds; }
+
+protected:
+	uint64_t time;
+};
+
+// Decides when the main loop renders and how long it may block. A frame is
+// due after a request (input, window exposure, finished streaming) or every
+// interval while something animates; otherwise the loop sleeps until woken.
+// Frames never start closer than the target interval, capping the frame rate.
+class FrameScheduler
+{
+public:
+	static const uint64_t infinite_wait = UINT64_MAX;
+
+	// A target of 0 renders as fast as frames are requested
+	explicit FrameScheduler(const Clock& clock, uint32_t target_fps = 60);
+
+	void RequestFrame() { frame_requested = true; }
+	void SetAnimating(bool animating) { this->animating = animating; }
+	void SetTargetFps(uint32_t target_fps);
+
+	bool ShouldRender() const;
+	// Microseconds until the next frame is due, 0 if it is due now, infinite_wait when idle
+	uint64_t GetWaitTime() const;
+	void OnFrameRendered();
+
+	bool IsIdle() const { return !frame_requested && !animating; }
+	uint64_t GetFrameInterval() const { return frame_interval; }
+	uint64_t GetFrameNum() const { return frame_num; }
+
+protected:
+	const Clock& clock;
+	uint64_t frame_interval;
+	uint64_t last_frame_time;
+	uint64_t frame_num;
+	bool frame_requested;
+	bool animating;
+};
@@ -0,0 +1,187 @@
+#include "frame_stages.h"
+
+#include "job_system.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+	float GetDiagonal(const float* min, const float* max)
+	{
+		const float x = max[0] - min[0];
+		const float y = max[1] - min[1];
+		const float z = max[2] - min[2];
+		return std::sqrt(x * x + y * y + z * z);
+	}
+}
+
+FrameView FrameView::FromCamera(const CameraSnapshot& camera, float aspect_ratio)
+{
+	FrameView view = {};
+	const float y_scale = 1.f / std::tan(fov * 0.5f);
+	const float x_scale = y_scale / aspect_ratio;
+	const float depth_scale = far_plane / (far_plane - near_plane);
+
+	std::copy(camera.eye_position, camera.eye_position + 3, view.eye_position);
+	view.forward[0] = std::sin(camera.angle);
+	view.forward[1] = 0.f;
+	view.forward[2] = std::cos(camera.angle);
+	// Up is +Y and forward is horizontal, so right is forward turned a quarter around Y
+	const float* eye = view.eye_position;
+	const float* forward = view.forward;
+	const float right[3] = { forward[2], 0.f, -forward[0] };
+
+	// View rows are the axes in columns, the last row moves the eye to the origin
+	const float view_matrix[16] = {
+		right[0], 0.f, forward[0], 0.f,
+		right[1], 1.f, forward[1], 0.f,
+		right[2], 0.f, forward[2], 0.f,
+		-(right[0] * eye[0] + right[2] * eye[2]), -eye[1], -(forward[0] * eye[0] + forward[2] * eye[2]), 1.f
+	};
+	for (uint32_t row = 0; row < 4; row++)
+	{
+		const float* view_row = view_matrix + row * 4;
+		float* row_out = view.view_projection + row * 4;
+		row_out[0] = view_row[0] * x_scale;
+		row_out[1] = view_row[1] * y_scale;
+		row_out[2] = view_row[2] * depth_scale - view_row[3] * near_plane * depth_scale;
+		row_out[3] = view_row[2];
+	}
+	return view;
+}
+
+float FrameView::GetDepth(const float* min, const float* max) const
+{
+	float depth = 0.f;
+	for (uint32_t axis = 0; axis < 3; axis++)
+	{
+		depth += ((min[axis] + max[axis]) * 0.5f - eye_position[axis]) * forward[axis];
+	}
+	return depth;
+}
+
+void DrawStages::SetDraws(const std::vector<OcclusionBounds>& bounds, const std::vector<uint32_t>& material_ids)
+{
+	draw_bounds = bounds;
+	this->material_ids = material_ids;
+	const uint32_t draw_num = static_cast<uint32_t>(bounds.size());
+	instance_bounds.Resize(draw_num);
+	for (uint32_t draw_id = 0; draw_id < draw_num; draw_id++)
+	{
+		instance_bounds.Set(draw_id, bounds[draw_id].min, bounds[draw_id].max);
+	}
+	draw_visibility.assign(draw_num, 1);
+	occluders.clear();
+}
+
+void DrawStages::SelectOccluders(const std::vector<OccluderMesh>& meshes)
+{
+	float scene_min[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float scene_max[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (const OcclusionBounds& bounds : draw_bounds)
+	{
+		for (uint32_t axis = 0; axis < 3; axis++)
+		{
+			scene_min[axis] = std::min(scene_min[axis], bounds.min[axis]);
+			scene_max[axis] = std::max(scene_max[axis], bounds.max[axis]);
+		}
+	}
+	const float scene_size = draw_bounds.empty() ? 0.f : GetDiagonal(scene_min, scene_max);
+
+	occluders.clear();
+	for (uint32_t draw_id = 0; draw_id < draw_bounds.size(); draw_id++)
+	{
+		const OcclusionBounds& bounds = draw_bounds[draw_id];
+		const OccluderMesh& mesh = meshes[draw_id];
+		if (GetDiagonal(bounds.min, bounds.max) >= occluder_size_ratio * scene_size && mesh.index_num / 3 <= max_occluder_triangle_num)
+		{
+			occluders.push_back(mesh);
+		}
+	}
+}
+
+void DrawStages::BuildDrawPackets(const FrameView& view, uint32_t draw_num, const DrawStageOptions& options, JobSystem& jobs)
+{
+	// Single opaque pass and pipeline for now, the material is the dense texture id
+	std::fill(draw_visibility.begin(), draw_visibility.begin() + draw_num, 1);
+	frustum_culled_num = 0;
+	if (options.frustum_culling)
+	{
+		PROFILE_SCOPE("Frustum culling");
+		const FrustumPlanes planes = FrustumPlanes::FromViewProjection(view.view_projection);
+		frustum_culled_num = draw_num - frustum_culler.Cull(planes, instance_bounds, draw_num, draw_visibility.data(), jobs);
+	}
+	if (options.occlusion_culling && !occluders.empty())
+	{
+		PROFILE_SCOPE("Occlusion culling");
+		occlusion_culler.BeginFrame(view.view_projection);
+		for (const OccluderMesh& mesh : occluders)
+		{
+			occlusion_culler.AddOccluder(mesh.positions, mesh.stride, mesh.indices, mesh.index_num, mesh.base_vertex);
+		}
+		occlusion_culler.Rasterize(jobs);
+		occlusion_culler.TestVisibility(draw_bounds.data(), draw_num, draw_visibility.data(), jobs);
+	}
+
+	draw_packets.clear();
+	for (uint32_t draw_id = 0; draw_id < draw_num; draw_id++)
+	{
+		if (!draw_visibility[draw_id])
+		{
+			continue;
+		}
+		const OcclusionBounds& bounds = draw_bounds[draw_id];
+		DrawPacket packet = {};
+		packet.key = DrawKey::Make(0, 0, material_ids[draw_id], view.GetDepth(bounds.min, bounds.max));
+		packet.draw_id = draw_id;
+		draw_packets.push_back(packet);
+	}
+	occlusion_culled_num = draw_num - frustum_culled_num - static_cast<uint32_t>(draw_packets.size());
+
+	unsorted_state_changes = SubmitDrawPackets(draw_packets.data(), draw_packets.data() + draw_packets.size(), nullptr);
+	if (options.sorted_draws)
+	{
+		PROFILE_SCOPE("Sort draws");
+		RadixSortDrawPackets(draw_packets, draw_packet_scratch);
+	}
+	sorted_state_changes = SubmitDrawPackets(draw_packets.data(), draw_packets.data() + draw_packets.size(), nullptr);
+}
+
+uint32_t DrawStages::GetListNum(uint32_t draw_num, uint32_t max_list_num)
+{
+	return std::min(max_list_num, (draw_num + min_draws_per_list - 1) / min_draws_per_list);
+}
+
+uint32_t DrawStages::GetListDraw(uint32_t draw_num, uint32_t list_num, uint32_t list_index)
+{
+	return static_cast<uint32_t>(static_cast<uint64_t>(draw_num) * list_index / list_num);
+}
+
+bool DrawBundleSet::CanReplay(const DrawStageOptions& options)
+{
+	return !options.frustum_culling && !options.occlusion_culling;
+}
+
+bool DrawBundleSet::IsStale(uint32_t draw_num, uint32_t list_num, bool sorted_draws) const
+{
+	return this->draw_num != draw_num || this->list_num != list_num || this->sorted_draws != sorted_draws;
+}
+
+void DrawBundleSet::Record(const std::vector<DrawPacket>& packets, uint32_t draw_num, uint32_t list_num, bool sorted_draws)
+{
+	this->packets = packets;
+	this->draw_num = draw_num;
+	this->list_num = list_num;
+	this->sorted_draws = sorted_draws;
+}
+
+void DrawBundleSet::Clear()
+{
+	packets.clear();
+	draw_num = 0;
+	list_num = 0;
+	sorted_draws = false;
+}
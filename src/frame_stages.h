@@ -0,0 +1,119 @@
+#pragma once
+
+#include "camera_controller.h"
+#include "draw_packet.h"
+#include "frustum_culler.h"
+#include "occlusion_culler.h"
+
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+// Camera of a frame. The matrix is XMMatrixLookAtLH times XMMatrixPerspectiveFovLH,
+// row-major with clip = position * view_projection and depth in [0, 1].
+struct FrameView
+{
+	static constexpr float fov = 60.f * 3.14159265f / 180.f;
+	static constexpr float near_plane = 0.001f;
+	static constexpr float far_plane = 100.f;
+
+	float view_projection[16];
+	float eye_position[3];
+	float forward[3];
+
+	static FrameView FromCamera(const CameraSnapshot& camera, float aspect_ratio);
+	// View space depth of the box center
+	float GetDepth(const float* min, const float* max) const;
+};
+
+// Indexed triangles of an occluder, positions are float3 stride bytes apart
+struct OccluderMesh
+{
+	const void* positions;
+	uint32_t stride;
+	const uint32_t* indices;
+	uint32_t index_num;
+	uint32_t base_vertex;
+};
+
+struct DrawStageOptions
+{
+	bool frustum_culling = true;
+	bool occlusion_culling = true;
+	bool sorted_draws = true;
+};
+
+// CPU stages between the camera and the command lists: frustum and occlusion
+// culling, draw keys and the radix sort, then the split into recording lists.
+// The renderer and HeadlessRenderer run the same stages and record the
+// packets through CommandRecorder, so headless runs measure the real frame.
+class DrawStages
+{
+public:
+	static const uint32_t min_draws_per_list = 32;
+	static const uint32_t max_occluder_triangle_num = 4096;
+	static constexpr float occluder_size_ratio = 0.25f;
+
+	// World-space bounds and dense material id of every draw, indexed by draw id
+	void SetDraws(const std::vector<OcclusionBounds>& bounds, const std::vector<uint32_t>& material_ids);
+	// Large, low-poly draws (walls, floors, boxes) are kept as occluders. Dense meshes
+	// would need a simplified occluder mesh and are skipped. Meshes are indexed by draw id.
+	void SelectOccluders(const std::vector<OccluderMesh>& meshes);
+
+	// Culls draws [0, draw_num), keys the visible ones and sorts them
+	void BuildDrawPackets(const FrameView& view, uint32_t draw_num, const DrawStageOptions& options, JobSystem& jobs);
+
+	const std::vector<DrawPacket>& GetDrawPackets() const { return draw_packets; }
+	uint32_t GetFrustumCulledNum() const { return frustum_culled_num; }
+	uint32_t GetOcclusionCulledNum() const { return occlusion_culled_num; }
+	uint32_t GetOccluderNum() const { return static_cast<uint32_t>(occluders.size()); }
+	// State changes of the packets in draw id order and in submitted order
+	const DrawStateChanges& GetUnsortedStateChanges() const { return unsorted_state_changes; }
+	const DrawStateChanges& GetSortedStateChanges() const { return sorted_state_changes; }
+
+	// Small frames stay on a single list
+	static uint32_t GetListNum(uint32_t draw_num, uint32_t max_list_num);
+	// List list_index records draws [GetListDraw(list_index), GetListDraw(list_index + 1))
+	static uint32_t GetListDraw(uint32_t draw_num, uint32_t list_num, uint32_t list_index);
+
+protected:
+	std::vector<OcclusionBounds> draw_bounds;
+	std::vector<uint32_t> material_ids;
+	InstanceBounds instance_bounds;
+	std::vector<OccluderMesh> occluders;
+
+	FrustumCuller frustum_culler;
+	OcclusionCuller occlusion_culler;
+	std::vector<uint8_t> draw_visibility;
+	std::vector<DrawPacket> draw_packets;
+	std::vector<DrawPacket> draw_packet_scratch;
+
+	uint32_t frustum_culled_num = 0;
+	uint32_t occlusion_culled_num = 0;
+	DrawStateChanges unsorted_state_changes = {};
+	DrawStateChanges sorted_state_changes = {};
+};
+
+// The packets the renderer's bundles were recorded from. A bundle freezes its
+// packet stream, so bundles only replay while culling of either kind is off:
+// the culled stream changes with the view, the recorded one does not.
+class DrawBundleSet
+{
+public:
+	static bool CanReplay(const DrawStageOptions& options);
+
+	// True when the stream no longer splits into the recorded bundles
+	bool IsStale(uint32_t draw_num, uint32_t list_num, bool sorted_draws) const;
+	void Record(const std::vector<DrawPacket>& packets, uint32_t draw_num, uint32_t list_num, bool sorted_draws);
+	void Clear();
+
+	// What ExecuteBundle replays, in submitted order
+	const std::vector<DrawPacket>& GetPackets() const { return packets; }
+
+protected:
+	std::vector<DrawPacket> packets;
+	uint32_t draw_num = 0;
+	uint32_t list_num = 0;
+	bool sorted_draws = false;
+};
@@ -0,0 +1,209 @@
+#include "frame_statistics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable<FrameSample>::value, "samples are copied through atomic words");
+
+namespace
+{
+	void WritePercentiles(std::ostream& stream, const char* name, const Percentiles& percentiles)
+	{
+		char entry[256];
+		snprintf(entry, sizeof(entry),
+			"\"%s\":{\"p50\":%.4f,\"p95\":%.4f,\"p99\":%.4f,\"max\":%.4f,\"mean\":%.4f,\"samples\":%u}",
+			name, percentiles.p50, percentiles.p95, percentiles.p99, percentiles.max, percentiles.mean, percentiles.sample_num);
+		stream << entry;
+	}
+}
+
+Percentiles ComputePercentiles(std::vector<float> values)
+{
+	Percentiles percentiles = {};
+	if (values.empty())
+	{
+		return percentiles;
+	}
+	std::sort(values.begin(), values.end());
+	const size_t value_num = values.size();
+	auto rank = [&](double percentile)
+	{
+		const size_t index = static_cast<size_t>(std::ceil(percentile * value_num));
+		return values[std::max<size_t>(index, 1) - 1];
+	};
+	percentiles.p50 = rank(0.50);
+	percentiles.p95 = rank(0.95);
+	percentiles.p99 = rank(0.99);
+	percentiles.max = values.back();
+	double sum = 0.0;
+	for (float value : values)
+	{
+		sum += value;
+	}
+	percentiles.mean = static_cast<float>(sum / value_num);
+	percentiles.sample_num = static_cast<uint32_t>(value_num);
+	return percentiles;
+}
+
+FrameStatistics::FrameStatistics() : slots(capacity), head(0)
+{
+}
+
+uint64_t FrameStatistics::AddFrame(float frame_time, float cpu_time, uint32_t draw_num, uint64_t triangle_num, uint32_t state_change_num)
+{
+	const uint64_t frame = head.load(std::memory_order_relaxed);
+	FrameSample sample = {};
+	sample.frame = frame;
+	sample.frame_time = frame_time;
+	sample.cpu_time = cpu_time;
+	sample.gpu_time = -1.f;
+	sample.draw_num = draw_num;
+	sample.triangle_num = triangle_num;
+	sample.state_change_num = state_change_num;
+	Store(slots[frame % capacity], sample);
+	head.store(frame + 1, std::memory_order_release);
+	return frame;
+}
+
+void FrameStatistics::SetGpuTime(uint64_t frame, float gpu_time)
+{
+	// Only the writer stores, so its own read of the slot never races
+	Slot& slot = slots[frame % capacity];
+	FrameSample sample = Load(slot);
+	if (sample.frame == frame)
+	{
+		sample.gpu_time = gpu_time;
+		Store(slot, sample);
+	}
+}
+
+std::vector<FrameSample> FrameStatistics::GetSamples(uint32_t window_frame_num) const
+{
+	const uint64_t last = head.load(std::memory_order_acquire);
+	const uint64_t window = std::min<uint64_t>(std::min(window_frame_num, capacity), last);
+	std::vector<FrameSample> snapshot;
+	snapshot.reserve(static_cast<size_t>(window));
+	for (uint64_t frame = last - window; frame < last; frame++)
+	{
+		// Slots the writer reached while copying hold newer frames, drop them
+		const FrameSample sample = Load(slots[frame % capacity]);
+		if (sample.frame == frame)
+		{
+			snapshot.push_back(sample);
+		}
+	}
+	return snapshot;
+}
+
+void FrameStatistics::Store(Slot& slot, const FrameSample& sample)
+{
+	uint64_t words[sample_word_num] = {};
+	std::memcpy(words, &sample, sizeof(sample));
+	const uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+	slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+	// Keeps the word stores after the odd sequence
+	std::atomic_thread_fence(std::memory_order_release);
+	for (uint32_t word = 0; word < sample_word_num; word++)
+	{
+		slot.words[word].store(words[word], std::memory_order_relaxed);
+	}
+	slot.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+FrameSample FrameStatistics::Load(const Slot& slot) const
+{
+	uint64_t words[sample_word_num];
+	for (;;)
+	{
+		const uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+		if (sequence & 1)
+		{
+			continue;
+		}
+		for (uint32_t word = 0; word < sample_word_num; word++)
+		{
+			words[word] = slot.words[word].load(std::memory_order_relaxed);
+		}
+		// Keeps the word loads before the second sequence load
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.sequence.load(std::memory_order_relaxed) == sequence)
+		{
+			break;
+		}
+	}
+	FrameSample sample;
+	std::memcpy(&sample, words, sizeof(sample));
+	return sample;
+}
+
+FrameStatisticsSummary FrameStatistics::Summarize(uint32_t window_frame_num) const
+{
+	return Summarize(GetSamples(window_frame_num));
+}
+
+FrameStatisticsSummary FrameStatistics::Summarize(const std::vector<FrameSample>& samples)
+{
+	std::vector<float> frame_times, cpu_times, gpu_times, draw_nums, triangle_nums, state_change_nums;
+	for (const FrameSample& sample : samples)
+	{
+		frame_times.push_back(sample.frame_time);
+		cpu_times.push_back(sample.cpu_time);
+		// Frames without resolved timestamps are left out rather than counted as free
+		if (sample.gpu_time >= 0.f)
+		{
+			gpu_times.push_back(sample.gpu_time);
+		}
+		draw_nums.push_back(static_cast<float>(sample.draw_num));
+		triangle_nums.push_back(static_cast<float>(sample.triangle_num));
+		state_change_nums.push_back(static_cast<float>(sample.state_change_num));
+	}
+
+	FrameStatisticsSummary summary = {};
+	summary.frame_num = static_cast<uint32_t>(samples.size());
+	summary.frame_time = ComputePercentiles(std::move(frame_times));
+	summary.cpu_time = ComputePercentiles(std::move(cpu_times));
+	summary.gpu_time = ComputePercentiles(std::move(gpu_times));
+	summary.draw_num = ComputePercentiles(std::move(draw_nums));
+	summary.triangle_num = ComputePercentiles(std::move(triangle_nums));
+	summary.state_change_num = ComputePercentiles(std::move(state_change_nums));
+	return summary;
+}
+
+void FrameStatistics::WriteCsv(std::ostream& stream, const std::vector<FrameSample>& samples)
+{
+	stream << "frame,frame_time_ms,cpu_time_ms,gpu_time_ms,draws,triangles,state_changes\n";
+	char row[192];
+	for (const FrameSample& sample : samples)
+	{
+		// An empty GPU column marks a frame without timestamps
+		char gpu_time[32] = "";
+		if (sample.gpu_time >= 0.f)
+		{
+			snprintf(gpu_time, sizeof(gpu_time), "%.4f", sample.gpu_time);
+		}
+		snprintf(row, sizeof(row), "%llu,%.4f,%.4f,%s,%u,%llu,%u\n",
+			static_cast<unsigned long long>(sample.frame), sample.frame_time, sample.cpu_time, gpu_time,
+			sample.draw_num, static_cast<unsigned long long>(sample.triangle_num), sample.state_change_num);
+		stream << row;
+	}
+}
+
+void FrameStatistics::WriteJson(std::ostream& stream, const FrameStatisticsSummary& summary)
+{
+	stream << "{\"frames\":" << summary.frame_num << ",";
+	WritePercentiles(stream, "frame_time_ms", summary.frame_time);
+	stream << ",";
+	WritePercentiles(stream, "cpu_time_ms", summary.cpu_time);
+	stream << ",";
+	WritePercentiles(stream, "gpu_time_ms", summary.gpu_time);
+	stream << ",";
+	WritePercentiles(stream, "draws", summary.draw_num);
+	stream << ",";
+	WritePercentiles(stream, "triangles", summary.triangle_num);
+	stream << ",";
+	WritePercentiles(stream, "state_changes", summary.state_change_num);
+	stream << "}";
+}
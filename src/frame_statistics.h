@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// What one frame cost, times in milliseconds
+struct FrameSample
+{
+	uint64_t frame;
+	// Start to start of consecutive frames, includes any pacing sleep
+	float frame_time;
+	// Recording, submission and present on the render thread
+	float cpu_time;
+	// Negative until the frame's timestamps resolve, a few frames late
+	float gpu_time;
+	uint32_t draw_num;
+	uint64_t triangle_num;
+	uint32_t state_change_num;
+};
+
+struct Percentiles
+{
+	float p50;
+	float p95;
+	float p99;
+	float max;
+	float mean;
+	uint32_t sample_num;
+};
+
+struct FrameStatisticsSummary
+{
+	uint32_t frame_num;
+	Percentiles frame_time;
+	Percentiles cpu_time;
+	Percentiles gpu_time;
+	Percentiles draw_num;
+	Percentiles triangle_num;
+	Percentiles state_change_num;
+};
+
+// Nearest-rank percentiles, an empty input gives all zeros
+Percentiles ComputePercentiles(std::vector<float> values);
+
+// Rolling ring of the latest frames. The render thread is the only writer.
+// Every slot is a seqlock: the writer makes its sequence odd while it stores
+// the sample, a reader on any thread copies the slot and retries when the
+// sequence was odd or moved meanwhile, then drops slots the writer lapped.
+class FrameStatistics
+{
+public:
+	static constexpr uint32_t capacity = 4096;
+
+	FrameStatistics();
+
+	// Returns the frame id GPU time is reported against
+	uint64_t AddFrame(float frame_time, float cpu_time, uint32_t draw_num, uint64_t triangle_num, uint32_t state_change_num);
+	// Late GPU time of a frame, ignored once the frame left the ring
+	void SetGpuTime(uint64_t frame, float gpu_time);
+
+	uint64_t GetFrameNum() const { return head.load(std::memory_order_acquire); }
+	// Oldest first, at most the last window_frame_num frames
+	std::vector<FrameSample> GetSamples(uint32_t window_frame_num = capacity) const;
+	FrameStatisticsSummary Summarize(uint32_t window_frame_num = capacity) const;
+	static FrameStatisticsSummary Summarize(const std::vector<FrameSample>& samples);
+
+	// One row per frame
+	static void WriteCsv(std::ostream& stream, const std::vector<FrameSample>& samples);
+	// One object with p50/p95/p99/max/mean of every metric, embeddable in larger reports
+	static void WriteJson(std::ostream& stream, const FrameStatisticsSummary& summary);
+
+protected:
+	static constexpr uint32_t sample_word_num = (sizeof(FrameSample) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+	// The sample is kept as atomic words, so a torn copy is a retry rather than a data race
+	struct Slot
+	{
+		std::atomic<uint32_t> sequence;
+		std::atomic<uint64_t> words[sample_word_num];
+	};
+
+	void Store(Slot& slot, const FrameSample& sample);
+	FrameSample Load(const Slot& slot) const;
+
+	std::vector<Slot> slots;
+	std::atomic<uint64_t> head;
+};
@@ -0,0 +1,210 @@
+#include "frustum_culler.h"
+#include "job_system.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define AVX2_TARGET
+#endif
+
+static const uint32_t cull_batch_size = 1024;
+
+FrustumPlanes FrustumPlanes::FromViewProjection(const float* m)
+{
+	// Row i holds the weight of position component i in clip x, y, z and w
+	FrustumPlanes planes;
+	float* components[4] = { planes.x, planes.y, planes.z, planes.w };
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		const float x = m[i * 4 + 0];
+		const float y = m[i * 4 + 1];
+		const float z = m[i * 4 + 2];
+		const float w = m[i * 4 + 3];
+		// Left, right, bottom, top, near, far
+		const float plane_components[6] = { w + x, w - x, w + y, w - y, z, w - z };
+		for (uint32_t plane = 0; plane < 6; plane++)
+		{
+			components[i][plane] = plane_components[plane];
+		}
+	}
+	return planes;
+}
+
+void InstanceBounds::Resize(uint32_t instance_num)
+{
+	this->instance_num = instance_num;
+	const size_t padded_num = (instance_num + group_size - 1) / group_size * group_size;
+	center_x.assign(padded_num, 0.f);
+	center_y.assign(padded_num, 0.f);
+	center_z.assign(padded_num, 0.f);
+	extent_x.assign(padded_num, 0.f);
+	extent_y.assign(padded_num, 0.f);
+	extent_z.assign(padded_num, 0.f);
+}
+
+void InstanceBounds::Set(uint32_t instance, const float* min, const float* max)
+{
+	center_x[instance] = (min[0] + max[0]) * 0.5f;
+	center_y[instance] = (min[1] + max[1]) * 0.5f;
+	center_z[instance] = (min[2] + max[2]) * 0.5f;
+	extent_x[instance] = (max[0] - min[0]) * 0.5f;
+	extent_y[instance] = (max[1] - min[1]) * 0.5f;
+	extent_z[instance] = (max[2] - min[2]) * 0.5f;
+}
+
+static uint32_t CullScalar(const FrustumPlanes& planes, const InstanceBounds& bounds, uint32_t first, uint32_t last, uint8_t* visible)
+{
+	uint32_t visible_num = 0;
+	for (uint32_t i = first; i < last; i++)
+	{
+		bool inside = true;
+		for (uint32_t plane = 0; plane < 6 && inside; plane++)
+		{
+			// Distance of the box corner farthest along the plane normal
+			const float distance =
+				planes.x[plane] * bounds.GetCenterX()[i] + planes.y[plane] * bounds.GetCenterY()[i] + planes.z[plane] * bounds.GetCenterZ()[i] + planes.w[plane] +
+				std::fabs(planes.x[plane]) * bounds.GetExtentX()[i] + std::fabs(planes.y[plane]) * bounds.GetExtentY()[i] + std::fabs(planes.z[plane]) * bounds.GetExtentZ()[i];
+			inside = distance >= 0.f;
+		}
+		visible[i] = inside ? 1 : 0;
+		visible_num += visible[i];
+	}
+	return visible_num;
+}
+
+static uint32_t CullSse2(const FrustumPlanes& planes, const InstanceBounds& bounds, uint32_t first, uint32_t last, uint8_t* visible)
+{
+	const __m128 sign_mask = _mm_set1_ps(-0.f);
+	const __m128 zero = _mm_setzero_ps();
+	uint32_t visible_num = 0;
+	uint32_t i = first;
+	for (; i + 4 <= last; i += 4)
+	{
+		const __m128 center_x = _mm_loadu_ps(bounds.GetCenterX() + i);
+		const __m128 center_y = _mm_loadu_ps(bounds.GetCenterY() + i);
+		const __m128 center_z = _mm_loadu_ps(bounds.GetCenterZ() + i);
+		const __m128 extent_x = _mm_loadu_ps(bounds.GetExtentX() + i);
+		const __m128 extent_y = _mm_loadu_ps(bounds.GetExtentY() + i);
+		const __m128 extent_z = _mm_loadu_ps(bounds.GetExtentZ() + i);
+		__m128 inside = _mm_cmpeq_ps(zero, zero);
+		for (uint32_t plane = 0; plane < 6; plane++)
+		{
+			const __m128 plane_x = _mm_set1_ps(planes.x[plane]);
+			const __m128 plane_y = _mm_set1_ps(planes.y[plane]);
+			const __m128 plane_z = _mm_set1_ps(planes.z[plane]);
+			__m128 distance = _mm_add_ps(_mm_mul_ps(plane_x, center_x), _mm_set1_ps(planes.w[plane]));
+			distance = _mm_add_ps(distance, _mm_mul_ps(plane_y, center_y));
+			distance = _mm_add_ps(distance, _mm_mul_ps(plane_z, center_z));
+			distance = _mm_add_ps(distance, _mm_mul_ps(_mm_andnot_ps(sign_mask, plane_x), extent_x));
+			distance = _mm_add_ps(distance, _mm_mul_ps(_mm_andnot_ps(sign_mask, plane_y), extent_y));
+			distance = _mm_add_ps(distance, _mm_mul_ps(_mm_andnot_ps(sign_mask, plane_z), extent_z));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, zero));
+		}
+		const int mask = _mm_movemask_ps(inside);
+		for (uint32_t lane = 0; lane < 4; lane++)
+		{
+			visible[i + lane] = (mask >> lane) & 1;
+			visible_num += visible[i + lane];
+		}
+	}
+	return visible_num + CullScalar(planes, bounds, i, last, visible);
+}
+
+AVX2_TARGET static uint32_t CullAvx2(const FrustumPlanes& planes, const InstanceBounds& bounds, uint32_t first, uint32_t last, uint8_t* visible)
+{
+	const __m256 sign_mask = _mm256_set1_ps(-0.f);
+	const __m256 zero = _mm256_setzero_ps();
+	uint32_t visible_num = 0;
+	uint32_t i = first;
+	for (; i + 8 <= last; i += 8)
+	{
+		const __m256 center_x = _mm256_loadu_ps(bounds.GetCenterX() + i);
+		const __m256 center_y = _mm256_loadu_ps(bounds.GetCenterY() + i);
+		const __m256 center_z = _mm256_loadu_ps(bounds.GetCenterZ() + i);
+		const __m256 extent_x = _mm256_loadu_ps(bounds.GetExtentX() + i);
+		const __m256 extent_y = _mm256_loadu_ps(bounds.GetExtentY() + i);
+		const __m256 extent_z = _mm256_loadu_ps(bounds.GetExtentZ() + i);
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for (uint32_t plane = 0; plane < 6; plane++)
+		{
+			const __m256 plane_x = _mm256_set1_ps(planes.x[plane]);
+			const __m256 plane_y = _mm256_set1_ps(planes.y[plane]);
+			const __m256 plane_z = _mm256_set1_ps(planes.z[plane]);
+			__m256 distance = _mm256_add_ps(_mm256_mul_ps(plane_x, center_x), _mm256_set1_ps(planes.w[plane]));
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(plane_y, center_y));
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(plane_z, center_z));
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_andnot_ps(sign_mask, plane_x), extent_x));
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_andnot_ps(sign_mask, plane_y), extent_y));
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_andnot_ps(sign_mask, plane_z), extent_z));
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, zero, _CMP_GE_OQ));
+		}
+		const int mask = _mm256_movemask_ps(inside);
+		for (uint32_t lane = 0; lane < 8; lane++)
+		{
+			visible[i + lane] = (mask >> lane) & 1;
+			visible_num += visible[i + lane];
+		}
+	}
+	return visible_num + CullScalar(planes, bounds, i, last, visible);
+}
+
+FrustumCuller::FrustumCuller() :
+	kernel(HasAvx2() ? KERNEL_AVX2 : KERNEL_SSE2)
+{
+}
+
+bool FrustumCuller::HasAvx2()
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+	{
+		return false;
+	}
+	__cpuid(info, 1);
+	// The OS has to save the YMM registers too
+	const bool os_saves_ymm = (info[2] & (1 << 27)) && (_xgetbv(0) & 0x6) == 0x6;
+	const bool has_avx = (info[2] & (1 << 28)) != 0;
+	__cpuidex(info, 7, 0);
+	const bool has_avx2 = (info[1] & (1 << 5)) != 0;
+	return os_saves_ymm && has_avx && has_avx2;
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+uint32_t FrustumCuller::CullRange(const FrustumPlanes& planes, const InstanceBounds& bounds, uint32_t first, uint32_t last, uint8_t* visible) const
+{
+	switch (kernel)
+	{
+	case KERNEL_AVX2:
+		return CullAvx2(planes, bounds, first, last, visible);
+	case KERNEL_SSE2:
+		return CullSse2(planes, bounds, first, last, visible);
+	default:
+		return CullScalar(planes, bounds, first, last, visible);
+	}
+}
+
+uint32_t FrustumCuller::Cull(const FrustumPlanes& planes, const InstanceBounds& bounds, uint32_t instance_num, uint8_t* visible, JobSystem& jobs) const
+{
+	instance_num = std::min(instance_num, bounds.GetSize());
+	const uint32_t batch_num = (instance_num + cull_batch_size - 1) / cull_batch_size;
+	std::atomic<uint32_t> visible_num(0);
+	jobs.ParallelFor(batch_num, [&](uint32_t batch)
+	{
+		const uint32_t first = batch * cull_batch_size;
+		const uint32_t last = std::min(instance_num, first + cull_batch_size);
+		visible_num += CullRange(planes, bounds, first, last, visible);
+	});
+	return visible_num;
+}
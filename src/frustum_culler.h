@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+// Frustum planes in structure-of-arrays form, a point p is inside plane i
+// when x[i] * p.x + y[i] * p.y + z[i] * p.z + w[i] >= 0
+struct FrustumPlanes
+{
+	float x[6];
+	float y[6];
+	float z[6];
+	float w[6];
+
+	// Row-major matrix with clip = position * matrix and depth in [0, 1]
+	static FrustumPlanes FromViewProjection(const float* view_projection);
+};
+
+// Axis aligned boxes as center and extent arrays, padded to whole groups of 8
+class InstanceBounds
+{
+public:
+	static const uint32_t group_size = 8;
+
+	void Resize(uint32_t instance_num);
+	void Set(uint32_t instance, const float* min, const float* max);
+
+	uint32_t GetSize() const { return instance_num; }
+	const float* GetCenterX() const { return center_x.data(); }
+	const float* GetCenterY() const { return center_y.data(); }
+	const float* GetCenterZ() const { return center_z.data(); }
+	const float* GetExtentX() const { return extent_x.data(); }
+	const float* GetExtentY() const { return extent_y.data(); }
+	const float* GetExtentZ() const { return extent_z.data(); }
+
+protected:
+	uint32_t instance_num = 0;
+	std::vector<float> center_x;
+	std::vector<float> center_y;
+	std::vector<float> center_z;
+	std::vector<float> extent_x;
+	std::vector<float> extent_y;
+	std::vector<float> extent_z;
+};
+
+// Tests boxes against the six frustum planes, 8 per iteration with AVX2 and
+// 4 with SSE2 on CPUs without it. The kernel is picked once at construction.
+class FrustumCuller
+{
+public:
+	enum Kernel
+	{
+		KERNEL_SCALAR,
+		KERNEL_SSE2,
+		KERNEL_AVX2
+	};
+
+	FrustumCuller();
+
+	// Writes 1 for every box of [0, instance_num) touching the frustum, 0 otherwise, and returns the visible count
+	uint32_t Cull(const FrustumPlanes& planes, const InstanceBounds& bounds, uint32_t instance_num, uint8_t* visible, JobSystem& jobs) const;
+	uint32_t CullRange(const FrustumPlanes& planes, const InstanceBounds& bounds, uint32_t first, uint32_t last, uint8_t* visible) const;
+
+	Kernel GetKernel() const { return kernel; }
+	void SetKernel(Kernel kernel) { this->kernel = kernel; }
+	static bool HasAvx2();
+
+protected:
+	Kernel kernel;
+};
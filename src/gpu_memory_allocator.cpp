@@ -0,0 +1,141 @@
+#include "gpu_memory_allocator.h"
+
+GpuMemoryAllocator::GpuMemoryAllocator() : releases(nullptr)
+{
+}
+
+GpuMemoryAllocator::~GpuMemoryAllocator()
+{
+	Destroy();
+}
+
+void GpuMemoryAllocator::Create(ID3D12Device* device, DeferredReleaseQueue& releases, UINT64 heap_size)
+{
+	this->device = device;
+	this->releases = &releases;
+	for (UINT category = 0; category < HEAP_CATEGORY_NUM; category++)
+	{
+		allocators[category] = HeapAllocatorList(heap_size, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+	}
+}
+
+void GpuMemoryAllocator::Destroy()
+{
+	for (UINT category = 0; category < HEAP_CATEGORY_NUM; category++)
+	{
+		allocators[category] = HeapAllocatorList();
+		heaps[category].clear();
+	}
+	device.Reset();
+}
+
+void GpuMemoryAllocator::CreatePlacedResource(const D3D12_RESOURCE_DESC& descriptor, D3D12_RESOURCE_STATES initial_state,
+	const D3D12_CLEAR_VALUE* clear_value, ComPtr<ID3D12Resource>& resource, GpuAllocation& allocation)
+{
+	const D3D12_RESOURCE_ALLOCATION_INFO allocation_info = device->GetResourceAllocationInfo(0, 1, &descriptor);
+	const HeapCategory category = GetCategory(descriptor);
+
+	HeapAllocatorList& allocator = allocators[category];
+	HeapAllocatorList::Block block = {};
+	if (!allocator.Allocate(allocation_info.SizeInBytes, allocation_info.Alignment, block))
+	{
+		// Oversized resources get a heap of their own rounded up to a power of two
+		CreateHeap(category, allocator.GetNewHeapSize(allocation_info.SizeInBytes));
+		if (!allocator.Allocate(allocation_info.SizeInBytes, allocation_info.Alignment, block))
+		{
+			ThrowIfFailed(E_OUTOFMEMORY);
+		}
+	}
+	allocation.category = category;
+	allocation.heap_index = block.heap_index;
+	allocation.offset = block.offset;
+	allocation.size = allocation_info.SizeInBytes;
+
+	ThrowIfFailed(device->CreatePlacedResource(
+		heaps[category][allocation.heap_index].Get(),
+		allocation.offset,
+		&descriptor,
+		initial_state,
+		clear_value,
+		IID_PPV_ARGS(&resource)));
+}
+
+void GpuMemoryAllocator::Free(const GpuAllocation& allocation)
+{
+	allocators[allocation.category].Free({ allocation.heap_index, allocation.offset });
+}
+
+void GpuMemoryAllocator::Release(ComPtr<ID3D12Resource>& resource, const GpuAllocation& allocation)
+{
+	// The resource goes first, a placed resource must not outlive the memory under it
+	ComPtr<ID3D12Resource> released = std::move(resource);
+	releases->Release([this, released, allocation]() mutable
+	{
+		released.Reset();
+		Free(allocation);
+	}, allocation.size);
+}
+
+HeapAllocatorStatistics GpuMemoryAllocator::GetStatistics(HeapCategory category) const
+{
+	return allocators[category].GetStatistics();
+}
+
+HeapAllocatorStatistics GpuMemoryAllocator::GetStatistics() const
+{
+	HeapAllocatorStatistics statistics = {};
+	for (UINT category = 0; category < HEAP_CATEGORY_NUM; category++)
+	{
+		statistics += GetStatistics(static_cast<HeapCategory>(category));
+	}
+	return statistics;
+}
+
+std::wstring GpuMemoryAllocator::GetStatisticsString() const
+{
+	const WCHAR* category_names[HEAP_CATEGORY_NUM] = { L"Buffers", L"Textures", L"Render targets" };
+	std::wstring result;
+	for (UINT category = 0; category < HEAP_CATEGORY_NUM; category++)
+	{
+		HeapAllocatorStatistics statistics = GetStatistics(static_cast<HeapCategory>(category));
+		result += std::wstring(category_names[category]) +
+			L": heaps " + std::to_wstring(heaps[category].size()) +
+			L", allocations " + std::to_wstring(statistics.allocation_num) +
+			L", used " + std::to_wstring(statistics.used_size / 1024) + L" KB" +
+			L" of " + std::to_wstring(statistics.size / 1024) + L" KB" +
+			L", utilization " + std::to_wstring(statistics.GetUtilization()) +
+			L", fragmentation " + std::to_wstring(statistics.GetFragmentation()) + L"\n";
+	}
+	return result;
+}
+
+HeapCategory GpuMemoryAllocator::GetCategory(const D3D12_RESOURCE_DESC& descriptor)
+{
+	if (descriptor.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+	{
+		return HEAP_CATEGORY_BUFFER;
+	}
+	if (descriptor.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL))
+	{
+		return HEAP_CATEGORY_RENDER_TARGET;
+	}
+	return HEAP_CATEGORY_TEXTURE;
+}
+
+UINT GpuMemoryAllocator::CreateHeap(HeapCategory category, UINT64 size)
+{
+	const D3D12_HEAP_FLAGS category_flags[HEAP_CATEGORY_NUM] = {
+		D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS,
+		D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES,
+		D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES
+	};
+
+	CD3DX12_HEAP_DESC heap_descriptor(size, D3D12_HEAP_TYPE_DEFAULT,
+		D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT, category_flags[category]);
+
+	ComPtr<ID3D12Heap> heap;
+	ThrowIfFailed(device->CreateHeap(&heap_descriptor, IID_PPV_ARGS(&heap)));
+	heap->SetName(L"Resource heap");
+	heaps[category].push_back(heap);
+	return allocators[category].AddHeap(size);
+}
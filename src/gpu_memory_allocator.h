@@ -0,0 +1,56 @@
+#pragma once
+
+#include "dx12_labs.h"
+#include "deferred_release_queue.h"
+#include "heap_allocator.h"
+
+// Resource heap tier 1 hardware cannot mix these in one heap
+enum HeapCategory
+{
+	HEAP_CATEGORY_BUFFER = 0,
+	HEAP_CATEGORY_TEXTURE,
+	HEAP_CATEGORY_RENDER_TARGET,
+	HEAP_CATEGORY_NUM
+};
+
+struct GpuAllocation
+{
+	HeapCategory category;
+	UINT heap_index;
+	UINT64 offset;
+	UINT64 size;
+};
+
+// Carves placed resources out of large default heaps, one heap list per category.
+class GpuMemoryAllocator
+{
+public:
+	static const UINT64 default_heap_size = 64 * 1024 * 1024;
+
+	GpuMemoryAllocator();
+	~GpuMemoryAllocator();
+
+	void Create(ID3D12Device* device, DeferredReleaseQueue& releases, UINT64 heap_size = default_heap_size);
+	void Destroy();
+
+	void CreatePlacedResource(const D3D12_RESOURCE_DESC& descriptor, D3D12_RESOURCE_STATES initial_state,
+		const D3D12_CLEAR_VALUE* clear_value, ComPtr<ID3D12Resource>& resource, GpuAllocation& allocation);
+	// Returns the block to the buddy allocator of its heap. The resource placed there
+	// must be released and no longer in use by the GPU.
+	void Free(const GpuAllocation& allocation);
+	// Drops the resource and frees its block once the submissions that may use it retire
+	void Release(ComPtr<ID3D12Resource>& resource, const GpuAllocation& allocation);
+
+	HeapAllocatorStatistics GetStatistics(HeapCategory category) const;
+	HeapAllocatorStatistics GetStatistics() const;
+	std::wstring GetStatisticsString() const;
+
+protected:
+	static HeapCategory GetCategory(const D3D12_RESOURCE_DESC& descriptor);
+	UINT CreateHeap(HeapCategory category, UINT64 size);
+
+	ComPtr<ID3D12Device> device;
+	DeferredReleaseQueue* releases;
+	HeapAllocatorList allocators[HEAP_CATEGORY_NUM];
+	std::vector<ComPtr<ID3D12Heap>> heaps[HEAP_CATEGORY_NUM];
+};
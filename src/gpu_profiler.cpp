@@ -0,0 +1,190 @@
+#include "gpu_profiler.h"
+
+GpuProfiler::GpuProfiler() : readback_data(nullptr), command_queue(nullptr), next_submission(0), gpu_frequency(1), gpu_calibration(0), cpu_calibration(0)
+{
+}
+
+GpuProfiler::~GpuProfiler()
+{
+	Destroy();
+}
+
+void GpuProfiler::Create(ID3D12Device* device, ID3D12CommandQueue* command_queue, UINT slot_num, UINT submission_num)
+{
+	this->command_queue = command_queue;
+	slots.resize(slot_num);
+	submissions.resize(submission_num);
+	next_submission = 0;
+	for (Submission& submission : submissions)
+	{
+		ThrowIfFailed(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&submission.command_allocator)));
+		ThrowIfFailed(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, submission.command_allocator.Get(),
+			nullptr, IID_PPV_ARGS(&submission.begin_list)));
+		ThrowIfFailed(submission.begin_list->Close());
+		ThrowIfFailed(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, submission.command_allocator.Get(),
+			nullptr, IID_PPV_ARGS(&submission.end_list)));
+		ThrowIfFailed(submission.end_list->Close());
+		submission.pending = false;
+	}
+
+	D3D12_QUERY_HEAP_DESC query_heap_descriptor = {};
+	query_heap_descriptor.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+	query_heap_descriptor.Count = GetFrameQuery(submission_num);
+	ThrowIfFailed(device->CreateQueryHeap(&query_heap_descriptor, IID_PPV_ARGS(&query_heap)));
+
+	ThrowIfFailed(device->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(GetReadbackOffset(submission_num)),
+		D3D12_RESOURCE_STATE_COPY_DEST,
+		nullptr,
+		IID_PPV_ARGS(&readback_buffer)));
+	readback_buffer->SetName(L"Timestamp readback buffer");
+
+	// Stays mapped, a region is only read after the fence of its resolve passed
+	ThrowIfFailed(readback_buffer->Map(0, nullptr, reinterpret_cast<void**>(&readback_data)));
+
+	ThrowIfFailed(command_queue->GetTimestampFrequency(&gpu_frequency));
+	Calibrate();
+}
+
+void GpuProfiler::Destroy()
+{
+	if (readback_buffer && readback_data)
+	{
+		CD3DX12_RANGE written_range(0, 0);
+		readback_buffer->Unmap(0, &written_range);
+	}
+	readback_data = nullptr;
+	readback_buffer.Reset();
+	query_heap.Reset();
+	slots.clear();
+	submissions.clear();
+	pending_readbacks.clear();
+}
+
+void GpuProfiler::BeginFrame(UINT slot)
+{
+	slots[slot].ranges.clear();
+	slots[slot].open_ranges.clear();
+}
+
+// Named ranges cost a query pair each, only profiler builds record them
+void GpuProfiler::BeginRange(ID3D12GraphicsCommandList* list, UINT slot, const char* name)
+{
+#ifdef ENABLE_PROFILER
+	Slot& frame_slot = slots[slot];
+	if (frame_slot.ranges.size() >= max_range_num)
+	{
+		ThrowIfFailed(E_OUTOFMEMORY);
+	}
+	const UINT range = static_cast<UINT>(frame_slot.ranges.size());
+	frame_slot.ranges.push_back({ name, range * 2, range * 2 + 1 });
+	frame_slot.open_ranges.push_back(range);
+	list->EndQuery(query_heap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, GetQuery(slot, range * 2));
+#endif
+}
+
+void GpuProfiler::EndRange(ID3D12GraphicsCommandList* list, UINT slot)
+{
+#ifdef ENABLE_PROFILER
+	Slot& frame_slot = slots[slot];
+	const UINT range = frame_slot.open_ranges.back();
+	frame_slot.open_ranges.pop_back();
+	list->EndQuery(query_heap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, GetQuery(slot, frame_slot.ranges[range].end_query));
+#endif
+}
+
+void GpuProfiler::Submit(UINT slot, UINT64 fence_value, uint64_t statistics_frame,
+	const std::vector<ID3D12CommandList*>& frame_lists, std::vector<ID3D12CommandList*>& executed_lists)
+{
+	// Every submission resolves into its own region, so a resubmitted slot cannot overwrite
+	// timestamps not collected yet. The region is free once its previous fence was collected.
+	const UINT submission_index = next_submission;
+	next_submission = (next_submission + 1) % static_cast<UINT>(submissions.size());
+	Submission& submission = submissions[submission_index];
+	if (submission.pending)
+	{
+		ThrowIfFailed(E_FAIL);
+	}
+	submission.pending = true;
+
+	const UINT frame_query = GetFrameQuery(submission_index);
+	ThrowIfFailed(submission.command_allocator->Reset());
+	ThrowIfFailed(submission.begin_list->Reset(submission.command_allocator.Get(), nullptr));
+	submission.begin_list->EndQuery(query_heap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, frame_query);
+	ThrowIfFailed(submission.begin_list->Close());
+
+	// Only the range queries written when the slot was recorded, resolving unwritten ones is invalid
+	const UINT64 region_offset = GetReadbackOffset(submission_index);
+	const UINT range_query_num = static_cast<UINT>(slots[slot].ranges.size()) * 2;
+	ThrowIfFailed(submission.end_list->Reset(submission.command_allocator.Get(), nullptr));
+	submission.end_list->EndQuery(query_heap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, frame_query + 1);
+	submission.end_list->ResolveQueryData(query_heap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, frame_query, 2,
+		readback_buffer.Get(), region_offset);
+	if (range_query_num > 0)
+	{
+		submission.end_list->ResolveQueryData(query_heap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, GetQuery(slot, 0), range_query_num,
+			readback_buffer.Get(), region_offset + 2 * sizeof(UINT64));
+	}
+	ThrowIfFailed(submission.end_list->Close());
+
+	executed_lists.clear();
+	executed_lists.push_back(submission.begin_list.Get());
+	executed_lists.insert(executed_lists.end(), frame_lists.begin(), frame_lists.end());
+	executed_lists.push_back(submission.end_list.Get());
+	pending_readbacks.push_back({ submission_index, fence_value, Profiler::Get().GetFrame(), statistics_frame, slots[slot].ranges });
+}
+
+void GpuProfiler::Collect(UINT64 completed_fence_value, FrameStatistics& statistics)
+{
+	bool calibrated = false;
+	size_t kept = 0;
+	for (size_t i = 0; i < pending_readbacks.size(); i++)
+	{
+		PendingReadback& readback = pending_readbacks[i];
+		if (readback.fence_value > completed_fence_value)
+		{
+			if (kept != i)
+			{
+				pending_readbacks[kept] = std::move(readback);
+			}
+			kept++;
+			continue;
+		}
+		// Only ranges go onto the CPU clock, the frame time is a plain difference
+		if (!calibrated && !readback.ranges.empty())
+		{
+			Calibrate();
+			calibrated = true;
+		}
+		submissions[readback.submission].pending = false;
+		const UINT64* timestamps = readback_data + GetReadbackOffset(readback.submission) / sizeof(UINT64);
+		statistics.SetGpuTime(readback.statistics_frame, static_cast<float>((timestamps[1] - timestamps[0]) * 1000.0 / gpu_frequency));
+		const UINT64* range_timestamps = timestamps + 2;
+		for (const Range& range : readback.ranges)
+		{
+			Profiler::Get().AddGpuRange(range.name, readback.frame,
+				ToCpuTime(range_timestamps[range.begin_query]), ToCpuTime(range_timestamps[range.end_query]));
+		}
+	}
+	pending_readbacks.resize(kept);
+}
+
+uint64_t GpuProfiler::ToCpuTime(UINT64 timestamp) const
+{
+	const double gpu_time = static_cast<double>(static_cast<INT64>(timestamp - gpu_calibration)) / gpu_frequency;
+	return cpu_calibration + static_cast<int64_t>(gpu_time * 1e9);
+}
+
+void GpuProfiler::Calibrate()
+{
+	UINT64 cpu_ticks;
+	ThrowIfFailed(command_queue->GetClockCalibration(&gpu_calibration, &cpu_ticks));
+
+	// Same conversion as steady_clock, split so the multiply does not overflow
+	LARGE_INTEGER cpu_frequency;
+	QueryPerformanceFrequency(&cpu_frequency);
+	const UINT64 frequency = static_cast<UINT64>(cpu_frequency.QuadPart);
+	cpu_calibration = (cpu_ticks / frequency) * 1000000000ull + (cpu_ticks % frequency) * 1000000000ull / frequency;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "dx12_labs.h"
+#include "profiler.h"
+#include "frame_statistics.h"
+
+// GPU timestamps of a frame. Every submission is wrapped in two small lists
+// of its own: the first writes the frame's begin timestamp, the last its end
+// timestamp and resolves everything into the submission's readback region,
+// read once its fence passed, a few frames later. The frame pair is always
+// on and feeds the GPU time of the frame statistics. Named ranges around the
+// passes need ENABLE_PROFILER; every frame context owns a slot of them, and
+// since cached lists are submitted again without re-recording, the slot is
+// resolved per submission rather than by the frame's own lists. Ranges reach
+// the Profiler on the CPU clock, so both tracks line up in a trace.
+class GpuProfiler
+{
+public:
+	static const UINT max_range_num = 16;
+
+	GpuProfiler();
+	~GpuProfiler();
+
+	// At most submission_num submissions may be in flight, Collect has to run in between
+	void Create(ID3D12Device* device, ID3D12CommandQueue* command_queue, UINT slot_num, UINT submission_num);
+	void Destroy();
+
+	// Forgets the ranges of a slot before its lists are recorded again
+	void BeginFrame(UINT slot);
+	// Ranges nest and may span lists, as long as the lists execute in recording order
+	void BeginRange(ID3D12GraphicsCommandList* list, UINT slot, const char* name);
+	void EndRange(ID3D12GraphicsCommandList* list, UINT slot);
+
+	// A submission of the slot's lists, readable once fence_value completes. Fills
+	// executed_lists with frame_lists between the timestamp lists, to execute in one call.
+	void Submit(UINT slot, UINT64 fence_value, uint64_t statistics_frame,
+		const std::vector<ID3D12CommandList*>& frame_lists, std::vector<ID3D12CommandList*>& executed_lists);
+	// Hands each frame's GPU time to the statistics and resolved ranges to the Profiler
+	void Collect(UINT64 completed_fence_value, FrameStatistics& statistics);
+
+protected:
+	struct Range
+	{
+		const char* name;
+		UINT begin_query;
+		UINT end_query;
+	};
+
+	struct Slot
+	{
+		std::vector<Range> ranges;
+		std::vector<UINT> open_ranges;
+	};
+
+	// Timestamp lists, frame queries and readback region of one submission, reused round robin
+	struct Submission
+	{
+		ComPtr<ID3D12CommandAllocator> command_allocator;
+		ComPtr<ID3D12GraphicsCommandList> begin_list;
+		ComPtr<ID3D12GraphicsCommandList> end_list;
+		bool pending;
+	};
+
+	struct PendingReadback
+	{
+		UINT submission;
+		UINT64 fence_value;
+		uint64_t frame;
+		uint64_t statistics_frame;
+		std::vector<Range> ranges;
+	};
+
+	static const UINT queries_per_slot = max_range_num * 2;
+	// A region holds the frame's begin and end, then the slot's ranges
+	static const UINT readback_region_size = 2 + queries_per_slot;
+
+	UINT GetQuery(UINT slot, UINT query) const { return slot * queries_per_slot + query; }
+	// The frame pairs follow the range queries of every slot
+	UINT GetFrameQuery(UINT submission) const { return static_cast<UINT>(slots.size()) * queries_per_slot + submission * 2; }
+	UINT64 GetReadbackOffset(UINT submission) const { return static_cast<UINT64>(submission) * readback_region_size * sizeof(UINT64); }
+	uint64_t ToCpuTime(UINT64 timestamp) const;
+	void Calibrate();
+
+	ComPtr<ID3D12QueryHeap> query_heap;
+	ComPtr<ID3D12Resource> readback_buffer;
+	UINT64* readback_data;
+	ID3D12CommandQueue* command_queue;
+	std::vector<Slot> slots;
+	std::vector<Submission> submissions;
+	UINT next_submission;
+	std::vector<PendingReadback> pending_readbacks;
+
+	// Matching GPU and CPU instants, refreshed on every collect against drift
+	UINT64 gpu_frequency;
+	UINT64 gpu_calibration;
+	uint64_t cpu_calibration;
+};
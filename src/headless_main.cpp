@@ -0,0 +1,128 @@
+#include "camera_benchmark.h"
+#include "headless_renderer.h"
+#include "job_system.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Box faces as corner indices, bit 0 picks max x, bit 1 max y, bit 2 max z
+static const uint32_t box_faces[6][4] = {
+	{ 0, 2, 6, 4 }, { 1, 5, 7, 3 }, { 0, 4, 5, 1 }, { 2, 3, 7, 6 }, { 0, 1, 3, 2 }, { 4, 6, 7, 5 } };
+
+// A box draw with four vertices per face, as a textured mesh would have
+static void AddBox(const float* min, const float* max, uint32_t texture_index,
+	std::vector<HeadlessDraw>& draws, std::vector<float>& positions, std::vector<uint32_t>& indices)
+{
+	HeadlessDraw draw = {};
+	std::copy(min, min + 3, draw.min);
+	std::copy(max, max + 3, draw.max);
+	draw.start_index = static_cast<uint32_t>(indices.size());
+	draw.start_vertex = static_cast<uint32_t>(positions.size() / 3);
+	draw.texture_index = texture_index;
+	for (uint32_t face = 0; face < 6; face++)
+	{
+		const uint32_t face_vertex = face * 4;
+		for (uint32_t corner : box_faces[face])
+		{
+			positions.push_back(corner & 1 ? max[0] : min[0]);
+			positions.push_back(corner & 2 ? max[1] : min[1]);
+			positions.push_back(corner & 4 ? max[2] : min[2]);
+		}
+		for (uint32_t index : { 0u, 1u, 2u, 0u, 2u, 3u })
+		{
+			indices.push_back(face_vertex + index);
+		}
+	}
+	draw.index_num = static_cast<uint32_t>(indices.size()) - draw.start_index;
+	draws.push_back(draw);
+}
+
+// Grid of boxes around the origin, each with its own index range and one of a few textures,
+// split by a wall the occlusion culler picks as occluder
+static void BuildGridScene(std::vector<HeadlessDraw>& draws, std::vector<float>& positions, std::vector<uint32_t>& indices,
+	uint32_t& texture_num)
+{
+	const int grid_size = 32;
+	const float spacing = 0.5f;
+	texture_num = 16;
+	for (int x = 0; x < grid_size; x++)
+	{
+		for (int z = 0; z < grid_size; z++)
+		{
+			const float center_x = (x - grid_size / 2) * spacing;
+			const float center_z = (z - grid_size / 2) * spacing;
+			const float min[3] = { center_x - 0.2f, 0.f, center_z - 0.2f };
+			const float max[3] = { center_x + 0.2f, 0.4f, center_z + 0.2f };
+			AddBox(min, max, static_cast<uint32_t>(x * 7 + z * 3) % texture_num, draws, positions, indices);
+		}
+	}
+	// Between two rows, so no box pokes through it
+	const float wall_min[3] = { -8.f, 0.f, 0.22f };
+	const float wall_max[3] = { 8.f, 2.f, 0.28f };
+	AddBox(wall_min, wall_max, 0, draws, positions, indices);
+}
+
+// Plays the benchmark camera path on the null device and writes the same report as the window build.
+// Fails when the device saw invalid barriers or descriptor use, so it doubles as a regression run.
+int main(int argument_num, char** argument_values)
+{
+	std::vector<std::string> arguments(argument_values + 1, argument_values + argument_num);
+	BenchmarkOptions options = ParseBenchmarkOptions(arguments);
+
+	CameraPath path = CameraPath::MakeOrbit();
+	if (!options.path_file.empty())
+	{
+		std::ifstream path_file(options.path_file);
+		if (!path_file || !path.Load(path_file))
+		{
+			fprintf(stderr, "Invalid camera path file %s\n", options.path_file.c_str());
+			return 1;
+		}
+	}
+
+	JobSystem jobs;
+	HeadlessRenderer renderer(jobs, 1280, 720);
+	std::vector<HeadlessDraw> draws;
+	std::vector<float> positions;
+	std::vector<uint32_t> indices;
+	uint32_t texture_num = 0;
+	BuildGridScene(draws, positions, indices, texture_num);
+	renderer.Load(draws, positions, indices, texture_num);
+
+	// No GPU, so frame time is the CPU time of the frame and GPU time stays unknown
+	FrameStatistics statistics;
+	CameraBenchmark benchmark(path, options.time_step);
+	uint32_t occluded_num = 0;
+	while (!benchmark.IsFinished())
+	{
+		const CameraSnapshot camera = benchmark.Step();
+		const std::chrono::high_resolution_clock::time_point start_time = std::chrono::high_resolution_clock::now();
+		const HeadlessFrame frame = renderer.RenderFrame(camera);
+		const std::chrono::duration<float, std::milli> cpu_time = std::chrono::high_resolution_clock::now() - start_time;
+		occluded_num += frame.occlusion_culled_num;
+		benchmark.AddFrame(statistics.AddFrame(cpu_time.count(), cpu_time.count(), frame.draw_num, frame.triangle_num, frame.state_change_num));
+	}
+
+	const std::string report_path = options.report_file.empty() ? "headless_report.json" : options.report_file;
+	std::ofstream report_file(report_path);
+	benchmark.WriteReport(report_file, statistics, "synthetic grid");
+
+	const NullDevice& device = renderer.GetDevice();
+	const NullCommandCounts& counts = device.GetCounts();
+	printf("%u frames, %u lists, %u barriers, %u state changes, %u draws, %u occluded, report written to %s\n",
+		benchmark.GetStepNum(), counts.list_num, counts.barrier_num, counts.state_change_num, counts.draw_num, occluded_num, report_path.c_str());
+	for (const std::string& error : device.GetErrors())
+	{
+		fprintf(stderr, "%s\n", error.c_str());
+	}
+	if (!device.IsValid())
+	{
+		fprintf(stderr, "%u validation errors\n", device.GetErrorNum());
+		return 1;
+	}
+	return 0;
+}
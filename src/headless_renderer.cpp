@@ -0,0 +1,136 @@
+#include "headless_renderer.h"
+
+#include "job_system.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+HeadlessRenderer::HeadlessRenderer(JobSystem& jobs, uint32_t width, uint32_t height, uint32_t max_list_num) :
+	jobs(jobs), width(width), height(height), max_list_num(std::max(max_list_num, 1u)), frame_graph(),
+	frame_constants(frame_constants_size), constant_memory(frame_constants_size)
+{
+	// Clear list, draw lists, end list
+	command_lists.resize(this->max_list_num + 2);
+}
+
+void HeadlessRenderer::Load(const std::vector<HeadlessDraw>& draws, const std::vector<float>& positions, const std::vector<uint32_t>& indices,
+	uint32_t texture_num)
+{
+	PROFILE_SCOPE("Load headless scene");
+	this->draws = draws;
+	this->positions = positions;
+	this->indices = indices;
+
+	// Same graph as the renderer, a 32-bit depth buffer in a 64K placed resource
+	const uint64_t depth_alignment = 64 * 1024;
+	frame_graph = BuildFrameGraph(render_graph, static_cast<uint64_t>(width) * height * 4, depth_alignment);
+	device.CreateGraphResources(render_graph);
+
+	// Texture views are written once, texture indices are the draw key material ids
+	const uint32_t heap_size = std::max(texture_num, 1u);
+	descriptor_allocator.Reset(heap_size);
+	device.SetDescriptorHeapSize(heap_size);
+	texture_descriptors.resize(texture_num);
+	for (uint32_t texture = 0; texture < texture_num; texture++)
+	{
+		texture_descriptors[texture] = descriptor_allocator.Allocate(1);
+		device.WriteDescriptor(texture_descriptors[texture]);
+	}
+	device.SetMaterialDescriptors(texture_descriptors);
+
+	std::vector<NullDraw> geometry(draws.size());
+	std::vector<OcclusionBounds> bounds(draws.size());
+	std::vector<uint32_t> material_ids(draws.size());
+	std::vector<OccluderMesh> meshes(draws.size());
+	for (uint32_t draw_id = 0; draw_id < draws.size(); draw_id++)
+	{
+		// Out of range textures go through as is, the device reports them
+		const HeadlessDraw& draw = draws[draw_id];
+		geometry[draw_id] = { draw.index_num, draw.start_index, draw.start_vertex };
+		bounds[draw_id] = { { draw.min[0], draw.min[1], draw.min[2] }, { draw.max[0], draw.max[1], draw.max[2] } };
+		material_ids[draw_id] = draw.texture_index;
+		meshes[draw_id] = { this->positions.data(), 3 * sizeof(float), this->indices.data() + draw.start_index, draw.index_num, draw.start_vertex };
+	}
+	device.SetGeometry(geometry, static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(positions.size() / 3));
+	draw_stages.SetDraws(bounds, material_ids);
+	draw_stages.SelectOccluders(meshes);
+}
+
+HeadlessFrame HeadlessRenderer::RenderFrame(const CameraSnapshot& camera)
+{
+	PROFILE_SCOPE("Headless frame");
+	const FrameView view = FrameView::FromCamera(camera, static_cast<float>(width) / height);
+	draw_stages.BuildDrawPackets(view, static_cast<uint32_t>(draws.size()), options, jobs);
+	const std::vector<DrawPacket>& draw_packets = draw_stages.GetDrawPackets();
+
+	// Pass constants and a slice per draw packet as the renderer writes them, the model is drawn untransformed
+	const float world[16] = { 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f };
+	frame_constants.Reset();
+	AllocateConstants(view.view_projection, sizeof(view.view_projection));
+	for (size_t packet = 0; packet < draw_packets.size(); packet++)
+	{
+		AllocateConstants(world, sizeof(world));
+	}
+
+	HeadlessFrame frame = {};
+	const uint32_t draw_num = static_cast<uint32_t>(draw_packets.size());
+	for (const DrawPacket& packet : draw_packets)
+	{
+		frame.triangle_num += draws[packet.draw_id].index_num / 3;
+	}
+	frame.draw_num = draw_num;
+	frame.frustum_culled_num = draw_stages.GetFrustumCulledNum();
+	frame.occlusion_culled_num = draw_stages.GetOcclusionCulledNum();
+
+	// Clears, then the barriers of the scene pass so the draw lists start from the right states
+	NullCommandList& clear_list = command_lists[0];
+	clear_list.Reset();
+	RecordClearPass(clear_list, render_graph, frame_graph);
+	clear_list.RecordBatch(render_graph, frame_graph.scene_pass);
+
+	const uint32_t list_num = DrawStages::GetListNum(draw_num, max_list_num);
+	std::vector<DrawStateChanges> state_changes(list_num);
+	jobs.ParallelFor(list_num, [&](uint32_t list_index)
+	{
+		PROFILE_SCOPE("Record draws");
+		const uint32_t first_draw = DrawStages::GetListDraw(draw_num, list_num, list_index);
+		const uint32_t last_draw = DrawStages::GetListDraw(draw_num, list_num, list_index + 1);
+		NullCommandList& list = command_lists[list_index + 1];
+		list.Reset();
+		BeginSceneDraws(list, frame_graph);
+		state_changes[list_index] = SubmitDrawPackets(draw_packets.data() + first_draw, draw_packets.data() + last_draw, &list);
+	});
+	for (const DrawStateChanges& changes : state_changes)
+	{
+		frame.state_change_num += changes.GetTotal();
+	}
+
+	NullCommandList& end_list = command_lists[max_list_num + 1];
+	end_list.Reset();
+	RecordFrameEnd(end_list, render_graph);
+
+	submitted_lists.clear();
+	for (uint32_t list = 0; list <= list_num; list++)
+	{
+		submitted_lists.push_back(&command_lists[list]);
+	}
+	submitted_lists.push_back(&end_list);
+	frame.list_num = static_cast<uint32_t>(submitted_lists.size());
+
+	device.Execute(submitted_lists.data(), frame.list_num);
+	device.Present(frame_graph.back_buffer_resource);
+	return frame;
+}
+
+uint64_t HeadlessRenderer::AllocateConstants(const void* data, uint64_t size)
+{
+	const uint64_t offset = frame_constants.Allocate(size, constant_alignment);
+	if (offset == LinearAllocator::invalid_offset)
+	{
+		throw std::runtime_error("Frame constants out of memory");
+	}
+	memcpy(constant_memory.data() + offset, data, static_cast<size_t>(size));
+	return offset;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "camera_controller.h"
+#include "descriptor_allocator.h"
+#include "draw_packet.h"
+#include "frame_graph.h"
+#include "frame_stages.h"
+#include "linear_allocator.h"
+#include "null_device.h"
+#include "render_graph.h"
+
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+// A draw of the scene: its bounds and index range, and the texture it samples.
+// Indices are relative to start_vertex, like the renderer's draw calls.
+struct HeadlessDraw
+{
+	float min[3];
+	float max[3];
+	uint32_t index_num;
+	uint32_t start_index;
+	uint32_t start_vertex;
+	uint32_t texture_index;
+};
+
+// Counts of the last frame
+struct HeadlessFrame
+{
+	uint32_t draw_num;
+	uint32_t triangle_num;
+	uint32_t state_change_num;
+	uint32_t list_num;
+	uint32_t frustum_culled_num;
+	uint32_t occlusion_culled_num;
+};
+
+// The renderer's frame loop without a GPU: the same frame graph, draw
+// stages and parallel recording, executed on NullDevice. Descriptors and
+// frame constants come from the renderer's allocators minus their heaps.
+// Runs on any platform, for benchmarks of the CPU side and for checking that
+// barriers and descriptor use stay valid when the frame code changes.
+class HeadlessRenderer
+{
+public:
+	HeadlessRenderer(JobSystem& jobs, uint32_t width, uint32_t height, uint32_t max_list_num = 8);
+
+	// Textures get descriptors in load order, draw texture indices refer to that order.
+	// Positions are float3 per vertex, large draws among them become occluders.
+	void Load(const std::vector<HeadlessDraw>& draws, const std::vector<float>& positions, const std::vector<uint32_t>& indices,
+		uint32_t texture_num);
+	HeadlessFrame RenderFrame(const CameraSnapshot& camera);
+
+	void SetOptions(const DrawStageOptions& options) { this->options = options; }
+	uint32_t GetOccluderNum() const { return draw_stages.GetOccluderNum(); }
+	uint64_t GetConstantHighWaterMark() const { return frame_constants.GetHighWaterMark(); }
+
+	const NullDevice& GetDevice() const { return device; }
+	NullDevice& GetDevice() { return device; }
+	const RenderGraph& GetRenderGraph() const { return render_graph; }
+
+protected:
+	// Same placement as D3D12 root CBVs
+	static const uint64_t constant_alignment = 256;
+	// Same size as the renderer's per-frame constant buffer
+	static const uint64_t frame_constants_size = 1024 * 1024;
+
+	uint64_t AllocateConstants(const void* data, uint64_t size);
+
+	JobSystem& jobs;
+	uint32_t width;
+	uint32_t height;
+	uint32_t max_list_num;
+
+	NullDevice device;
+	RenderGraph render_graph;
+	FrameGraph frame_graph;
+	// Draw lists between the clear list and the end list
+	std::vector<NullCommandList> command_lists;
+	std::vector<const NullCommandList*> submitted_lists;
+
+	DescriptorFreeList descriptor_allocator;
+	std::vector<uint32_t> texture_descriptors;
+
+	// Stands in for the mapped constant buffer, every frame retires before the next one starts
+	LinearAllocator frame_constants;
+	std::vector<uint8_t> constant_memory;
+
+	std::vector<HeadlessDraw> draws;
+	std::vector<float> positions;
+	std::vector<uint32_t> indices;
+	DrawStages draw_stages;
+	DrawStageOptions options;
+};
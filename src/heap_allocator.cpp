@@ -0,0 +1,187 @@
+#include "heap_allocator.h"
+
+#include <algorithm>
+
+float HeapAllocatorStatistics::GetUtilization() const
+{
+	if (size == 0)
+	{
+		return 0.f;
+	}
+	return static_cast<float>(requested_size) / static_cast<float>(size);
+}
+
+float HeapAllocatorStatistics::GetFragmentation() const
+{
+	const uint64_t free_size = size - used_size;
+	if (free_size == 0)
+	{
+		return 0.f;
+	}
+	return 1.f - static_cast<float>(largest_free_block) / static_cast<float>(free_size);
+}
+
+HeapAllocatorStatistics& HeapAllocatorStatistics::operator+=(const HeapAllocatorStatistics& other)
+{
+	size += other.size;
+	used_size += other.used_size;
+	requested_size += other.requested_size;
+	largest_free_block = std::max(largest_free_block, other.largest_free_block);
+	allocation_num += other.allocation_num;
+	free_block_num += other.free_block_num;
+	return *this;
+}
+
+BuddyAllocator::BuddyAllocator(uint64_t size, uint64_t min_block_size) :
+	heap_size(size), min_block_size(min_block_size), level_num(1), used_size(0), requested_size(0)
+{
+	while (GetBlockSize(level_num - 1) > min_block_size)
+	{
+		level_num++;
+	}
+	free_blocks.resize(level_num);
+	free_blocks[0].insert(0);
+}
+
+uint64_t BuddyAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+	const uint64_t block_size = std::max(std::max(size, alignment), min_block_size);
+	if (size == 0 || block_size > heap_size)
+	{
+		return invalid_offset;
+	}
+
+	// Deepest level whose blocks still fit the request
+	uint32_t level = 0;
+	while (level + 1 < level_num && GetBlockSize(level + 1) >= block_size)
+	{
+		level++;
+	}
+
+	// Find the closest level with a free block and split it down
+	int32_t source_level = static_cast<int32_t>(level);
+	while (source_level >= 0 && free_blocks[source_level].empty())
+	{
+		source_level--;
+	}
+	if (source_level < 0)
+	{
+		return invalid_offset;
+	}
+
+	uint64_t offset = *free_blocks[source_level].begin();
+	free_blocks[source_level].erase(free_blocks[source_level].begin());
+	for (uint32_t split_level = source_level + 1; split_level <= level; split_level++)
+	{
+		free_blocks[split_level].insert(offset + GetBlockSize(split_level));
+	}
+
+	Allocation allocation = {};
+	allocation.level = level;
+	allocation.requested_size = size;
+	allocations[offset] = allocation;
+	used_size += GetBlockSize(level);
+	requested_size += size;
+	return offset;
+}
+
+void BuddyAllocator::Free(uint64_t offset)
+{
+	auto allocation = allocations.find(offset);
+	if (allocation == allocations.end())
+	{
+		return;
+	}
+
+	uint32_t level = allocation->second.level;
+	used_size -= GetBlockSize(level);
+	requested_size -= allocation->second.requested_size;
+	allocations.erase(allocation);
+
+	// Merge with the buddy for as long as it is free too
+	while (level > 0)
+	{
+		const uint64_t buddy = offset ^ GetBlockSize(level);
+		auto buddy_block = free_blocks[level].find(buddy);
+		if (buddy_block == free_blocks[level].end())
+		{
+			break;
+		}
+		free_blocks[level].erase(buddy_block);
+		offset = std::min(offset, buddy);
+		level--;
+	}
+	free_blocks[level].insert(offset);
+}
+
+HeapAllocatorStatistics BuddyAllocator::GetStatistics() const
+{
+	HeapAllocatorStatistics statistics = {};
+	statistics.size = heap_size;
+	statistics.used_size = used_size;
+	statistics.requested_size = requested_size;
+	statistics.allocation_num = allocations.size();
+	for (uint32_t level = 0; level < level_num; level++)
+	{
+		if (!free_blocks[level].empty() && statistics.largest_free_block == 0)
+		{
+			statistics.largest_free_block = GetBlockSize(level);
+		}
+		statistics.free_block_num += free_blocks[level].size();
+	}
+	return statistics;
+}
+
+HeapAllocatorList::HeapAllocatorList(uint64_t heap_size, uint64_t min_block_size) :
+	heap_size(heap_size), min_block_size(min_block_size)
+{
+}
+
+bool HeapAllocatorList::Allocate(uint64_t size, uint64_t alignment, Block& block)
+{
+	for (uint32_t heap_index = 0; heap_index < heaps.size(); heap_index++)
+	{
+		const uint64_t offset = heaps[heap_index]->Allocate(size, alignment);
+		if (offset != HeapAllocator::invalid_offset)
+		{
+			block.heap_index = heap_index;
+			block.offset = offset;
+			return true;
+		}
+	}
+	return false;
+}
+
+void HeapAllocatorList::Free(const Block& block)
+{
+	if (block.heap_index < heaps.size())
+	{
+		heaps[block.heap_index]->Free(block.offset);
+	}
+}
+
+uint64_t HeapAllocatorList::GetNewHeapSize(uint64_t size) const
+{
+	uint64_t new_heap_size = std::max(heap_size, min_block_size);
+	while (new_heap_size < size)
+	{
+		new_heap_size *= 2;
+	}
+	return new_heap_size;
+}
+
+uint32_t HeapAllocatorList::AddHeap(uint64_t size)
+{
+	heaps.emplace_back(new BuddyAllocator(size, min_block_size));
+	return static_cast<uint32_t>(heaps.size() - 1);
+}
+
+HeapAllocatorStatistics HeapAllocatorList::GetStatistics() const
+{
+	HeapAllocatorStatistics statistics = {};
+	for (const std::unique_ptr<HeapAllocator>& heap : heaps)
+	{
+		statistics += heap->GetStatistics();
+	}
+	return statistics;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+struct HeapAllocatorStatistics
+{
+	uint64_t size;
+	uint64_t used_size;       // bytes handed out, including rounding inside blocks
+	uint64_t requested_size;  // bytes the callers actually asked for
+	uint64_t largest_free_block;
+	uint64_t allocation_num;
+	uint64_t free_block_num;
+
+	// Share of the heap holding requested bytes
+	float GetUtilization() const;
+	// 0 when all free space is one block, approaching 1 as it splinters
+	float GetFragmentation() const;
+	HeapAllocatorStatistics& operator+=(const HeapAllocatorStatistics& other);
+};
+
+// Offset allocation algorithm for a single heap. Knows nothing about the
+// memory it manages, so any strategy can sit behind GpuMemoryAllocator.
+class HeapAllocator
+{
+public:
+	static const uint64_t invalid_offset = ~0ull;
+
+	virtual ~HeapAllocator() {};
+
+	virtual uint64_t Allocate(uint64_t size, uint64_t alignment) = 0;
+	virtual void Free(uint64_t offset) = 0;
+	virtual HeapAllocatorStatistics GetStatistics() const = 0;
+};
+
+// Binary buddy allocator. Every block is aligned to its own size, so any
+// power-of-two alignment up to the heap size comes for free.
+class BuddyAllocator : public HeapAllocator
+{
+public:
+	BuddyAllocator(uint64_t size, uint64_t min_block_size);
+
+	uint64_t Allocate(uint64_t size, uint64_t alignment) override;
+	void Free(uint64_t offset) override;
+	HeapAllocatorStatistics GetStatistics() const override;
+
+protected:
+	struct Allocation
+	{
+		uint32_t level;
+		uint64_t requested_size;
+	};
+
+	uint64_t GetBlockSize(uint32_t level) const { return heap_size >> level; }
+
+	uint64_t heap_size;
+	uint64_t min_block_size;
+	uint32_t level_num;
+	// Free blocks per level, level 0 is the whole heap
+	std::vector<std::set<uint64_t>> free_blocks;
+	std::unordered_map<uint64_t, Allocation> allocations;
+	uint64_t used_size;
+	uint64_t requested_size;
+};
+
+// First-fit placement over the heaps of one category, each with its own
+// BuddyAllocator. Creating the memory behind a new heap is up to the caller.
+class HeapAllocatorList
+{
+public:
+	struct Block
+	{
+		uint32_t heap_index;
+		uint64_t offset;
+	};
+
+	HeapAllocatorList(uint64_t heap_size = 0, uint64_t min_block_size = 1);
+
+	// Returns false when no heap has room, the caller then adds a heap of GetNewHeapSize
+	bool Allocate(uint64_t size, uint64_t alignment, Block& block);
+	// Returns the block to its heap's allocator, where it merges with free buddies
+	void Free(const Block& block);
+	// The default heap size, or the next power-of-two multiple that fits an oversized request
+	uint64_t GetNewHeapSize(uint64_t size) const;
+	uint32_t AddHeap(uint64_t size);
+
+	uint32_t GetHeapNum() const { return static_cast<uint32_t>(heaps.size()); }
+	HeapAllocatorStatistics GetStatistics() const;
+
+protected:
+	uint64_t heap_size;
+	uint64_t min_block_size;
+	std::vector<std::unique_ptr<HeapAllocator>> heaps;
+};
@@ -0,0 +1,51 @@
+#include "indirect_draw_builder.h"
+
+#include <algorithm>
+#include <numeric>
+
+void IndirectDrawBuilder::Build(const std::vector<IndirectDrawInput>& draws)
+{
+	draw_ids.resize(draws.size());
+	std::iota(draw_ids.begin(), draw_ids.end(), 0);
+	std::stable_sort(draw_ids.begin(), draw_ids.end(), [&](uint32_t a, uint32_t b)
+	{
+		return draws[a].group_key < draws[b].group_key;
+	});
+
+	commands.clear();
+	groups.clear();
+	for (uint32_t command = 0; command < draw_ids.size(); command++)
+	{
+		const IndirectDrawInput& draw = draws[draw_ids[command]];
+
+		IndirectDrawCommand draw_command = {};
+		draw_command.material_index = draw.material_index;
+		draw_command.draw.index_count_per_instance = draw.index_num;
+		draw_command.draw.instance_count = draw.instance_num;
+		draw_command.draw.start_index_location = draw.start_index;
+		draw_command.draw.base_vertex_location = static_cast<int32_t>(draw.start_vertex);
+		draw_command.draw.start_instance_location = draw.start_instance;
+		commands.push_back(draw_command);
+
+		if (groups.empty() || groups.back().group_key != draw.group_key)
+		{
+			IndirectDrawGroup group = {};
+			group.group_key = draw.group_key;
+			group.first_command = command;
+			groups.push_back(group);
+		}
+		groups.back().command_num++;
+	}
+}
+
+void IndirectDrawBuilder::WriteCounts(uint32_t active_draw_num, uint32_t* counts) const
+{
+	for (size_t group_id = 0; group_id < groups.size(); group_id++)
+	{
+		const IndirectDrawGroup& group = groups[group_id];
+		const uint32_t* first = draw_ids.data() + group.first_command;
+		const uint32_t* last = first + group.command_num;
+		// Draw ids ascend inside a group, so the active ones are a prefix
+		counts[group_id] = static_cast<uint32_t>(std::lower_bound(first, last, active_draw_num) - first);
+	}
+}
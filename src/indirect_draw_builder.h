@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Same layout as D3D12_DRAW_INDEXED_ARGUMENTS, one record of the argument buffer
+struct IndirectDrawArguments
+{
+	uint32_t index_count_per_instance;
+	uint32_t instance_count;
+	uint32_t start_index_location;
+	int32_t base_vertex_location;
+	uint32_t start_instance_location;
+};
+
+// One record of the argument buffer: the material root constant, then the draw
+struct IndirectDrawCommand
+{
+	uint32_t material_index;
+	IndirectDrawArguments draw;
+};
+
+struct IndirectDrawInput
+{
+	uint32_t index_num;
+	uint32_t start_index;
+	uint32_t start_vertex;
+	uint32_t instance_num;
+	uint32_t start_instance;
+	uint32_t material_index;
+	// Draws sharing a group key go into one ExecuteIndirect call
+	uint32_t group_key;
+};
+
+struct IndirectDrawGroup
+{
+	uint32_t group_key;
+	uint32_t first_command;
+	uint32_t command_num;
+};
+
+// Builds the argument buffer contents for ExecuteIndirect. Commands are
+// grouped by key and keep draw order inside a group, so limiting the frame
+// to the first N draws only shortens each group: the argument buffer stays
+// the same and only the per-group counts change.
+class IndirectDrawBuilder
+{
+public:
+	void Build(const std::vector<IndirectDrawInput>& draws);
+
+	// Fills one count per group for a frame drawing only draws [0, active_draw_num)
+	void WriteCounts(uint32_t active_draw_num, uint32_t* counts) const;
+
+	const std::vector<IndirectDrawCommand>& GetCommands() const { return commands; }
+	const std::vector<IndirectDrawGroup>& GetGroups() const { return groups; }
+	const std::vector<uint32_t>& GetDrawIds() const { return draw_ids; }
+
+	uint64_t GetArgumentBufferSize() const { return commands.size() * sizeof(IndirectDrawCommand); }
+	uint64_t GetCountBufferSize() const { return groups.size() * sizeof(uint32_t); }
+
+protected:
+	std::vector<IndirectDrawCommand> commands;
+	std::vector<IndirectDrawGroup> groups;
+	// Original draw index of every command
+	std::vector<uint32_t> draw_ids;
+};
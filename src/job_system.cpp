@@ -0,0 +1,275 @@
+#include "job_system.h"
+
+#include <algorithm>
+
+// Identifies the pool thread running the current code, if any
+static thread_local const JobSystem* current_system = nullptr;
+static thread_local uint32_t current_worker = 0;
+
+// Chunks per thread in ParallelFor, a few extra keep threads busy when chunks are uneven
+static const uint32_t chunks_per_thread = 4;
+
+JobSystem::JobSystem(uint32_t thread_num) :
+	worker_num(thread_num > 1 ? thread_num - 1 : 0), queued_job_num(0), stopping(false)
+{
+	queues.reset(new WorkQueue[worker_num + 1]);
+	for (uint32_t worker = 0; worker < worker_num; worker++)
+	{
+		threads.emplace_back(&JobSystem::WorkerLoop, this, worker);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+		stopping = true;
+	}
+	work_ready.notify_all();
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+}
+
+JobHandle JobSystem::Spawn(std::function<void()> function, std::initializer_list<JobHandle> dependencies)
+{
+	JobHandle job = CreateJob(std::move(function));
+	for (const JobHandle& dependency : dependencies)
+	{
+		AddDependency(job, dependency);
+	}
+	Release(job);
+	return job;
+}
+
+JobHandle JobSystem::Spawn(std::function<void()> function, const std::vector<JobHandle>& dependencies)
+{
+	JobHandle job = CreateJob(std::move(function));
+	for (const JobHandle& dependency : dependencies)
+	{
+		AddDependency(job, dependency);
+	}
+	Release(job);
+	return job;
+}
+
+void JobSystem::Wait(const JobHandle& job)
+{
+	WaitFor([&job] { return job->IsFinished(); });
+	if (job->exception)
+	{
+		std::rethrow_exception(job->exception);
+	}
+}
+
+void JobSystem::Wait(const std::vector<JobHandle>& jobs)
+{
+	// Every job has to finish before anything is rethrown, they may reference the caller's stack
+	std::exception_ptr exception;
+	for (const JobHandle& job : jobs)
+	{
+		try
+		{
+			Wait(job);
+		}
+		catch (...)
+		{
+			if (!exception)
+			{
+				exception = std::current_exception();
+			}
+		}
+	}
+	if (exception)
+	{
+		std::rethrow_exception(exception);
+	}
+}
+
+void JobSystem::WaitFor(const std::function<bool()>& condition)
+{
+	while (!condition())
+	{
+		JobHandle job = FindJob();
+		if (job)
+		{
+			Execute(job);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+void JobSystem::ParallelFor(uint32_t task_num, const std::function<void(uint32_t)>& task)
+{
+	if (task_num == 0)
+	{
+		return;
+	}
+	if (task_num == 1 || worker_num == 0)
+	{
+		for (uint32_t i = 0; i < task_num; i++)
+		{
+			task(i);
+		}
+		return;
+	}
+
+	const uint32_t chunk_num = std::min(task_num, GetThreadNum() * chunks_per_thread);
+	std::vector<JobHandle> jobs;
+	jobs.reserve(chunk_num);
+	for (uint32_t chunk = 0; chunk < chunk_num; chunk++)
+	{
+		const uint32_t first = static_cast<uint32_t>(static_cast<uint64_t>(task_num) * chunk / chunk_num);
+		const uint32_t last = static_cast<uint32_t>(static_cast<uint64_t>(task_num) * (chunk + 1) / chunk_num);
+		jobs.push_back(Spawn([&task, first, last]()
+		{
+			for (uint32_t i = first; i < last; i++)
+			{
+				task(i);
+			}
+		}));
+	}
+	Wait(jobs);
+}
+
+JobHandle JobSystem::CreateJob(std::function<void()>&& function)
+{
+	JobHandle job = std::make_shared<Job>();
+	job->function = std::move(function);
+	job->pending_num = 1;
+	job->finished = false;
+	return job;
+}
+
+void JobSystem::AddDependency(const JobHandle& job, const JobHandle& dependency)
+{
+	if (!dependency)
+	{
+		return;
+	}
+	std::lock_guard<std::mutex> lock(dependency->mutex);
+	if (!dependency->finished.load(std::memory_order_relaxed))
+	{
+		job->pending_num++;
+		dependency->continuations.push_back(job);
+	}
+}
+
+void JobSystem::Release(const JobHandle& job)
+{
+	if (--job->pending_num == 0)
+	{
+		Push(job);
+	}
+}
+
+void JobSystem::Push(const JobHandle& job)
+{
+	WorkQueue& queue = queues[GetOwnQueue()];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(job);
+	}
+	queued_job_num++;
+	{
+		// Taking the lock orders the count against a worker about to sleep
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+	}
+	work_ready.notify_one();
+}
+
+JobHandle JobSystem::FindJob()
+{
+	if (queued_job_num.load(std::memory_order_acquire) == 0)
+	{
+		return nullptr;
+	}
+
+	// Own work newest first keeps caches warm, stolen work oldest first takes the biggest pieces
+	const uint32_t own_queue = GetOwnQueue();
+	JobHandle job = TakeJob(own_queue, own_queue < worker_num);
+	const uint32_t queue_num = worker_num + 1;
+	for (uint32_t offset = 1; !job && offset < queue_num; offset++)
+	{
+		job = TakeJob((own_queue + offset) % queue_num, false);
+	}
+	return job;
+}
+
+JobHandle JobSystem::TakeJob(uint32_t queue_index, bool from_back)
+{
+	WorkQueue& queue = queues[queue_index];
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if (queue.jobs.empty())
+	{
+		return nullptr;
+	}
+	JobHandle job;
+	if (from_back)
+	{
+		job = std::move(queue.jobs.back());
+		queue.jobs.pop_back();
+	}
+	else
+	{
+		job = std::move(queue.jobs.front());
+		queue.jobs.pop_front();
+	}
+	queued_job_num--;
+	return job;
+}
+
+void JobSystem::Execute(const JobHandle& job)
+{
+	try
+	{
+		job->function();
+	}
+	catch (...)
+	{
+		job->exception = std::current_exception();
+	}
+	job->function = nullptr;
+
+	std::vector<JobHandle> continuations;
+	{
+		std::lock_guard<std::mutex> lock(job->mutex);
+		job->finished.store(true, std::memory_order_release);
+		continuations.swap(job->continuations);
+	}
+	for (const JobHandle& continuation : continuations)
+	{
+		Release(continuation);
+	}
+}
+
+void JobSystem::WorkerLoop(uint32_t worker_index)
+{
+	current_system = this;
+	current_worker = worker_index;
+	while (true)
+	{
+		JobHandle job = FindJob();
+		if (job)
+		{
+			Execute(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(sleep_mutex);
+		work_ready.wait(lock, [this] { return stopping || queued_job_num.load() > 0; });
+		if (stopping)
+		{
+			return;
+		}
+	}
+}
+
+uint32_t JobSystem::GetOwnQueue() const
+{
+	return current_system == this ? current_worker : worker_num;
+}
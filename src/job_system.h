@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// One unit of work. A finished job stays valid while a handle refers to it.
+class Job
+{
+	friend class JobSystem;
+
+public:
+	bool IsFinished() const { return finished.load(std::memory_order_acquire); }
+
+protected:
+	std::function<void()> function;
+	// Unfinished dependencies, plus one while the job is being spawned
+	std::atomic<uint32_t> pending_num;
+	std::atomic<bool> finished;
+	std::mutex mutex;
+	std::vector<std::shared_ptr<Job>> continuations;
+	std::exception_ptr exception;
+};
+
+typedef std::shared_ptr<Job> JobHandle;
+
+// Work-stealing scheduler shared by loading, culling and recording. Every
+// worker pushes and pops jobs at the back of its own deque and steals from
+// the front of the others when it runs dry. Threads outside the pool submit
+// through a shared queue and run jobs themselves while they wait.
+class JobSystem
+{
+public:
+	explicit JobSystem(uint32_t thread_num = std::thread::hardware_concurrency());
+	~JobSystem();
+
+	// The job becomes runnable once every dependency has finished, failed ones included
+	JobHandle Spawn(std::function<void()> function, std::initializer_list<JobHandle> dependencies = {});
+	JobHandle Spawn(std::function<void()> function, const std::vector<JobHandle>& dependencies);
+
+	// Runs other jobs until the given ones have finished, then rethrows the first exception
+	void Wait(const JobHandle& job);
+	void Wait(const std::vector<JobHandle>& jobs);
+	// Runs jobs until the condition holds, for work finishing outside the job graph
+	void WaitFor(const std::function<bool()>& condition);
+
+	// Runs task(index) for every index in [0, task_num) and returns when all are done
+	void ParallelFor(uint32_t task_num, const std::function<void(uint32_t)>& task);
+
+	// Workers plus the calling thread
+	uint32_t GetThreadNum() const { return worker_num + 1; }
+
+protected:
+	struct WorkQueue
+	{
+		std::mutex mutex;
+		std::deque<JobHandle> jobs;
+	};
+
+	JobHandle CreateJob(std::function<void()>&& function);
+	void AddDependency(const JobHandle& job, const JobHandle& dependency);
+	void Release(const JobHandle& job);
+	void Push(const JobHandle& job);
+	JobHandle FindJob();
+	JobHandle TakeJob(uint32_t queue_index, bool from_back);
+	void Execute(const JobHandle& job);
+	void WorkerLoop(uint32_t worker_index);
+	uint32_t GetOwnQueue() const;
+
+	uint32_t worker_num;
+	// One per worker, the shared queue of outside threads comes last
+	std::unique_ptr<WorkQueue[]> queues;
+	std::atomic<uint32_t> queued_job_num;
+	std::mutex sleep_mutex;
+	std::condition_variable work_ready;
+	bool stopping;
+	std::vector<std::thread> threads;
+};
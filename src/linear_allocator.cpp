@@ -0,0 +1,39 @@
+#include "linear_allocator.h"
+
+LinearAllocator::LinearAllocator()
+{
+	Reset(0);
+}
+
+LinearAllocator::LinearAllocator(uint64_t size)
+{
+	Reset(size);
+}
+
+void LinearAllocator::Reset(uint64_t size)
+{
+	max_size = size;
+	offset = 0;
+	high_water_mark = 0;
+}
+
+void LinearAllocator::Reset()
+{
+	offset = 0;
+}
+
+uint64_t LinearAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+	const uint64_t aligned_offset = (offset + alignment - 1) & ~(alignment - 1);
+	if (size == 0 || aligned_offset + size > max_size)
+	{
+		return invalid_offset;
+	}
+
+	offset = aligned_offset + size;
+	if (offset > high_water_mark)
+	{
+		high_water_mark = offset;
+	}
+	return aligned_offset;
+}
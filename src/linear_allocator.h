@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+
+// Bump allocator over a fixed range of offsets. Everything is released at
+// once by Reset, which the owner calls when the memory is no longer in use.
+class LinearAllocator
+{
+public:
+	static const uint64_t invalid_offset = ~0ull;
+
+	LinearAllocator();
+	explicit LinearAllocator(uint64_t size);
+
+	void Reset(uint64_t size);
+	void Reset();
+
+	uint64_t Allocate(uint64_t size, uint64_t alignment = 1);
+
+	uint64_t GetSize() const { return max_size; }
+	uint64_t GetUsedSize() const { return offset; }
+	uint64_t GetHighWaterMark() const { return high_water_mark; }
+
+protected:
+	uint64_t max_size;
+	uint64_t offset;
+	uint64_t high_water_mark;
+};
@@ -1,4 +1,6 @@
 #include "model_loader.h"
+#include "job_system.h"
+#include "profiler.h"
 
 #define TINYOBJLOADER_IMPLEMENTATION
 #include "tiny_obj_loader.h"
@@ -11,8 +13,9 @@ ModelLoader::~ModelLoader()
 {
 }
 
-HRESULT ModelLoader::LoadModel(std::string path)
+HRESULT ModelLoader::LoadModel(std::string path, JobSystem* jobs)
 {
+	PROFILE_SCOPE("Load model");
 	tinyobj::attrib_t attrib;
 	std::vector<tinyobj::shape_t> shapes;
 	
@@ -22,7 +25,11 @@ HRESULT ModelLoader::LoadModel(std::string path)
 
 	std::wstring::size_type position = path.find_last_of("\\/");
 	model_dir = path.substr(0, position);
-	bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str(), model_dir.c_str());
+	bool ret;
+	{
+		PROFILE_SCOPE("Parse OBJ");
+		ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str(), model_dir.c_str());
+	}
 
 	if (!warn.empty())
 	{
@@ -44,62 +51,80 @@ HRESULT ModelLoader::LoadModel(std::string path)
 	}
 
 	typedef std::map<std::tuple<int, int, int>, UINT> indeces_map_type;
-	//indeces_map_type indeces_map;
 
 	std::vector<std::vector<FullVertex>> per_material_verteces(materials.size());
 	std::vector<std::vector<UINT>> per_material_indeces(materials.size());
-	std::vector<indeces_map_type> per_material_indeces_map(materials.size());
-	 
-	// Loop over shapes
+	std::vector<std::vector<tinyobj::index_t>> per_material_corners(materials.size());
+
+	// Bucket face corners by material, so every material can be welded on its own thread
 	for (size_t s = 0; s < shapes.size(); s++) {
 		// Loop over faces(polygon)
 		size_t index_offset = 0;
 		for (size_t f = 0; f < shapes[s].mesh.num_face_vertices.size(); f++) {
 			int fv = shapes[s].mesh.num_face_vertices[f];
 
-			// Loop over vertices in the face.
 			// per-face material
 			int material_id = shapes[s].mesh.material_ids[f];
-			for (size_t v = 0; v < fv; v++) {
-				// access to vertex
-				tinyobj::index_t idx = shapes[s].mesh.indices[index_offset + v];
-				std::tuple<int, int, int> idx_tuple = std::make_tuple(idx.vertex_index, idx.normal_index, idx.texcoord_index);
-				if (per_material_indeces_map[material_id].count(idx_tuple) > 0)
-				{
-					per_material_indeces[material_id].push_back(per_material_indeces_map[material_id][idx_tuple]);
-				}
-				else 
-				{
-					tinyobj::real_t vx = attrib.vertices[3 * idx.vertex_index + 0];
-					tinyobj::real_t vy = attrib.vertices[3 * idx.vertex_index + 1];
-					tinyobj::real_t vz = -attrib.vertices[3 * idx.vertex_index + 2];
-					tinyobj::real_t nx = (idx.normal_index > -1) ? attrib.normals[3 * idx.normal_index + 0] : 0.0f;
-					tinyobj::real_t ny = (idx.normal_index > -1) ? attrib.normals[3 * idx.normal_index + 1] : 0.0f;
-					tinyobj::real_t nz = (idx.normal_index > -1) ? -attrib.normals[3 * idx.normal_index + 2] : 0.0f;
-					tinyobj::real_t tu = (idx.texcoord_index > -1) ? attrib.texcoords[2 * idx.texcoord_index + 0] : 0.0f;
-					tinyobj::real_t tv = (idx.texcoord_index > -1) ? 1.0f - attrib.texcoords[2 * idx.texcoord_index + 1] : 0.0f;
-
-					materials[material_id].diffuse;
-					FullVertex vertex = {};
-					vertex.position = { vx, vy, vz };
-					vertex.diffuse_color = {
-							materials[material_id].diffuse[0],
-							materials[material_id].diffuse[1],
-							materials[material_id].diffuse[2],
-
-					};
-					vertex.normal = { nx, ny, nz };
-					vertex.texcoord = { tu, tv };
-
-					per_material_indeces[material_id].push_back(per_material_verteces[material_id].size());
-					per_material_indeces_map[material_id][idx_tuple] = per_material_verteces[material_id].size();
-					per_material_verteces[material_id].push_back(vertex);
-				}
-			}
+			const tinyobj::index_t* face = shapes[s].mesh.indices.data() + index_offset;
+			per_material_corners[material_id].insert(per_material_corners[material_id].end(), face, face + fv);
 			index_offset += fv;
 		}
 	};
 
+	auto weld_material = [&](uint32_t material_id)
+	{
+		PROFILE_SCOPE("Weld material");
+		indeces_map_type indeces_map;
+		for (const tinyobj::index_t& idx : per_material_corners[material_id])
+		{
+			std::tuple<int, int, int> idx_tuple = std::make_tuple(idx.vertex_index, idx.normal_index, idx.texcoord_index);
+			indeces_map_type::const_iterator found = indeces_map.find(idx_tuple);
+			if (found != indeces_map.end())
+			{
+				per_material_indeces[material_id].push_back(found->second);
+			}
+			else
+			{
+				tinyobj::real_t vx = attrib.vertices[3 * idx.vertex_index + 0];
+				tinyobj::real_t vy = attrib.vertices[3 * idx.vertex_index + 1];
+				tinyobj::real_t vz = -attrib.vertices[3 * idx.vertex_index + 2];
+				tinyobj::real_t nx = (idx.normal_index > -1) ? attrib.normals[3 * idx.normal_index + 0] : 0.0f;
+				tinyobj::real_t ny = (idx.normal_index > -1) ? attrib.normals[3 * idx.normal_index + 1] : 0.0f;
+				tinyobj::real_t nz = (idx.normal_index > -1) ? -attrib.normals[3 * idx.normal_index + 2] : 0.0f;
+				tinyobj::real_t tu = (idx.texcoord_index > -1) ? attrib.texcoords[2 * idx.texcoord_index + 0] : 0.0f;
+				tinyobj::real_t tv = (idx.texcoord_index > -1) ? 1.0f - attrib.texcoords[2 * idx.texcoord_index + 1] : 0.0f;
+
+				FullVertex vertex = {};
+				vertex.position = { vx, vy, vz };
+				vertex.diffuse_color = {
+						materials[material_id].diffuse[0],
+						materials[material_id].diffuse[1],
+						materials[material_id].diffuse[2],
+
+				};
+				vertex.normal = { nx, ny, nz };
+				vertex.texcoord = { tu, tv };
+
+				const UINT vertex_index = static_cast<UINT>(per_material_verteces[material_id].size());
+				per_material_indeces[material_id].push_back(vertex_index);
+				indeces_map[idx_tuple] = vertex_index;
+				per_material_verteces[material_id].push_back(vertex);
+			}
+		}
+	};
+
+	if (jobs)
+	{
+		jobs->ParallelFor(GetMaterialNum(), weld_material);
+	}
+	else
+	{
+		for (UINT material_id = 0; material_id < GetMaterialNum(); material_id++)
+		{
+			weld_material(material_id);
+		}
+	}
+
 	for (size_t material_id = 0; material_id < GetMaterialNum(); material_id++) 
 	{
 		DrawCallParams params = {};
@@ -111,6 +136,22 @@ HRESULT ModelLoader::LoadModel(std::string path)
 
 		params.index_num = static_cast<UINT>(per_material_indeces[material_id].size());
 		per_material_draw_call_params.push_back(params);
+
+		MaterialBounds bounds = {};
+		if (!per_material_verteces[material_id].empty())
+		{
+			bounds.min = bounds.max = per_material_verteces[material_id][0].position;
+		}
+		for (const FullVertex& vertex : per_material_verteces[material_id])
+		{
+			bounds.min.x = std::min(bounds.min.x, vertex.position.x);
+			bounds.min.y = std::min(bounds.min.y, vertex.position.y);
+			bounds.min.z = std::min(bounds.min.z, vertex.position.z);
+			bounds.max.x = std::max(bounds.max.x, vertex.position.x);
+			bounds.max.y = std::max(bounds.max.y, vertex.position.y);
+			bounds.max.z = std::max(bounds.max.z, vertex.position.z);
+		}
+		per_material_bounds.push_back(bounds);
 	}
 
 	return S_OK;
@@ -156,6 +197,11 @@ const DrawCallParams ModelLoader::GetDrawCallParams(UINT material_id) const
 	return per_material_draw_call_params[material_id];
 }
 
+const MaterialBounds ModelLoader::GetBounds(UINT material_id) const
+{
+	return per_material_bounds[material_id];
+}
+
 const std::string ModelLoader::GetTexturePath(UINT material_id) const
 {
 	return model_dir + "\\" + materials[material_id].diffuse_texname;
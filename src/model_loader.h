@@ -3,6 +3,8 @@
 #include "dx12_labs.h"
 #include "tiny_obj_loader.h"
 
+class JobSystem;
+
 struct DrawCallParams
 {
 	UINT index_num;
@@ -10,12 +12,22 @@ struct DrawCallParams
 	UINT start_vertex;
 };
 
+// Object space bounding box of the geometry drawn with one material
+struct MaterialBounds
+{
+	XMFLOAT3 min;
+	XMFLOAT3 max;
+};
+
 class ModelLoader {
 public:
 	ModelLoader();
 	~ModelLoader();
+	ModelLoader(ModelLoader&&) = default;
+	ModelLoader& operator=(ModelLoader&&) = default;
 
-	HRESULT LoadModel(std::string path);
+	// Materials are welded in parallel when a job system is given
+	HRESULT LoadModel(std::string path, JobSystem* jobs = nullptr);
 
 	const FullVertex* GetVertexBuffer() const;
 	const UINT GetVertexBufferSize() const;
@@ -27,6 +39,7 @@ public:
 
 	const UINT GetMaterialNum() const;
 	const DrawCallParams GetDrawCallParams(UINT material_id) const;
+	const MaterialBounds GetBounds(UINT material_id) const;
 	const std::string GetTexturePath(UINT material_id) const;
 	const bool HasTexture(UINT material_id) const;
 	const UINT GetTextureNum() const;
@@ -36,4 +49,5 @@ protected:
 	std::string model_dir;
 	std::vector<tinyobj::material_t> materials;
 	std::vector<DrawCallParams> per_material_draw_call_params;
+	std::vector<MaterialBounds> per_material_bounds;
 };
\ No newline at end of file
@@ -0,0 +1,319 @@
+#include "null_device.h"
+
+void NullCommandList::Barriers(const RenderGraphBarrier* barriers, uint32_t barrier_num)
+{
+	for (uint32_t barrier = 0; barrier < barrier_num; barrier++)
+	{
+		NullCommand command = {};
+		command.type = NullCommand::TYPE_BARRIER;
+		command.barrier = barriers[barrier];
+		commands.push_back(command);
+	}
+}
+
+void NullCommandList::ClearRenderTarget(uint32_t resource)
+{
+	Add(NullCommand::TYPE_CLEAR_RENDER_TARGET, resource);
+}
+
+void NullCommandList::ClearDepthStencil(uint32_t resource)
+{
+	Add(NullCommand::TYPE_CLEAR_DEPTH_STENCIL, resource);
+}
+
+void NullCommandList::BeginDraws(uint32_t render_target, uint32_t depth_stencil, uint32_t descriptor_table)
+{
+	Add(NullCommand::TYPE_BEGIN_DRAWS, render_target, depth_stencil, descriptor_table);
+}
+
+void NullCommandList::SetPass(uint32_t pass)
+{
+	Add(NullCommand::TYPE_SET_PASS, pass);
+}
+
+void NullCommandList::SetPipeline(uint32_t pipeline)
+{
+	Add(NullCommand::TYPE_SET_PIPELINE, pipeline);
+}
+
+void NullCommandList::SetMaterial(uint32_t material)
+{
+	Add(NullCommand::TYPE_SET_MATERIAL, material);
+}
+
+void NullCommandList::Draw(uint32_t draw_id)
+{
+	Add(NullCommand::TYPE_DRAW, draw_id);
+}
+
+void NullCommandList::Add(NullCommand::Type type, uint32_t a, uint32_t b, uint32_t c)
+{
+	NullCommand command = {};
+	command.type = type;
+	command.arguments[0] = a;
+	command.arguments[1] = b;
+	command.arguments[2] = c;
+	commands.push_back(command);
+}
+
+NullDevice::NullDevice() : index_num(0), vertex_num(0), counts(), executing(false), list(nullptr), list_index(0), command_index(0), error_num(0)
+{
+}
+
+void NullDevice::CreateGraphResources(const RenderGraph& graph)
+{
+	resources.clear();
+	for (uint32_t resource = 0; resource < graph.GetResourceNum(); resource++)
+	{
+		CreateResource(graph.GetResourceName(resource), graph.GetInitialState(resource), graph.IsTransient(resource));
+	}
+}
+
+uint32_t NullDevice::CreateResource(const std::string& name, uint32_t initial_state, bool transient)
+{
+	resources.push_back({ name, initial_state, initial_state, nullptr, false, transient });
+	return static_cast<uint32_t>(resources.size() - 1);
+}
+
+void NullDevice::SetDescriptorHeapSize(uint32_t size)
+{
+	// Growing keeps the written descriptors, as DescriptorHeapManager copies them over
+	written_descriptors.resize(size, 0);
+}
+
+void NullDevice::WriteDescriptor(uint32_t index)
+{
+	if (index >= written_descriptors.size())
+	{
+		Error("descriptor " + std::to_string(index) + " written outside a heap of " + std::to_string(written_descriptors.size()));
+		return;
+	}
+	written_descriptors[index] = 1;
+}
+
+void NullDevice::SetGeometry(const std::vector<NullDraw>& draws, uint32_t index_num, uint32_t vertex_num)
+{
+	this->draws = draws;
+	this->index_num = index_num;
+	this->vertex_num = vertex_num;
+}
+
+void NullDevice::Execute(const NullCommandList* const* lists, uint32_t list_num)
+{
+	executing = true;
+	for (list_index = 0; list_index < list_num; list_index++)
+	{
+		counts.list_num++;
+		list = lists[list_index];
+		ListState list_state = { unbound, unbound, unbound, 0, false, false, false };
+		const std::vector<NullCommand>& commands = lists[list_index]->GetCommands();
+		for (command_index = 0; command_index < commands.size(); command_index++)
+		{
+			const NullCommand& command = commands[command_index];
+			switch (command.type)
+			{
+			case NullCommand::TYPE_BARRIER:
+				counts.barrier_num++;
+				ExecuteBarrier(command.barrier);
+				break;
+			case NullCommand::TYPE_CLEAR_RENDER_TARGET:
+				counts.clear_num++;
+				CheckState(command.arguments[0], RESOURCE_STATE_RENDER_TARGET, "ClearRenderTarget");
+				break;
+			case NullCommand::TYPE_CLEAR_DEPTH_STENCIL:
+				counts.clear_num++;
+				CheckState(command.arguments[0], RESOURCE_STATE_DEPTH_WRITE, "ClearDepthStencil");
+				break;
+			case NullCommand::TYPE_BEGIN_DRAWS:
+				list_state.render_target = command.arguments[0];
+				list_state.depth_stencil = command.arguments[1];
+				list_state.descriptor_table = command.arguments[2];
+				list_state.draws_begun = CheckResource(list_state.render_target, "BeginDraws") && CheckResource(list_state.depth_stencil, "BeginDraws");
+				if (list_state.descriptor_table >= written_descriptors.size())
+				{
+					Error("descriptor table starts at " + std::to_string(list_state.descriptor_table) +
+						" outside a heap of " + std::to_string(written_descriptors.size()));
+				}
+				break;
+			case NullCommand::TYPE_SET_PASS:
+				counts.state_change_num++;
+				break;
+			case NullCommand::TYPE_SET_PIPELINE:
+				counts.state_change_num++;
+				list_state.pipeline_set = true;
+				break;
+			case NullCommand::TYPE_SET_MATERIAL:
+				counts.state_change_num++;
+				list_state.material = command.arguments[0];
+				list_state.material_set = true;
+				break;
+			case NullCommand::TYPE_DRAW:
+				counts.draw_num++;
+				ExecuteDraw(list_state, command.arguments[0]);
+				break;
+			}
+		}
+	}
+	executing = false;
+}
+
+void NullDevice::Present(uint32_t resource)
+{
+	counts.present_num++;
+	CheckState(resource, RESOURCE_STATE_PRESENT, "Present");
+}
+
+void NullDevice::ExecuteBarrier(const RenderGraphBarrier& barrier)
+{
+	if (!CheckResource(barrier.resource, "barrier"))
+	{
+		return;
+	}
+	Resource& resource = resources[barrier.resource];
+	const std::string prefix = "barrier on " + resource.name + ": ";
+	switch (barrier.type)
+	{
+	case RenderGraphBarrier::TYPE_TRANSITION:
+	case RenderGraphBarrier::TYPE_BEGIN_ONLY:
+		if (resource.split_pending)
+		{
+			Error(prefix + "transition while a split barrier is open");
+		}
+		else if (barrier.state_before != resource.state)
+		{
+			Error(prefix + "state before " + std::to_string(barrier.state_before) + " but the resource is in " + std::to_string(resource.state));
+		}
+		else if (barrier.state_before == barrier.state_after)
+		{
+			Error(prefix + "transition to the same state " + std::to_string(barrier.state_after));
+		}
+		if (barrier.type == RenderGraphBarrier::TYPE_TRANSITION)
+		{
+			resource.state = barrier.state_after;
+			resource.split_pending = false;
+		}
+		else
+		{
+			resource.pending_state = barrier.state_after;
+			resource.split_list = list;
+			resource.split_pending = true;
+		}
+		break;
+	case RenderGraphBarrier::TYPE_END_ONLY:
+		if (!resource.split_pending)
+		{
+			Error(prefix + "end of a split barrier that never began");
+		}
+		else if (barrier.state_before != resource.state || barrier.state_after != resource.pending_state)
+		{
+			Error(prefix + "end of a split barrier does not match its begin");
+		}
+		else if (resource.split_list != list)
+		{
+			Error(prefix + "split barrier spans two command lists");
+		}
+		resource.state = barrier.state_after;
+		resource.split_pending = false;
+		break;
+	case RenderGraphBarrier::TYPE_UAV:
+		if ((resource.state & RESOURCE_STATE_UNORDERED_ACCESS) == 0)
+		{
+			Error(prefix + "UAV barrier outside the unordered access state");
+		}
+		break;
+	case RenderGraphBarrier::TYPE_ALIASING:
+		if (!resource.transient)
+		{
+			Error(prefix + "aliasing barrier on a resource that owns its memory");
+		}
+		if (barrier.aliased_resource != RenderGraphBarrier::any_resource)
+		{
+			CheckResource(barrier.aliased_resource, "aliasing barrier");
+		}
+		break;
+	}
+}
+
+void NullDevice::ExecuteDraw(const ListState& list_state, uint32_t draw_id)
+{
+	if (!list_state.draws_begun)
+	{
+		Error("draw without bound attachments");
+		return;
+	}
+	if (!list_state.pipeline_set || !list_state.material_set)
+	{
+		Error("draw without a pipeline or material");
+		return;
+	}
+	CheckState(list_state.render_target, RESOURCE_STATE_RENDER_TARGET, "Draw");
+	CheckState(list_state.depth_stencil, RESOURCE_STATE_DEPTH_WRITE, "Draw");
+
+	if (list_state.material >= material_descriptors.size())
+	{
+		Error("draw " + std::to_string(draw_id) + " uses material " + std::to_string(list_state.material) +
+			" outside " + std::to_string(material_descriptors.size()) + " materials");
+	}
+	else
+	{
+		const uint64_t descriptor = static_cast<uint64_t>(list_state.descriptor_table) + material_descriptors[list_state.material];
+		if (descriptor >= written_descriptors.size())
+		{
+			Error("draw " + std::to_string(draw_id) + " indexes descriptor " + std::to_string(descriptor) +
+				" outside a heap of " + std::to_string(written_descriptors.size()));
+		}
+		else if (!written_descriptors[descriptor])
+		{
+			Error("draw " + std::to_string(draw_id) + " indexes uninitialized descriptor " + std::to_string(descriptor));
+		}
+	}
+
+	if (draw_id >= draws.size())
+	{
+		Error("draw id " + std::to_string(draw_id) + " outside " + std::to_string(draws.size()) + " draws");
+		return;
+	}
+	const NullDraw& draw = draws[draw_id];
+	if (static_cast<uint64_t>(draw.start_index) + draw.index_num > index_num || (draw.index_num > 0 && draw.start_vertex >= vertex_num))
+	{
+		Error("draw " + std::to_string(draw_id) + " reads outside the geometry");
+	}
+	counts.index_num += draw.index_num;
+}
+
+bool NullDevice::CheckResource(uint32_t resource, const char* command)
+{
+	if (resource >= resources.size())
+	{
+		Error(std::string(command) + " on unknown resource " + std::to_string(resource));
+		return false;
+	}
+	return true;
+}
+
+void NullDevice::CheckState(uint32_t resource, uint32_t state, const char* command)
+{
+	if (!CheckResource(resource, command))
+	{
+		return;
+	}
+	const Resource& tracked = resources[resource];
+	if (tracked.split_pending)
+	{
+		Error(std::string(command) + " on " + tracked.name + " inside a split barrier");
+	}
+	else if (tracked.state != state)
+	{
+		Error(std::string(command) + " needs " + tracked.name + " in state " + std::to_string(state) +
+			", it is in " + std::to_string(tracked.state));
+	}
+}
+
+void NullDevice::Error(const std::string& message)
+{
+	error_num++;
+	if (errors.size() < max_error_num)
+	{
+		errors.push_back(executing ? "list " + std::to_string(list_index) + ", command " + std::to_string(command_index) + ": " + message : message);
+	}
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "command_recorder.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct NullCommand
+{
+	enum Type : uint32_t
+	{
+		TYPE_BARRIER,
+		TYPE_CLEAR_RENDER_TARGET,
+		TYPE_CLEAR_DEPTH_STENCIL,
+		TYPE_BEGIN_DRAWS,
+		TYPE_SET_PASS,
+		TYPE_SET_PIPELINE,
+		TYPE_SET_MATERIAL,
+		TYPE_DRAW,
+	};
+
+	Type type;
+	// Resource, pass, pipeline, material or draw id; BeginDraws uses all three
+	uint32_t arguments[3];
+	RenderGraphBarrier barrier;
+};
+
+// Records commands without a device, one list per recording thread.
+// Nothing is checked while recording, NullDevice validates on execution.
+class NullCommandList : public CommandRecorder
+{
+public:
+	void Reset() { commands.clear(); }
+
+	void Barriers(const RenderGraphBarrier* barriers, uint32_t barrier_num) override;
+	void ClearRenderTarget(uint32_t resource) override;
+	void ClearDepthStencil(uint32_t resource) override;
+	void BeginDraws(uint32_t render_target, uint32_t depth_stencil, uint32_t descriptor_table) override;
+
+	void SetPass(uint32_t pass) override;
+	void SetPipeline(uint32_t pipeline) override;
+	void SetMaterial(uint32_t material) override;
+	void Draw(uint32_t draw_id) override;
+
+	const std::vector<NullCommand>& GetCommands() const { return commands; }
+
+protected:
+	void Add(NullCommand::Type type, uint32_t a = 0, uint32_t b = 0, uint32_t c = 0);
+
+	std::vector<NullCommand> commands;
+};
+
+// Index range of a draw id, the geometry the null device bounds-checks against
+struct NullDraw
+{
+	uint32_t index_num;
+	uint32_t start_index;
+	uint32_t start_vertex;
+};
+
+struct NullCommandCounts
+{
+	uint32_t list_num;
+	uint32_t barrier_num;
+	uint32_t clear_num;
+	uint32_t state_change_num;
+	uint32_t draw_num;
+	uint64_t index_num;
+	uint32_t present_num;
+};
+
+// Stands in for the GPU queue. Execute replays lists in submission order the
+// way the debug layer would see them: resource states are tracked across
+// lists and frames, every barrier has to start from the tracked state, and
+// draws must index initialized descriptors and stay inside the geometry.
+// Bound state does not carry over between lists, as with real command lists.
+class NullDevice
+{
+public:
+	// Errors beyond this are counted but not kept
+	static const uint32_t max_error_num = 64;
+
+	NullDevice();
+
+	// Resources get the ids of the graph's resources, in their initial states
+	void CreateGraphResources(const RenderGraph& graph);
+	uint32_t CreateResource(const std::string& name, uint32_t initial_state, bool transient);
+
+	void SetDescriptorHeapSize(uint32_t size);
+	// A view was written to the descriptor, draws may reference it from now on
+	void WriteDescriptor(uint32_t index);
+	void SetGeometry(const std::vector<NullDraw>& draws, uint32_t index_num, uint32_t vertex_num);
+	// Descriptor of every material id, relative to the bound table
+	void SetMaterialDescriptors(const std::vector<uint32_t>& material_descriptors) { this->material_descriptors = material_descriptors; }
+
+	void Execute(const NullCommandList* const* lists, uint32_t list_num);
+	// The resource has to be back in the present state with no split barrier open
+	void Present(uint32_t resource);
+
+	uint32_t GetState(uint32_t resource) const { return resources[resource].state; }
+	const NullCommandCounts& GetCounts() const { return counts; }
+	void ResetCounts() { counts = {}; }
+	bool IsValid() const { return error_num == 0; }
+	uint32_t GetErrorNum() const { return error_num; }
+	const std::vector<std::string>& GetErrors() const { return errors; }
+
+protected:
+	struct Resource
+	{
+		std::string name;
+		uint32_t state;
+		// State a begin-only barrier is heading to, until the end half arrives in the same list
+		uint32_t pending_state;
+		const NullCommandList* split_list;
+		bool split_pending;
+		bool transient;
+	};
+
+	// State a list builds up while it executes
+	struct ListState
+	{
+		uint32_t render_target;
+		uint32_t depth_stencil;
+		uint32_t descriptor_table;
+		uint32_t material;
+		bool draws_begun;
+		bool pipeline_set;
+		bool material_set;
+	};
+
+	static const uint32_t unbound = ~0u;
+
+	void ExecuteBarrier(const RenderGraphBarrier& barrier);
+	void ExecuteDraw(const ListState& list_state, uint32_t draw_id);
+	bool CheckResource(uint32_t resource, const char* command);
+	void CheckState(uint32_t resource, uint32_t state, const char* command);
+	void Error(const std::string& message);
+
+	std::vector<Resource> resources;
+	std::vector<uint8_t> written_descriptors;
+	std::vector<uint32_t> material_descriptors;
+	std::vector<NullDraw> draws;
+	uint32_t index_num;
+	uint32_t vertex_num;
+
+	NullCommandCounts counts;
+	// Position of the command being validated, for error messages
+	bool executing;
+	const NullCommandList* list;
+	uint32_t list_index;
+	uint32_t command_index;
+	uint32_t error_num;
+	std::vector<std::string> errors;
+};
@@ -0,0 +1,370 @@
+#include "occlusion_culler.h"
+#include "frustum_culler.h"
+#include "job_system.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <immintrin.h>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define AVX2_TARGET
+#endif
+
+// Clip space w below this counts as crossing the near plane
+static const float min_clip_w = 1e-4f;
+static const uint32_t visibility_batch_size = 64;
+
+// Edge functions, positive inside, and depth plane of a triangle over the pixels [x, y) of a tile
+struct TriangleSpan
+{
+	float edge_a[3];
+	float edge_b[3];
+	float edge_c[3];
+	float z_a;
+	float z_b;
+	float z_c;
+	uint32_t first_x;
+	uint32_t last_x;
+	uint32_t first_y;
+	uint32_t last_y;
+};
+
+// Both kernels evaluate a * x + (b * y + c) without fused multiply-adds, so they write the same depth
+static void RasterizeSpanSse2(const TriangleSpan& span, float* depth, uint32_t width)
+{
+	const __m128 lane_offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+	const __m128 zero = _mm_setzero_ps();
+	for (uint32_t row = span.first_y; row < span.last_y; row++)
+	{
+		const float center_y = row + 0.5f;
+		const __m128 row_e0 = _mm_set1_ps(span.edge_b[0] * center_y + span.edge_c[0]);
+		const __m128 row_e1 = _mm_set1_ps(span.edge_b[1] * center_y + span.edge_c[1]);
+		const __m128 row_e2 = _mm_set1_ps(span.edge_b[2] * center_y + span.edge_c[2]);
+		const __m128 row_z = _mm_set1_ps(span.z_b * center_y + span.z_c);
+		float* depth_row = depth + static_cast<size_t>(row) * width;
+
+		for (uint32_t column = span.first_x & ~3u; column < span.last_x; column += 4)
+		{
+			const __m128 center_x = _mm_add_ps(_mm_set1_ps(static_cast<float>(column)), lane_offsets);
+			const __m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(span.edge_a[0]), center_x), row_e0);
+			const __m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(span.edge_a[1]), center_x), row_e1);
+			const __m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(span.edge_a[2]), center_x), row_e2);
+			const __m128 inside = _mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_and_ps(_mm_cmpge_ps(e1, zero), _mm_cmpge_ps(e2, zero)));
+			if (_mm_movemask_ps(inside) == 0)
+			{
+				continue;
+			}
+			const __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(span.z_a), center_x), row_z);
+			const __m128 old_depth = _mm_loadu_ps(depth_row + column);
+			const __m128 new_depth = _mm_min_ps(old_depth, z);
+			_mm_storeu_ps(depth_row + column, _mm_or_ps(_mm_and_ps(inside, new_depth), _mm_andnot_ps(inside, old_depth)));
+		}
+	}
+}
+
+AVX2_TARGET static void RasterizeSpanAvx2(const TriangleSpan& span, float* depth, uint32_t width)
+{
+	const __m256 lane_offsets = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+	const __m256 zero = _mm256_setzero_ps();
+	for (uint32_t row = span.first_y; row < span.last_y; row++)
+	{
+		const float center_y = row + 0.5f;
+		const __m256 row_e0 = _mm256_set1_ps(span.edge_b[0] * center_y + span.edge_c[0]);
+		const __m256 row_e1 = _mm256_set1_ps(span.edge_b[1] * center_y + span.edge_c[1]);
+		const __m256 row_e2 = _mm256_set1_ps(span.edge_b[2] * center_y + span.edge_c[2]);
+		const __m256 row_z = _mm256_set1_ps(span.z_b * center_y + span.z_c);
+		float* depth_row = depth + static_cast<size_t>(row) * width;
+
+		// Tiles are 32 pixels wide, so whole groups of 8 never leave the tile
+		for (uint32_t column = span.first_x & ~7u; column < span.last_x; column += 8)
+		{
+			const __m256 center_x = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(column)), lane_offsets);
+			const __m256 e0 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(span.edge_a[0]), center_x), row_e0);
+			const __m256 e1 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(span.edge_a[1]), center_x), row_e1);
+			const __m256 e2 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(span.edge_a[2]), center_x), row_e2);
+			const __m256 inside = _mm256_and_ps(_mm256_cmp_ps(e0, zero, _CMP_GE_OQ),
+				_mm256_and_ps(_mm256_cmp_ps(e1, zero, _CMP_GE_OQ), _mm256_cmp_ps(e2, zero, _CMP_GE_OQ)));
+			if (_mm256_movemask_ps(inside) == 0)
+			{
+				continue;
+			}
+			const __m256 z = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(span.z_a), center_x), row_z);
+			const __m256 old_depth = _mm256_loadu_ps(depth_row + column);
+			_mm256_storeu_ps(depth_row + column, _mm256_blendv_ps(old_depth, _mm256_min_ps(old_depth, z), inside));
+		}
+	}
+}
+
+static __m128 TransformPosition(const float* position, const __m128* rows)
+{
+	__m128 clip = _mm_mul_ps(_mm_set1_ps(position[0]), rows[0]);
+	clip = _mm_add_ps(clip, _mm_mul_ps(_mm_set1_ps(position[1]), rows[1]));
+	clip = _mm_add_ps(clip, _mm_mul_ps(_mm_set1_ps(position[2]), rows[2]));
+	return _mm_add_ps(clip, rows[3]);
+}
+
+OcclusionCuller::OcclusionCuller(uint32_t width, uint32_t height) :
+	kernel(FrustumCuller::HasAvx2() ? KERNEL_AVX2 : KERNEL_SSE2)
+{
+	tile_x_num = std::max(1u, (width + tile_width - 1) / tile_width);
+	tile_y_num = std::max(1u, (height + tile_height - 1) / tile_height);
+	this->width = tile_x_num * tile_width;
+	this->height = tile_y_num * tile_height;
+	depth.assign(this->width * this->height, 1.f);
+	tile_max_depth.assign(GetTileNum(), 1.f);
+	tile_bins.resize(GetTileNum());
+	std::memset(matrix, 0, sizeof(matrix));
+}
+
+void OcclusionCuller::BeginFrame(const float* view_projection)
+{
+	std::memcpy(matrix, view_projection, sizeof(matrix));
+	std::fill(depth.begin(), depth.end(), 1.f);
+	std::fill(tile_max_depth.begin(), tile_max_depth.end(), 1.f);
+	triangles.clear();
+	for (std::vector<uint32_t>& bin : tile_bins)
+	{
+		bin.clear();
+	}
+}
+
+void OcclusionCuller::AddOccluder(const void* positions, uint32_t stride, const uint32_t* indices, uint32_t index_num, uint32_t base_vertex)
+{
+	const __m128 rows[4] = { _mm_loadu_ps(matrix), _mm_loadu_ps(matrix + 4), _mm_loadu_ps(matrix + 8), _mm_loadu_ps(matrix + 12) };
+	const uint8_t* position_bytes = static_cast<const uint8_t*>(positions);
+
+	for (uint32_t index = 0; index + 2 < index_num; index += 3)
+	{
+		ScreenTriangle triangle;
+		bool in_front = true;
+		for (uint32_t corner = 0; corner < 3; corner++)
+		{
+			const float* position = reinterpret_cast<const float*>(position_bytes + static_cast<size_t>(base_vertex + indices[index + corner]) * stride);
+			float clip[4];
+			_mm_storeu_ps(clip, TransformPosition(position, rows));
+			if (clip[3] < min_clip_w)
+			{
+				in_front = false;
+				break;
+			}
+			const float inverse_w = 1.f / clip[3];
+			triangle.x[corner] = (clip[0] * inverse_w * 0.5f + 0.5f) * width;
+			triangle.y[corner] = (0.5f - clip[1] * inverse_w * 0.5f) * height;
+			triangle.z[corner] = clip[2] * inverse_w;
+		}
+		if (!in_front)
+		{
+			continue;
+		}
+
+		// Rasterization expects positive area
+		const float area = (triangle.x[1] - triangle.x[0]) * (triangle.y[2] - triangle.y[0]) -
+			(triangle.x[2] - triangle.x[0]) * (triangle.y[1] - triangle.y[0]);
+		if (std::fabs(area) < 1e-6f)
+		{
+			continue;
+		}
+		if (area < 0.f)
+		{
+			std::swap(triangle.x[1], triangle.x[2]);
+			std::swap(triangle.y[1], triangle.y[2]);
+			std::swap(triangle.z[1], triangle.z[2]);
+		}
+
+		const float min_x = std::max(0.f, std::min({ triangle.x[0], triangle.x[1], triangle.x[2] }));
+		const float max_x = std::min(static_cast<float>(width), std::max({ triangle.x[0], triangle.x[1], triangle.x[2] }));
+		const float min_y = std::max(0.f, std::min({ triangle.y[0], triangle.y[1], triangle.y[2] }));
+		const float max_y = std::min(static_cast<float>(height), std::max({ triangle.y[0], triangle.y[1], triangle.y[2] }));
+		if (min_x >= max_x || min_y >= max_y)
+		{
+			continue;
+		}
+
+		const uint32_t triangle_id = static_cast<uint32_t>(triangles.size());
+		triangles.push_back(triangle);
+		const uint32_t first_tile_x = static_cast<uint32_t>(min_x) / tile_width;
+		const uint32_t last_tile_x = std::min(tile_x_num - 1, static_cast<uint32_t>(max_x) / tile_width);
+		const uint32_t first_tile_y = static_cast<uint32_t>(min_y) / tile_height;
+		const uint32_t last_tile_y = std::min(tile_y_num - 1, static_cast<uint32_t>(max_y) / tile_height);
+		for (uint32_t tile_y = first_tile_y; tile_y <= last_tile_y; tile_y++)
+		{
+			for (uint32_t tile_x = first_tile_x; tile_x <= last_tile_x; tile_x++)
+			{
+				tile_bins[tile_y * tile_x_num + tile_x].push_back(triangle_id);
+			}
+		}
+	}
+}
+
+void OcclusionCuller::Rasterize(JobSystem& jobs)
+{
+	jobs.ParallelFor(GetTileNum(), [this](uint32_t tile)
+	{
+		RasterizeTile(tile);
+	});
+}
+
+void OcclusionCuller::RasterizeTile(uint32_t tile)
+{
+	const uint32_t tile_x0 = (tile % tile_x_num) * tile_width;
+	const uint32_t tile_y0 = (tile / tile_x_num) * tile_height;
+
+	for (uint32_t triangle_id : tile_bins[tile])
+	{
+		const ScreenTriangle& triangle = triangles[triangle_id];
+		const float* x = triangle.x;
+		const float* y = triangle.y;
+
+		// Edge i is opposite to vertex i
+		TriangleSpan span;
+		span.edge_a[0] = y[1] - y[2];
+		span.edge_a[1] = y[2] - y[0];
+		span.edge_a[2] = y[0] - y[1];
+		span.edge_b[0] = x[2] - x[1];
+		span.edge_b[1] = x[0] - x[2];
+		span.edge_b[2] = x[1] - x[0];
+		span.edge_c[0] = x[1] * y[2] - x[2] * y[1];
+		span.edge_c[1] = x[2] * y[0] - x[0] * y[2];
+		span.edge_c[2] = x[0] * y[1] - x[1] * y[0];
+		const float inverse_area = 1.f / (span.edge_c[0] + span.edge_c[1] + span.edge_c[2]);
+
+		// Depth plane from the barycentric weights
+		const float* z = triangle.z;
+		span.z_a = (span.edge_a[0] * z[0] + span.edge_a[1] * z[1] + span.edge_a[2] * z[2]) * inverse_area;
+		span.z_b = (span.edge_b[0] * z[0] + span.edge_b[1] * z[1] + span.edge_b[2] * z[2]) * inverse_area;
+		span.z_c = (span.edge_c[0] * z[0] + span.edge_c[1] * z[1] + span.edge_c[2] * z[2]) * inverse_area;
+
+		// Kernels round first_x down to their group width, tile edges are aligned to both
+		const float min_x = std::min({ x[0], x[1], x[2] });
+		const float max_x = std::max({ x[0], x[1], x[2] });
+		const float min_y = std::min({ y[0], y[1], y[2] });
+		const float max_y = std::max({ y[0], y[1], y[2] });
+		span.first_x = std::max(tile_x0, static_cast<uint32_t>(std::max(0.f, min_x)));
+		span.last_x = std::min(tile_x0 + tile_width, static_cast<uint32_t>(std::max(0.f, std::ceil(max_x))));
+		span.first_y = std::max(tile_y0, static_cast<uint32_t>(std::max(0.f, min_y)));
+		span.last_y = std::min(tile_y0 + tile_height, static_cast<uint32_t>(std::max(0.f, std::ceil(max_y))));
+
+		if (kernel == KERNEL_AVX2)
+		{
+			RasterizeSpanAvx2(span, depth.data(), width);
+		}
+		else
+		{
+			RasterizeSpanSse2(span, depth.data(), width);
+		}
+	}
+
+	const __m128 zero = _mm_setzero_ps();
+	__m128 max_depth = zero;
+	for (uint32_t row = tile_y0; row < tile_y0 + tile_height; row++)
+	{
+		const float* depth_row = depth.data() + static_cast<size_t>(row) * width;
+		for (uint32_t column = tile_x0; column < tile_x0 + tile_width; column += 4)
+		{
+			max_depth = _mm_max_ps(max_depth, _mm_loadu_ps(depth_row + column));
+		}
+	}
+	float lanes[4];
+	_mm_storeu_ps(lanes, max_depth);
+	tile_max_depth[tile] = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+}
+
+bool OcclusionCuller::IsVisible(const OcclusionBounds& bounds) const
+{
+	const __m128 rows[4] = { _mm_loadu_ps(matrix), _mm_loadu_ps(matrix + 4), _mm_loadu_ps(matrix + 8), _mm_loadu_ps(matrix + 12) };
+
+	float min_x = static_cast<float>(width);
+	float max_x = 0.f;
+	float min_y = static_cast<float>(height);
+	float max_y = 0.f;
+	float min_z = 1.f;
+	for (uint32_t corner = 0; corner < 8; corner++)
+	{
+		const float position[3] = {
+			(corner & 1) ? bounds.max[0] : bounds.min[0],
+			(corner & 2) ? bounds.max[1] : bounds.min[1],
+			(corner & 4) ? bounds.max[2] : bounds.min[2] };
+		float clip[4];
+		_mm_storeu_ps(clip, TransformPosition(position, rows));
+		if (clip[3] < min_clip_w)
+		{
+			return true;
+		}
+		const float inverse_w = 1.f / clip[3];
+		const float screen_x = (clip[0] * inverse_w * 0.5f + 0.5f) * width;
+		const float screen_y = (0.5f - clip[1] * inverse_w * 0.5f) * height;
+		min_x = std::min(min_x, screen_x);
+		max_x = std::max(max_x, screen_x);
+		min_y = std::min(min_y, screen_y);
+		max_y = std::max(max_y, screen_y);
+		min_z = std::min(min_z, clip[2] * inverse_w);
+	}
+
+	// Entirely off screen or beyond the far plane
+	min_x = std::max(min_x, 0.f);
+	max_x = std::min(max_x, static_cast<float>(width));
+	min_y = std::max(min_y, 0.f);
+	max_y = std::min(max_y, static_cast<float>(height));
+	if (min_x >= max_x || min_y >= max_y || min_z > 1.f)
+	{
+		return false;
+	}
+	if (min_z <= 0.f)
+	{
+		return true;
+	}
+
+	// Whole 4 pixel groups, the extra pixels only make the test more conservative
+	const uint32_t first_x = static_cast<uint32_t>(min_x) & ~3u;
+	const uint32_t last_x = std::min(width, (static_cast<uint32_t>(std::ceil(max_x)) + 3) & ~3u);
+	const uint32_t first_y = static_cast<uint32_t>(min_y);
+	const uint32_t last_y = std::min(height, static_cast<uint32_t>(std::ceil(max_y)));
+	const __m128 box_depth = _mm_set1_ps(min_z);
+
+	for (uint32_t tile_y = first_y / tile_height; tile_y * tile_height < last_y; tile_y++)
+	{
+		for (uint32_t tile_x = first_x / tile_width; tile_x * tile_width < last_x; tile_x++)
+		{
+			if (tile_max_depth[tile_y * tile_x_num + tile_x] < min_z)
+			{
+				continue;
+			}
+			const uint32_t row_begin = std::max(first_y, tile_y * tile_height);
+			const uint32_t row_end = std::min(last_y, (tile_y + 1) * tile_height);
+			const uint32_t column_begin = std::max(first_x, tile_x * tile_width);
+			const uint32_t column_end = std::min(last_x, (tile_x + 1) * tile_width);
+			for (uint32_t row = row_begin; row < row_end; row++)
+			{
+				const float* depth_row = depth.data() + static_cast<size_t>(row) * width;
+				for (uint32_t column = column_begin; column < column_end; column += 4)
+				{
+					if (_mm_movemask_ps(_mm_cmple_ps(box_depth, _mm_loadu_ps(depth_row + column))) != 0)
+					{
+						return true;
+					}
+				}
+			}
+		}
+	}
+	return false;
+}
+
+void OcclusionCuller::TestVisibility(const OcclusionBounds* bounds, uint32_t bounds_num, uint8_t* visible, JobSystem& jobs) const
+{
+	const uint32_t batch_num = (bounds_num + visibility_batch_size - 1) / visibility_batch_size;
+	jobs.ParallelFor(batch_num, [&](uint32_t batch)
+	{
+		const uint32_t first = batch * visibility_batch_size;
+		const uint32_t last = std::min(bounds_num, first + visibility_batch_size);
+		for (uint32_t i = first; i < last; i++)
+		{
+			if (visible[i] && !IsVisible(bounds[i]))
+			{
+				visible[i] = 0;
+			}
+		}
+	});
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+struct OcclusionBounds
+{
+	float min[3];
+	float max[3];
+};
+
+// Low resolution software depth buffer for occlusion culling. Occluder
+// triangles are binned into screen tiles, tiles are rasterized independently
+// 8 pixels at a time with AVX2 or 4 with SSE2, then bounding boxes are tested
+// against the nearest occluder depth. Every test errs towards visible: triangles and boxes crossing the
+// near plane are not used as occluders and are always reported visible.
+class OcclusionCuller
+{
+public:
+	static const uint32_t tile_width = 32;
+	static const uint32_t tile_height = 16;
+
+	// Both kernels write the same depth, AVX2 is picked when FrustumCuller::HasAvx2
+	enum Kernel
+	{
+		KERNEL_SSE2,
+		KERNEL_AVX2
+	};
+
+	// The size is rounded up to whole tiles
+	explicit OcclusionCuller(uint32_t width = 320, uint32_t height = 192);
+
+	// Clears depth and bins. The matrix is row-major with clip = position * matrix, depth in [0, 1]
+	void BeginFrame(const float* view_projection);
+	// Transforms and bins the indexed triangles, positions are float3 stride bytes apart
+	void AddOccluder(const void* positions, uint32_t stride, const uint32_t* indices, uint32_t index_num, uint32_t base_vertex);
+
+	void Rasterize(JobSystem& jobs);
+	void RasterizeTile(uint32_t tile);
+
+	bool IsVisible(const OcclusionBounds& bounds) const;
+	// Clears the flag of every occluded box, boxes already flagged 0 are not tested
+	void TestVisibility(const OcclusionBounds* bounds, uint32_t bounds_num, uint8_t* visible, JobSystem& jobs) const;
+
+	uint32_t GetWidth() const { return width; }
+	uint32_t GetHeight() const { return height; }
+	uint32_t GetTileNum() const { return tile_x_num * tile_y_num; }
+	uint32_t GetTriangleNum() const { return static_cast<uint32_t>(triangles.size()); }
+	// Row-major nearest occluder depth, 1 where nothing was drawn
+	const float* GetDepth() const { return depth.data(); }
+
+	Kernel GetKernel() const { return kernel; }
+	void SetKernel(Kernel kernel) { this->kernel = kernel; }
+
+protected:
+	struct ScreenTriangle
+	{
+		float x[3];
+		float y[3];
+		float z[3];
+	};
+
+	Kernel kernel;
+	uint32_t width;
+	uint32_t height;
+	uint32_t tile_x_num;
+	uint32_t tile_y_num;
+	float matrix[16];
+
+	std::vector<float> depth;
+	// Farthest depth inside each tile, a box behind it is hidden in the whole tile
+	std::vector<float> tile_max_depth;
+	std::vector<ScreenTriangle> triangles;
+	std::vector<std::vector<uint32_t>> tile_bins;
+};
@@ -0,0 +1,200 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+	std::atomic<uint32_t> next_thread_id(0);
+	thread_local uint32_t thread_id = next_thread_id++;
+	thread_local uint32_t scope_depth = 0;
+
+	void WriteJsonString(std::ostream& stream, const char* text)
+	{
+		stream << '"';
+		for (const char* c = text; *c; c++)
+		{
+			if (*c == '"' || *c == '\\')
+			{
+				stream << '\\' << *c;
+			}
+			else if (static_cast<unsigned char>(*c) < 0x20)
+			{
+				char escaped[8];
+				snprintf(escaped, sizeof(escaped), "\\u%04x", *c);
+				stream << escaped;
+			}
+			else
+			{
+				stream << *c;
+			}
+		}
+		stream << '"';
+	}
+}
+
+Profiler& Profiler::Get()
+{
+	static Profiler profiler;
+	return profiler;
+}
+
+uint64_t Profiler::Now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Profiler::Profiler() : frame(0)
+{
+}
+
+void Profiler::BeginScope()
+{
+	scope_depth++;
+}
+
+void Profiler::EndScope(const char* name, uint64_t begin)
+{
+	const uint64_t end = Now();
+	scope_depth--;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	events.push_back({ name, ProfileEvent::TRACK_CPU, thread_id, scope_depth, frame, begin, end });
+	// Scopes running on several threads add up to their CPU time in the frame
+	FindStatistics(name, ProfileEvent::TRACK_CPU).frame_total += end - begin;
+}
+
+void Profiler::AddGpuRange(const char* name, uint64_t frame, uint64_t begin, uint64_t end)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	events.push_back({ name, ProfileEvent::TRACK_GPU, 0, 0, frame, begin, end });
+	// Several frames may resolve at once or none at all, so each range counts on its own
+	ScopeStatistics& scope = FindStatistics(name, ProfileEvent::TRACK_GPU);
+	AddSample(scope, end - begin);
+	scope.last_frame = this->frame;
+}
+
+void Profiler::EndFrame()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	for (ScopeStatistics& scope : statistics)
+	{
+		// Scopes missing from a frame keep their average, a toggled feature does not decay
+		if (scope.frame_total == 0)
+		{
+			continue;
+		}
+		AddSample(scope, scope.frame_total);
+		scope.last_frame = frame;
+		scope.frame_total = 0;
+	}
+
+	frame++;
+	while (!events.empty() && events.front().frame + history_frame_num < frame)
+	{
+		events.pop_front();
+	}
+}
+
+uint64_t Profiler::GetFrame() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return frame;
+}
+
+void Profiler::WriteChromeTrace(std::ostream& stream) const
+{
+	std::vector<ProfileEvent> trace = GetEvents();
+	uint64_t origin = UINT64_MAX;
+	for (const ProfileEvent& event : trace)
+	{
+		origin = std::min(origin, event.begin);
+	}
+
+	// Complete events in microseconds, CPU threads and the GPU queue as two processes
+	stream << "{\"traceEvents\":[";
+	stream << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"CPU\"}},";
+	stream << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"GPU\"}}";
+	char times[96];
+	for (const ProfileEvent& event : trace)
+	{
+		stream << ",\n{\"name\":";
+		WriteJsonString(stream, event.name);
+		snprintf(times, sizeof(times), ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f",
+			(event.begin - origin) / 1000.0, (event.end - event.begin) / 1000.0);
+		stream << times;
+		stream << ",\"pid\":" << static_cast<uint32_t>(event.track) << ",\"tid\":" << event.thread_id;
+		stream << ",\"args\":{\"frame\":" << event.frame << "}}";
+	}
+	stream << "\n]}\n";
+}
+
+std::string Profiler::GetSummary() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	std::string summary;
+	char entry[128];
+	for (const ScopeStatistics& scope : statistics)
+	{
+		// One-off scopes such as loading drop out once they go stale
+		if (!scope.seen || scope.last_frame + summary_frame_num < frame)
+		{
+			continue;
+		}
+		snprintf(entry, sizeof(entry), "%s%s%s %.2f ms", summary.empty() ? "" : " | ",
+			scope.track == ProfileEvent::TRACK_GPU ? "GPU " : "", scope.name, scope.average);
+		summary += entry;
+	}
+	return summary;
+}
+
+float Profiler::GetAverage(const char* name, ProfileEvent::Track track) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	for (const ScopeStatistics& scope : statistics)
+	{
+		if (scope.track == track && strcmp(scope.name, name) == 0)
+		{
+			return scope.average;
+		}
+	}
+	return 0.f;
+}
+
+std::vector<ProfileEvent> Profiler::GetEvents() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return std::vector<ProfileEvent>(events.begin(), events.end());
+}
+
+void Profiler::Clear()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	events.clear();
+	statistics.clear();
+}
+
+Profiler::ScopeStatistics& Profiler::FindStatistics(const char* name, ProfileEvent::Track track)
+{
+	// Few distinct scopes, a linear search beats hashing the name
+	for (ScopeStatistics& scope : statistics)
+	{
+		if (scope.track == track && (scope.name == name || strcmp(scope.name, name) == 0))
+		{
+			return scope;
+		}
+	}
+	statistics.push_back({ name, track, 0, 0.f, 0, false });
+	return statistics.back();
+}
+
+void Profiler::AddSample(ScopeStatistics& scope, uint64_t time)
+{
+	const float sample = time / 1000000.f;
+	scope.average = scope.seen ? scope.average + (sample - scope.average) * average_weight : sample;
+	scope.seen = true;
+}
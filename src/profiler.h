@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// One finished range, times in nanoseconds of the steady clock
+struct ProfileEvent
+{
+	enum Track : uint32_t
+	{
+		TRACK_CPU,
+		TRACK_GPU,
+	};
+
+	const char* name;
+	Track track;
+	// Small sequential id of the recording thread, the GPU queue is thread 0 of its track
+	uint32_t thread_id;
+	// Nesting level on its thread, 0 for outermost scopes
+	uint32_t depth;
+	uint64_t frame;
+	uint64_t begin;
+	uint64_t end;
+};
+
+// Collects CPU scopes from any thread and GPU ranges resolved frames later.
+// The last history_frame_num frames are kept for trace export; a rolling
+// average of every scope's time per frame feeds the on-screen summary. Names
+// must be string literals or otherwise outlive the profiler.
+class Profiler
+{
+public:
+	static const uint64_t history_frame_num = 240;
+	// Scopes missing for longer leave the summary
+	static const uint64_t summary_frame_num = 60;
+
+	static Profiler& Get();
+	// Nanoseconds on the clock every CPU event uses
+	static uint64_t Now();
+
+	Profiler();
+
+	void BeginScope();
+	void EndScope(const char* name, uint64_t begin);
+	// GPU ranges arrive after their frame retired, already converted to the CPU clock
+	void AddGpuRange(const char* name, uint64_t frame, uint64_t begin, uint64_t end);
+
+	// Folds this frame's totals into the averages and drops old events
+	void EndFrame();
+	uint64_t GetFrame() const;
+
+	// Chrome trace event format, loadable in chrome://tracing or Perfetto
+	void WriteChromeTrace(std::ostream& stream) const;
+	// "name 1.23 ms" for every scope and GPU range seen in recent frames
+	std::string GetSummary() const;
+	// Average per frame in milliseconds, 0 when the name was never seen
+	float GetAverage(const char* name, ProfileEvent::Track track) const;
+	std::vector<ProfileEvent> GetEvents() const;
+	void Clear();
+
+protected:
+	struct ScopeStatistics
+	{
+		const char* name;
+		ProfileEvent::Track track;
+		uint64_t frame_total;
+		float average;
+		uint64_t last_frame;
+		bool seen;
+	};
+
+	ScopeStatistics& FindStatistics(const char* name, ProfileEvent::Track track);
+	static void AddSample(ScopeStatistics& scope, uint64_t time);
+
+	// Weight of the latest frame in the rolling averages
+	static constexpr float average_weight = 0.1f;
+
+	mutable std::mutex mutex;
+	uint64_t frame;
+	std::deque<ProfileEvent> events;
+	// In first seen order, so the summary keeps a stable layout
+	std::vector<ScopeStatistics> statistics;
+};
+
+// Measures its own lifetime, use through PROFILE_SCOPE
+class ProfileScope
+{
+public:
+	explicit ProfileScope(const char* name) : name(name), begin(Profiler::Now())
+	{
+		Profiler::Get().BeginScope();
+	}
+	~ProfileScope()
+	{
+		Profiler::Get().EndScope(name, begin);
+	}
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+
+protected:
+	const char* name;
+	uint64_t begin;
+};
+
+// Markers compile to nothing unless the build defines ENABLE_PROFILER
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#ifdef ENABLE_PROFILER
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+#define PROFILE_END_FRAME() Profiler::Get().EndFrame()
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_END_FRAME()
+#endif
@@ -0,0 +1,217 @@
+#include "render_graph.h"
+
+#include <algorithm>
+
+uint32_t RenderGraph::ImportResource(const std::string& name, uint32_t initial_state, uint32_t final_state)
+{
+	Resource resource = { name, initial_state, final_state, false, 0, 0, 0 };
+	resources.push_back(resource);
+	return static_cast<uint32_t>(resources.size()) - 1;
+}
+
+uint32_t RenderGraph::CreateTransient(const std::string& name, uint64_t size, uint64_t alignment)
+{
+	Resource resource = { name, RESOURCE_STATE_COMMON, RESOURCE_STATE_COMMON, true, size, alignment, 0 };
+	resources.push_back(resource);
+	return static_cast<uint32_t>(resources.size()) - 1;
+}
+
+uint32_t RenderGraph::AddPass(const std::string& name)
+{
+	pass_names.push_back(name);
+	return static_cast<uint32_t>(pass_names.size()) - 1;
+}
+
+void RenderGraph::Read(uint32_t pass, uint32_t resource, uint32_t state)
+{
+	AddAccess(pass, resource, state, false);
+}
+
+void RenderGraph::Write(uint32_t pass, uint32_t resource, uint32_t state)
+{
+	AddAccess(pass, resource, state, true);
+}
+
+void RenderGraph::AddAccess(uint32_t pass, uint32_t resource, uint32_t state, bool write)
+{
+	for (Access& access : accesses)
+	{
+		if (access.pass == pass && access.resource == resource)
+		{
+			access.state |= state;
+			access.write = access.write || write;
+			return;
+		}
+	}
+	Access access = { pass, resource, state, write };
+	accesses.push_back(access);
+}
+
+void RenderGraph::Clear()
+{
+	pass_names.clear();
+	resources.clear();
+	accesses.clear();
+	batches.clear();
+}
+
+uint32_t RenderGraph::GetBarrierNum() const
+{
+	size_t barrier_num = 0;
+	for (const std::vector<RenderGraphBarrier>& batch : batches)
+	{
+		barrier_num += batch.size();
+	}
+	return static_cast<uint32_t>(barrier_num);
+}
+
+void RenderGraph::Compile()
+{
+	// Batch i runs before pass i, the extra last one after every pass
+	batches.assign(pass_names.size() + 1, std::vector<RenderGraphBarrier>());
+	std::sort(accesses.begin(), accesses.end(), [](const Access& a, const Access& b)
+	{
+		return a.pass < b.pass;
+	});
+	PlanTransients();
+
+	std::vector<Use> uses;
+	for (uint32_t resource = 0; resource < resources.size(); resource++)
+	{
+		CollectUses(resource, uses);
+
+		// The imported state acts as a use ending before the first pass
+		uint32_t state = resources[resource].initial_state;
+		uint32_t idle_batch = 0;
+		bool last_write = false;
+		for (const Use& use : uses)
+		{
+			if (use.state != state)
+			{
+				AddTransition(resource, state, use.state, idle_batch, use.first_pass);
+			}
+			else if (last_write && use.state == RESOURCE_STATE_UNORDERED_ACCESS)
+			{
+				// Same state, but the earlier writes still have to land
+				RenderGraphBarrier barrier = { RenderGraphBarrier::TYPE_UAV, resource, use.state, use.state, RenderGraphBarrier::any_resource };
+				batches[use.first_pass].push_back(barrier);
+			}
+			state = use.state;
+			idle_batch = use.last_pass + 1;
+			last_write = use.write;
+		}
+
+		if (state != resources[resource].final_state)
+		{
+			AddTransition(resource, state, resources[resource].final_state, idle_batch, GetPassNum());
+		}
+	}
+}
+
+void RenderGraph::PlanTransients()
+{
+	// Lifetimes run from the first to the last pass touching the resource
+	std::vector<uint32_t> transients;
+	std::vector<TransientRequest> requests;
+	for (uint32_t resource = 0; resource < resources.size(); resource++)
+	{
+		if (!resources[resource].transient)
+		{
+			continue;
+		}
+		TransientRequest request = { resources[resource].size, resources[resource].alignment, ~0u, 0 };
+		for (const Access& access : accesses)
+		{
+			if (access.resource != resource)
+			{
+				continue;
+			}
+			if (request.first_pass == ~0u)
+			{
+				// Created in its first state, so that use needs no transition
+				resources[resource].initial_state = access.state;
+				resources[resource].final_state = access.state;
+			}
+			request.first_pass = std::min(request.first_pass, access.pass);
+			request.last_pass = std::max(request.last_pass, access.pass);
+		}
+		if (request.first_pass == ~0u)
+		{
+			continue;
+		}
+		transients.push_back(resource);
+		requests.push_back(request);
+	}
+	transient_planner.Plan(requests);
+
+	for (uint32_t transient = 0; transient < transients.size(); transient++)
+	{
+		resources[transients[transient]].offset = transient_planner.GetOffset(transient);
+	}
+
+	// Memory shared with any other transient has to be activated before the first use,
+	// the previous frame left it with whichever resource used it last
+	for (uint32_t transient = 0; transient < transients.size(); transient++)
+	{
+		uint32_t sharing_num = 0;
+		uint32_t predecessor = RenderGraphBarrier::any_resource;
+		uint32_t predecessor_num = 0;
+		for (uint32_t other = 0; other < transients.size(); other++)
+		{
+			if (other == transient || !transient_planner.SharesMemory(transient, other))
+			{
+				continue;
+			}
+			sharing_num++;
+			if (requests[other].last_pass < requests[transient].first_pass)
+			{
+				predecessor = transients[other];
+				predecessor_num++;
+			}
+		}
+		if (sharing_num == 0)
+		{
+			continue;
+		}
+		const uint32_t resource = transients[transient];
+		RenderGraphBarrier barrier = { RenderGraphBarrier::TYPE_ALIASING, resource, resources[resource].initial_state,
+			resources[resource].initial_state, predecessor_num == 1 ? predecessor : RenderGraphBarrier::any_resource };
+		batches[requests[transient].first_pass].push_back(barrier);
+	}
+}
+
+void RenderGraph::CollectUses(uint32_t resource, std::vector<Use>& uses) const
+{
+	// Reads with no write in between merge into one combined read state
+	uses.clear();
+	for (const Access& access : accesses)
+	{
+		if (access.resource != resource)
+		{
+			continue;
+		}
+		if (!access.write && !uses.empty() && !uses.back().write)
+		{
+			uses.back().last_pass = access.pass;
+			uses.back().state |= access.state;
+			continue;
+		}
+		Use use = { access.pass, access.pass, access.state, access.write };
+		uses.push_back(use);
+	}
+}
+
+void RenderGraph::AddTransition(uint32_t resource, uint32_t state_before, uint32_t state_after, uint32_t idle_batch, uint32_t use_batch)
+{
+	// idle_batch is the first batch after the previous use
+	if (idle_batch >= use_batch)
+	{
+		RenderGraphBarrier barrier = { RenderGraphBarrier::TYPE_TRANSITION, resource, state_before, state_after, RenderGraphBarrier::any_resource };
+		batches[use_batch].push_back(barrier);
+		return;
+	}
+	RenderGraphBarrier begin = { RenderGraphBarrier::TYPE_BEGIN_ONLY, resource, state_before, state_after, RenderGraphBarrier::any_resource };
+	RenderGraphBarrier end = { RenderGraphBarrier::TYPE_END_ONLY, resource, state_before, state_after, RenderGraphBarrier::any_resource };
+	batches[idle_batch].push_back(begin);
+	batches[use_batch].push_back(end);
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "transient_heap_planner.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Same values as D3D12_RESOURCE_STATES, so barriers translate with a cast
+enum ResourceState : uint32_t
+{
+	RESOURCE_STATE_COMMON = 0,
+	RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER = 0x1,
+	RESOURCE_STATE_INDEX_BUFFER = 0x2,
+	RESOURCE_STATE_RENDER_TARGET = 0x4,
+	RESOURCE_STATE_UNORDERED_ACCESS = 0x8,
+	RESOURCE_STATE_DEPTH_WRITE = 0x10,
+	RESOURCE_STATE_DEPTH_READ = 0x20,
+	RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE = 0x40,
+	RESOURCE_STATE_PIXEL_SHADER_RESOURCE = 0x80,
+	RESOURCE_STATE_INDIRECT_ARGUMENT = 0x200,
+	RESOURCE_STATE_COPY_DEST = 0x400,
+	RESOURCE_STATE_COPY_SOURCE = 0x800,
+	RESOURCE_STATE_PRESENT = 0,
+};
+
+struct RenderGraphBarrier
+{
+	enum Type : uint32_t
+	{
+		TYPE_TRANSITION,
+		// Split transition: the begin half is issued as early as possible, the end half right before the use
+		TYPE_BEGIN_ONLY,
+		TYPE_END_ONLY,
+		TYPE_UAV,
+		// resource takes over transient memory from aliased_resource, any_resource when several did
+		TYPE_ALIASING,
+	};
+
+	static const uint32_t any_resource = ~0u;
+
+	Type type;
+	uint32_t resource;
+	uint32_t state_before;
+	uint32_t state_after;
+	uint32_t aliased_resource;
+};
+
+// Passes declare the resources they read and write, Compile derives the
+// barriers between them. Barriers are batched per pass, so every batch goes
+// into one ResourceBarrier call. Consecutive reads share one combined read
+// state, and a transition whose resource sits idle for at least one pass
+// is split so the GPU can overlap it with the passes in between. Both halves
+// of a split must go into the same command list, so the batches from a begin
+// to its end have to be recorded in order on one list; NullDevice reports a
+// split spanning two lists.
+// Transient resources live only between their first and last pass and are
+// packed into one heap, resources never alive at the same time sharing memory.
+class RenderGraph
+{
+public:
+	// Resources owned outside the graph. They enter in initial_state and are returned in final_state.
+	uint32_t ImportResource(const std::string& name, uint32_t initial_state, uint32_t final_state);
+	// Placed in the transient heap by Compile, created in the state of its first use.
+	// Memory comes in undefined, so the first use has to clear or fully overwrite it.
+	uint32_t CreateTransient(const std::string& name, uint64_t size, uint64_t alignment);
+	uint32_t AddPass(const std::string& name);
+
+	// A pass uses each resource in one state, the states of repeated declarations are combined
+	void Read(uint32_t pass, uint32_t resource, uint32_t state);
+	void Write(uint32_t pass, uint32_t resource, uint32_t state);
+
+	void Compile();
+	void Clear();
+
+	// Barriers to issue right before the pass, batch GetPassNum() holds those after the last pass
+	const std::vector<RenderGraphBarrier>& GetBarriers(uint32_t batch) const { return batches[batch]; }
+	uint32_t GetBatchNum() const { return static_cast<uint32_t>(batches.size()); }
+	uint32_t GetBarrierNum() const;
+
+	uint32_t GetPassNum() const { return static_cast<uint32_t>(pass_names.size()); }
+	uint32_t GetResourceNum() const { return static_cast<uint32_t>(resources.size()); }
+	const std::string& GetPassName(uint32_t pass) const { return pass_names[pass]; }
+	const std::string& GetResourceName(uint32_t resource) const { return resources[resource].name; }
+	bool IsTransient(uint32_t resource) const { return resources[resource].transient; }
+	// State the resource is in when the graph starts and after it ends
+	uint32_t GetInitialState(uint32_t resource) const { return resources[resource].initial_state; }
+
+	// Valid after Compile
+	uint64_t GetTransientOffset(uint32_t resource) const { return resources[resource].offset; }
+	uint64_t GetTransientHeapSize() const { return transient_planner.GetHeapSize(); }
+	uint64_t GetTransientUnaliasedSize() const { return transient_planner.GetUnaliasedSize(); }
+
+protected:
+	struct Resource
+	{
+		std::string name;
+		uint32_t initial_state;
+		uint32_t final_state;
+		bool transient;
+		uint64_t size;
+		uint64_t alignment;
+		uint64_t offset;
+	};
+
+	struct Access
+	{
+		uint32_t pass;
+		uint32_t resource;
+		uint32_t state;
+		bool write;
+	};
+
+	// Passes [first_pass, last_pass] using a resource in one state
+	struct Use
+	{
+		uint32_t first_pass;
+		uint32_t last_pass;
+		uint32_t state;
+		bool write;
+	};
+
+	void AddAccess(uint32_t pass, uint32_t resource, uint32_t state, bool write);
+	void CollectUses(uint32_t resource, std::vector<Use>& uses) const;
+	void PlanTransients();
+	void AddTransition(uint32_t resource, uint32_t state_before, uint32_t state_after, uint32_t idle_batch, uint32_t use_batch);
+
+	std::vector<std::string> pass_names;
+	std::vector<Resource> resources;
+	std::vector<Access> accesses;
+	std::vector<std::vector<RenderGraphBarrier>> batches;
+	TransientHeapPlanner transient_planner;
+};
@@ -3,65 +3,154 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
+#include <fstream>
+
 void Renderer::OnInit()
 {
 	LoadPipeline();
 	LoadAssets();
-	base_time = high_resolution_clock::now();
+	if (benchmark_options.enabled)
+	{
+		StartBenchmark();
+	}
+	frame_start_time = high_resolution_clock::now();
 }
 
 void Renderer::OnUpdate()
 {
-	high_resolution_clock::time_point current_time = high_resolution_clock::now();
-	duration<float> time_passed = duration_cast<duration<float>>(current_time - base_time);
-	base_time = high_resolution_clock::now();
-	angle += delta_rotation * time_passed.count();
-	eye_position += XMVECTOR({ sin(angle), 0.f, cos(angle) })*delta_forward*time_passed.count();
-
-	XMVECTOR focus_position = eye_position + XMVECTOR({ sin(angle), 0.f, cos(angle) });
-
-	XMVECTOR up_direction = XMVECTOR({ 0.0f, 1.f, 0.f });
-	view = XMMatrixLookAtLH(eye_position, focus_position, up_direction);
-	world_view_projection = XMMatrixTranspose(
-		XMMatrixTranspose(projection) *
-		XMMatrixTranspose(view) *
-		XMMatrixTranspose(world));
-	memcpy(constant_buffer_data_begin, &world_view_projection, sizeof(world_view_projection));
+	// The path starts once the assets landed, so warm-up frames draw the full scene
+	if (benchmark_running && uploader.IsUploadComplete(assets_upload_fence_value))
+	{
+		camera = benchmark.Step();
+		scene_version++;
+	}
+
+	// Camera motion is integrated on the window thread, only the latest snapshot is used here
+	frame_view = FrameView::FromCamera(camera, aspect_ratio);
+	view_projection = XMLoadFloat4x4(reinterpret_cast<const XMFLOAT4X4*>(frame_view.view_projection));
+}
+
+void Renderer::SetCamera(const CameraSnapshot& camera)
+{
+	// Input would make runs differ
+	if (benchmark_running)
+	{
+		return;
+	}
+	if (camera.version != this->camera.version)
+	{
+		scene_version++;
+	}
+	this->camera = camera;
 }
 
 void Renderer::OnRender()
 {
-	PopulateCommandList();
-	ID3D12CommandList* command_lists[] = { command_list.Get() };
+	const high_resolution_clock::time_point render_start_time = high_resolution_clock::now();
+	const duration<float, std::milli> frame_time = render_start_time - frame_start_time;
+	frame_start_time = render_start_time;
+
+	// A grown descriptor heap leaves earlier lists and bundles bound to the old one
+	if (bound_descriptor_generation != descriptor_heap.GetGeneration())
+	{
+		bound_descriptor_generation = descriptor_heap.GetGeneration();
+		InvalidateBundles();
+		scene_version++;
+	}
+
+	// A still scene resubmits the lists recorded for this back buffer and records only stale ones
+	FrameContext* frame = &frames[frame_context_index];
+	const bool scene_unchanged = scene_version == rendered_scene_version;
+	rendered_scene_version = scene_version;
+	if (use_command_list_cache && scene_unchanged)
+	{
+		CachedFrame& cached_frame = cached_frames[frame_index];
+		frame = &cached_frame.frame;
+		if (cached_frame.scene_version != scene_version)
+		{
+			WaitForFence(cached_frame.frame.fence_value);
+			cached_frame.frame.constants.Reset();
+			PopulateCommandList(cached_frame.frame);
+			cached_frame.scene_version = scene_version;
+		}
+		else
+		{
+			std::fill(recording_times.begin(), recording_times.end(), 0.f);
+		}
+		// MoveToNextFrame signals this value after the submission
+		cached_frame.frame.fence_value = fence_value;
+	}
+	else
+	{
+		PopulateCommandList(*frame);
+	}
+
+	// All recorded lists go to the queue in one ordered call, cached lists included,
+	// between the lists writing the frame's timestamps
+	gpu_profiler.Submit(frame->profile_slot, fence_value, frame_statistics.GetFrameNum(), frame->submitted_lists, executed_lists);
+	uploader.InsertWaits();
+	command_queue->ExecuteCommandLists(static_cast<UINT>(executed_lists.size()), executed_lists.data());
+
+	{
+		PROFILE_SCOPE("Present");
+		ThrowIfFailed(swap_chain->Present(0, 0));
+	}
 
-	command_queue->ExecuteCommandLists(_countof(command_lists), command_lists);
+	// The wait for a free frame below is left out of the CPU time
+	const duration<float, std::milli> cpu_time = high_resolution_clock::now() - render_start_time;
+	const uint64_t statistics_frame = frame_statistics.AddFrame(frame_time.count(), cpu_time.count(), frame->draw_num, frame->triangle_num, frame->state_change_num);
+	if (benchmark_running)
+	{
+		benchmark.AddFrame(statistics_frame);
+	}
 
-	ThrowIfFailed(swap_chain->Present(0, 0));
+	MoveToNextFrame();
+	PROFILE_END_FRAME();
 
-	WaitForPreviousFrame();
+	if (benchmark_running && benchmark.IsFinished())
+	{
+		FinishBenchmark();
+	}
 }
 
 void Renderer::OnDestroy()
 {
-	WaitForPreviousFrame();
+	WaitForGpu();
+	WriteFrameStatistics();
+	gpu_profiler.Destroy();
+	uploader.Destroy();
 	CloseHandle(fence_event);
 }
 
 void Renderer::OnKeyDown(UINT8 key)
 {
+	// Any key may change what gets recorded
+	scene_version++;
 	switch (key)
 	{
-	case 0x41 - 'a' + 'd':
-		delta_rotation = 1.f;
+	case 0x41 - 'a' + 'b':
+		use_bundles = !use_bundles;
+		break;
+	case 0x41 - 'a' + 'i':
+		use_indirect = !use_indirect;
+		break;
+	case 0x41 - 'a' + 'k':
+		use_sorted_draws = !use_sorted_draws;
+		break;
+	case 0x41 - 'a' + 'o':
+		use_occlusion_culling = !use_occlusion_culling;
 		break;
-	case 0x41 - 'a' + 'a':
-		delta_rotation = -1.f;
+	case 0x41 - 'a' + 'f':
+		use_frustum_culling = !use_frustum_culling;
 		break;
-	case 0x41 - 'a' + 'w':
-		delta_forward = 1.f;
+	case 0x41 - 'a' + 'c':
+		use_command_list_cache = !use_command_list_cache;
 		break;
-	case 0x41 - 'a' + 's':
-		delta_forward = -1.f;
+	case 0x41 - 'a' + 'p':
+		WriteProfileTrace();
+		break;
+	case 0x41 - 'a' + 'm':
+		WriteFrameStatistics();
 		break;
 	case VK_OEM_MINUS:
 		if (max_draw_call_num > 0)
@@ -84,29 +173,10 @@ void Renderer::OnKeyDown(UINT8 key)
 	}
 }
 
-void Renderer::OnKeyUp(UINT8 key)
-{
-	switch (key)
-	{
-	case 0x41 - 'a' + 'd':
-		delta_rotation = 0.0f;
-		break;
-	case 0x41 - 'a' + 'a':
-		delta_rotation = 0.0f;
-		break;
-	case 0x41 - 'a' + 'w':
-		delta_forward = 0.0f;
-		break;
-	case 0x41 - 'a' + 's':
-		delta_forward = 0.0f;
-		break;
-	default:
-		break;
-	}
-}
-
 void Renderer::LoadPipeline()
 {
+	PROFILE_SCOPE("LoadPipeline");
+
 	// Create debug layer
 	UINT dxgi_factory_flag = 0;
 #ifdef _DEBUG
@@ -160,9 +230,11 @@ void Renderer::LoadPipeline()
 	std::wstring obj_file = GetBinPath(model_file);
 	std::string obj_path(obj_file.begin(), obj_file.end());
 
-	ThrowIfFailed(model_loader.LoadModel(obj_path));
+	std::shared_ptr<ModelLoader> model = SyncWait(job_system, asset_loader.LoadModelAsync(obj_path, LoadPriority::Urgent));
+	model_loader = std::move(*model);
 	max_draw_call_num = model_loader.GetMaterialNum();
-	per_mateial_srv_heap_offset.resize(model_loader.GetMaterialNum());
+	material_texture_index.resize(model_loader.GetMaterialNum());
+	material_key_id.resize(model_loader.GetMaterialNum());
 
 	// Create descriptor heap for render target view
 
@@ -179,18 +251,44 @@ void Renderer::LoadPipeline()
 	dsv_heap_descriptor.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
 	ThrowIfFailed(device->CreateDescriptorHeap(&dsv_heap_descriptor, IID_PPV_ARGS(&dsv_heap)));
 
-	D3D12_DESCRIPTOR_HEAP_DESC cbv_src_heap_descriptor = {};
-	cbv_src_heap_descriptor.NumDescriptors = 2 + model_loader.GetTextureNum(); // CBV + empty SRV + n SRV
-	cbv_src_heap_descriptor.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-	cbv_src_heap_descriptor.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-	ThrowIfFailed(device->CreateDescriptorHeap(&cbv_src_heap_descriptor, IID_PPV_ARGS(&cbv_srv_heap)));
+	// Grows on demand, so models and streamed textures can come and go
+	descriptor_heap.Create(device.Get(), persistent_descriptor_num, transient_descriptor_num, deferred_releases);
 
-	// Create command allocator
-	ThrowIfFailed(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&command_allocator)));
+	// Create command allocators per frame and per command list slot
+	const UINT list_slot_num = std::min(job_system.GetThreadNum(), max_recording_list_num) + 2;
+	recording_times.resize(list_slot_num - 2);
+	frames.resize(frames_in_flight);
+	for (UINT frame_id = 0; frame_id < frames_in_flight; frame_id++)
+	{
+		CreateFrameContext(frames[frame_id], list_slot_num, frame_id);
+	}
+	for (UINT frame_id = 0; frame_id < frame_number; frame_id++)
+	{
+		CreateFrameContext(cached_frames[frame_id].frame, list_slot_num, frames_in_flight + frame_id);
+		cached_frames[frame_id].scene_version = 0;
+	}
+	// A submission is collected at the latest frames_in_flight frames after it
+	gpu_profiler.Create(device.Get(), command_queue.Get(), frames_in_flight + frame_number, frames_in_flight + 1);
+
+	// Create copy queue uploader and placed resource heaps
+	uploader.Create(device.Get(), command_queue.Get(), upload_ring_size);
+	gpu_memory.Create(device.Get(), deferred_releases);
+
+	// Create synchronization objects
+	ThrowIfFailed(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence)));
+	fence_value = 1;
+	deferred_releases.SetRecordingFenceValue(fence_value);
+	fence_event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+	if (fence_event == nullptr)
+	{
+		ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+	}
 }
 
 void Renderer::LoadAssets()
 {
+	PROFILE_SCOPE("LoadAssets");
+
 	// Create a root signature
 
 	D3D12_FEATURE_DATA_ROOT_SIGNATURE rs_feature_data = {};
@@ -200,14 +298,20 @@ void Renderer::LoadAssets()
 		rs_feature_data.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_0;
 	}
 
-	CD3DX12_DESCRIPTOR_RANGE1 ranges[2];
-	CD3DX12_ROOT_PARAMETER1 root_paramters[2];
+	CD3DX12_DESCRIPTOR_RANGE1 ranges[1];
+	CD3DX12_ROOT_PARAMETER1 root_paramters[4];
 
-	ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 0, 0, D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC);
-	ranges[1].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0, 0, D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC);
+	// Unbounded range over the whole heap, bound once per list. Free slots hold no view and Commit
+	// writes new views after earlier lists bound the table, so descriptors are volatile.
+	ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, UINT_MAX, 0, 0,
+		D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE | D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE);
 
-	root_paramters[0].InitAsDescriptorTable(1, &ranges[0], D3D12_SHADER_VISIBILITY_VERTEX);
-	root_paramters[1].InitAsDescriptorTable(1, &ranges[1], D3D12_SHADER_VISIBILITY_PIXEL);
+	// Constants are root CBVs pointing into the per-frame linear allocator
+	root_paramters[0].InitAsConstantBufferView(0, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE, D3D12_SHADER_VISIBILITY_VERTEX);
+	root_paramters[1].InitAsDescriptorTable(1, &ranges[0], D3D12_SHADER_VISIBILITY_PIXEL);
+	root_paramters[2].InitAsConstantBufferView(1, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE, D3D12_SHADER_VISIBILITY_VERTEX);
+	// Per-draw texture index into the bindless range
+	root_paramters[3].InitAsConstants(1, 2, 0, D3D12_SHADER_VISIBILITY_PIXEL);
 
 	D3D12_ROOT_SIGNATURE_FLAGS rs_flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
 
@@ -254,7 +358,7 @@ void Renderer::LoadAssets()
 
 	std::wstring shader_path = GetBinPath(std::wstring(L"shaders.hlsl"));
 	HRESULT vertex = D3DCompileFromFile(shader_path.c_str(), nullptr, nullptr,
-		"VSMain", "vs_5_0", compile_flags, 0, &vertex_shader, &error);
+		"VSMain", "vs_5_1", compile_flags, 0, &vertex_shader, &error);
 	if (error)
 	{
 		OutputDebugStringA((char *)error->GetBufferPointer());
@@ -262,7 +366,7 @@ void Renderer::LoadAssets()
 	ThrowIfFailed(vertex);
 
 	HRESULT pixel = D3DCompileFromFile(shader_path.c_str(), nullptr, nullptr,
-		"PSMain", "ps_5_0", compile_flags, 0, &pixel_shader, &error);
+		"PSMain", "ps_5_1", compile_flags, 0, &pixel_shader, &error);
 	if (error)
 	{
 		OutputDebugStringA((char *)error->GetBufferPointer());
@@ -299,9 +403,15 @@ void Renderer::LoadAssets()
 	pso_descriptor.SampleDesc.Count = 1;
 	ThrowIfFailed(device->CreateGraphicsPipelineState(&pso_descriptor, IID_PPV_ARGS(&pipeline_state)));
 
-	// Create command list
-	ThrowIfFailed(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, command_allocator.Get(),
-		pipeline_state.Get(), IID_PPV_ARGS(&command_list)));
+	// Create command lists, closed until their frame records into them
+	for (FrameContext& frame : frames)
+	{
+		CreateFrameCommandLists(frame);
+	}
+	for (CachedFrame& cached_frame : cached_frames)
+	{
+		CreateFrameCommandLists(cached_frame.frame);
+	}
 
 	// Create render target view for each frame
 	CD3DX12_CPU_DESCRIPTOR_HANDLE rtv_handle(rtv_heap->GetCPUDescriptorHandleForHeapStart());
@@ -315,133 +425,39 @@ void Renderer::LoadAssets()
 		rtv_handle.Offset(1, rtv_descriptor_size);
 	}
 
-	// Create depth stencil
-	CD3DX12_RESOURCE_DESC depth_texture_descriptor(
-		D3D12_RESOURCE_DIMENSION_TEXTURE2D,
-		0,
-		this->width,
-		this->height,
-		1,
-		1,
-		DXGI_FORMAT_D32_FLOAT,
-		1,
-		0,
-		D3D12_TEXTURE_LAYOUT_UNKNOWN,
-		D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL | D3D12_RESOURCE_FLAG_DENY_SHADER_RESOURCE
-	);
-	D3D12_CLEAR_VALUE clear_value;
-	clear_value.Format = DXGI_FORMAT_D32_FLOAT;
-	clear_value.DepthStencil.Depth = 1.f;
-	clear_value.DepthStencil.Stencil = 0;
-
-	ThrowIfFailed(device->CreateCommittedResource(
-		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-		D3D12_HEAP_FLAG_NONE,
-		&depth_texture_descriptor,
-		D3D12_RESOURCE_STATE_DEPTH_WRITE,
-		&clear_value,
-		IID_PPV_ARGS(&depth_stencil)
-	));
-	depth_stencil->SetName(L"Depth stencil");
-
-	device->CreateDepthStencilView(depth_stencil.Get(), nullptr, dsv_heap->GetCPUDescriptorHandleForHeapStart());
-
 	// Create and upload vertex buffer
 
-	ThrowIfFailed(device->CreateCommittedResource(
-		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-		D3D12_HEAP_FLAG_NONE,
-		&CD3DX12_RESOURCE_DESC::Buffer(model_loader.GetVertexBufferSize()),
-		D3D12_RESOURCE_STATE_COPY_DEST,
+	gpu_memory.CreatePlacedResource(
+		CD3DX12_RESOURCE_DESC::Buffer(model_loader.GetVertexBufferSize()),
+		D3D12_RESOURCE_STATE_COMMON,
 		nullptr,
-		IID_PPV_ARGS(&vertex_buffer)));
+		vertex_buffer,
+		vertex_buffer_allocation);
 
 	vertex_buffer->SetName(L"Vertex buffer");
-	{
-		ThrowIfFailed(device->CreateCommittedResource(
-			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-			D3D12_HEAP_FLAG_NONE,
-			&CD3DX12_RESOURCE_DESC::Buffer(model_loader.GetVertexBufferSize()),
-			D3D12_RESOURCE_STATE_GENERIC_READ,
-			nullptr,
-			IID_PPV_ARGS(&upload_vertex_buffer)));
-		
-		D3D12_SUBRESOURCE_DATA vertex_data = {};
-		vertex_data.pData = model_loader.GetVertexBuffer();
-		vertex_data.RowPitch = model_loader.GetVertexBufferSize();
-		vertex_data.SlicePitch = model_loader.GetVertexBufferSize();
-
-		UpdateSubresources(command_list.Get(), vertex_buffer.Get(), upload_vertex_buffer.Get(),
-			0, 0, 1, &vertex_data);
-		command_list->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(
-			vertex_buffer.Get(),
-			D3D12_RESOURCE_STATE_COPY_DEST,
-			D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER
-		));
-	}
+	uploader.UploadBuffer(vertex_buffer.Get(), model_loader.GetVertexBuffer(), model_loader.GetVertexBufferSize());
 
 	vertex_buffer_view.BufferLocation = vertex_buffer->GetGPUVirtualAddress();
 	vertex_buffer_view.StrideInBytes = sizeof(FullVertex);
 	vertex_buffer_view.SizeInBytes = model_loader.GetVertexBufferSize();
 
 	// Create Index buffer
-	ThrowIfFailed(device->CreateCommittedResource(
-		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-		D3D12_HEAP_FLAG_NONE,
-		&CD3DX12_RESOURCE_DESC::Buffer(model_loader.GetIndexBufferSize()),
-		D3D12_RESOURCE_STATE_COPY_DEST,
+	gpu_memory.CreatePlacedResource(
+		CD3DX12_RESOURCE_DESC::Buffer(model_loader.GetIndexBufferSize()),
+		D3D12_RESOURCE_STATE_COMMON,
 		nullptr,
-		IID_PPV_ARGS(&index_buffer)));
+		index_buffer,
+		index_buffer_allocation);
 	index_buffer->SetName(L"Index buffer");
-	{
-		ThrowIfFailed(device->CreateCommittedResource(
-			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-			D3D12_HEAP_FLAG_NONE,
-			&CD3DX12_RESOURCE_DESC::Buffer(model_loader.GetIndexBufferSize()),
-			D3D12_RESOURCE_STATE_GENERIC_READ,
-			nullptr,
-			IID_PPV_ARGS(&upload_index_buffer)));
-
-		D3D12_SUBRESOURCE_DATA index_data = {};
-		index_data.pData = model_loader.GetIndexBuffer();
-		index_data.RowPitch = model_loader.GetIndexBufferSize();
-		index_data.SlicePitch = model_loader.GetIndexBufferSize();
-
-		UpdateSubresources(command_list.Get(), index_buffer.Get(), upload_index_buffer.Get(),
-			0, 0, 1, &index_data);
-		command_list->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(
-			index_buffer.Get(),
-			D3D12_RESOURCE_STATE_COPY_DEST,
-			D3D12_RESOURCE_STATE_INDEX_BUFFER
-		));
-	}
+	uploader.UploadBuffer(index_buffer.Get(), model_loader.GetIndexBuffer(), model_loader.GetIndexBufferSize());
 
 	index_buffer_view.BufferLocation = index_buffer->GetGPUVirtualAddress();
 	index_buffer_view.SizeInBytes = model_loader.GetIndexBufferSize();
 	index_buffer_view.Format = DXGI_FORMAT_R32_UINT;
 
-	// Constant buffer init
-	ThrowIfFailed(device->CreateCommittedResource(
-		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-		D3D12_HEAP_FLAG_NONE,
-		&CD3DX12_RESOURCE_DESC::Buffer(1024 * 64),
-		D3D12_RESOURCE_STATE_GENERIC_READ,
-		nullptr,
-		IID_PPV_ARGS(&constant_buffer)));
-
-	CD3DX12_CPU_DESCRIPTOR_HANDLE cbv_srv_heap_handle(cbv_srv_heap->GetCPUDescriptorHandleForHeapStart());
-	const UINT cbv_srv_descriptor_size = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-
-	D3D12_CONSTANT_BUFFER_VIEW_DESC cbv_descriptor = {};
-	cbv_descriptor.BufferLocation = constant_buffer->GetGPUVirtualAddress();
-	cbv_descriptor.SizeInBytes = (sizeof(world_view_projection) + 255) & ~255;
-	cbv_srv_heap_handle.InitOffsetted(cbv_srv_heap->GetCPUDescriptorHandleForHeapStart(), 0, cbv_srv_descriptor_size);
-	
-	device->CreateConstantBufferView(&cbv_descriptor, cbv_srv_heap_handle);
-
-	CD3DX12_RANGE read_range(0, 0); 
-	ThrowIfFailed(constant_buffer->Map(0, &read_range, reinterpret_cast<void**>(&constant_buffer_data_begin)));
-	memcpy(constant_buffer_data_begin, &world_view_projection, sizeof(world_view_projection));
+	// The model takes one persistent range: the empty SRV, then at most one SRV per texture
+	texture_descriptor_num = 1 + model_loader.GetTextureNum();
+	texture_descriptor_first = descriptor_heap.AllocatePersistent(texture_descriptor_num);
 
 	// Create empty SRV
 	{
@@ -453,27 +469,48 @@ void Renderer::LoadAssets()
 		empty_srv_descriptor.Texture2D.MostDetailedMip = 0;
 		empty_srv_descriptor.Texture2D.ResourceMinLODClamp = 0.0f;
 
-		cbv_srv_heap_handle.InitOffsetted(cbv_srv_heap->GetCPUDescriptorHandleForHeapStart(), 1, cbv_srv_descriptor_size);
-		device->CreateShaderResourceView(nullptr, &empty_srv_descriptor, cbv_srv_heap_handle);
+		texture_table.Reset(texture_descriptor_first, texture_descriptor_first + 1);
+		device->CreateShaderResourceView(nullptr, &empty_srv_descriptor, descriptor_heap.StageDescriptor(texture_table.GetEmptyIndex()));
 	}
-	// Create texture
-	UINT heap_index = 2;
+	// Assign descriptors first, materials sharing a file share its descriptor
+	std::vector<std::string> texture_files;
+	std::vector<UINT> texture_heap_indices;
 	for (UINT material_id = 0; material_id < model_loader.GetMaterialNum(); material_id++)
 	{
-		if (!model_loader.HasTexture(material_id))
+		std::string tex_file = model_loader.HasTexture(material_id) ? model_loader.GetTexturePath(material_id) : std::string();
+		bool is_new_texture;
+		const UINT heap_index = texture_table.Assign(tex_file, is_new_texture);
+		material_texture_index[material_id] = heap_index;
+		material_key_id[material_id] = texture_table.GetMaterialId(heap_index);
+		if (is_new_texture)
 		{
-			per_mateial_srv_heap_offset[material_id] = 1;
-			continue;
+			texture_files.push_back(tex_file);
+			texture_heap_indices.push_back(heap_index);
 		}
-		std::string tex_file = model_loader.GetTexturePath(material_id);
-		int tex_width, tex_height, tex_channels;
-		unsigned char* image = stbi_load(
-			tex_file.c_str(),
-			&tex_width,
-			&tex_height,
-			&tex_channels,
-			STBI_rgb_alpha
-		);
+	}
+
+	material_descriptors = texture_table.GetMaterialDescriptors();
+	if (material_descriptors.size() > (1u << DrawKey::material_bits))
+	{
+		OutputDebugString(L"More textures than draw keys can address\n");
+		ThrowIfFailed(E_INVALIDARG);
+	}
+
+	// Decoding dominates texture loading and every file is independent
+	std::vector<Task<std::shared_ptr<TextureImage>>> texture_loads;
+	for (const std::string& tex_file : texture_files)
+	{
+		texture_loads.push_back(asset_loader.LoadTextureAsync(tex_file));
+	}
+	std::vector<std::shared_ptr<TextureImage>> images = SyncWait(job_system, WhenAll(std::move(texture_loads)));
+
+	// Create textures
+	for (size_t texture_id = 0; texture_id < texture_files.size(); texture_id++)
+	{
+		const UINT heap_index = texture_heap_indices[texture_id];
+		const TextureImage& image = *images[texture_id];
+		const UINT tex_width = image.GetWidth();
+		const UINT tex_height = image.GetHeight();
 
 		D3D12_RESOURCE_DESC  texture_descriptor = {};
 		texture_descriptor.Width = tex_width;
@@ -487,41 +524,23 @@ void Renderer::LoadAssets()
 		texture_descriptor.Flags = D3D12_RESOURCE_FLAG_NONE;
 
 		ComPtr<ID3D12Resource> texture;
+		GpuAllocation texture_allocation;
 
-		ThrowIfFailed(device->CreateCommittedResource(
-			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-			D3D12_HEAP_FLAG_NONE,
-			&texture_descriptor,
-			D3D12_RESOURCE_STATE_COPY_DEST,
+		gpu_memory.CreatePlacedResource(
+			texture_descriptor,
+			D3D12_RESOURCE_STATE_COMMON,
 			nullptr,
-			IID_PPV_ARGS(&texture)));
+			texture,
+			texture_allocation);
 
 		texture->SetName(L"Texture");
 
-		ComPtr<ID3D12Resource> upload_texture;
-
-		const UINT64 upload_buffer_size = GetRequiredIntermediateSize(texture.Get(), 0, 1);
-
-		ThrowIfFailed(device->CreateCommittedResource(
-			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-			D3D12_HEAP_FLAG_NONE,
-			&CD3DX12_RESOURCE_DESC::Buffer(upload_buffer_size),
-			D3D12_RESOURCE_STATE_GENERIC_READ,
-			nullptr,
-			IID_PPV_ARGS(&upload_texture)));
-
 		D3D12_SUBRESOURCE_DATA texture_data = {};
-		texture_data.pData = image;
-		texture_data.RowPitch = tex_width * STBI_rgb_alpha;
+		texture_data.pData = image.GetPixels();
+		texture_data.RowPitch = image.GetRowPitch();
 		texture_data.SlicePitch = texture_data.RowPitch * tex_height;
 
-		UpdateSubresources(command_list.Get(), texture.Get(), upload_texture.Get(),
-			0, 0, 1, &texture_data);
-		command_list->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(
-			texture.Get(),
-			D3D12_RESOURCE_STATE_COPY_DEST,
-			D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE
-		));
+		uploader.UploadTexture(texture.Get(), texture_data);
 		
 		D3D12_SHADER_RESOURCE_VIEW_DESC srv_descriptor = {};
 		srv_descriptor.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
@@ -529,103 +548,542 @@ void Renderer::LoadAssets()
 		srv_descriptor.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
 		srv_descriptor.Texture2D.MipLevels = 1;
 
-		cbv_srv_heap_handle.InitOffsetted(cbv_srv_heap->GetCPUDescriptorHandleForHeapStart(), heap_index, cbv_srv_descriptor_size);
-		device->CreateShaderResourceView(texture.Get(), &srv_descriptor, cbv_srv_heap_handle);
+		device->CreateShaderResourceView(texture.Get(), &srv_descriptor, descriptor_heap.StageDescriptor(heap_index));
 
-		per_mateial_srv_heap_offset[material_id] = heap_index;
-		heap_index++;
 		textures.push_back(texture);
-		upload_textures.push_back(upload_texture);
+		texture_allocations.push_back(texture_allocation);
 	}
 
+	descriptor_heap.Commit();
+
+	CreateIndirectArguments();
+	BuildRenderGraph();
+	CreateDrawStages();
+
+	// Draws wait on the copy queue only until these uploads land
+	assets_upload_fence_value = uploader.Submit();
+	uploader.RequireUpload(assets_upload_fence_value);
+
+	OutputDebugString(gpu_memory.GetStatisticsString().c_str());
+	std::wstring upload_memory = L"Upload ring: " + std::to_wstring(uploader.GetRingHighWaterMark() / 1024) + L" KB of " +
+		std::to_wstring(uploader.GetRingSize() / 1024) + L" KB at peak\n";
+	OutputDebugString(upload_memory.c_str());
+}
+
+void Renderer::CreateFrameContext(FrameContext& frame, UINT list_slot_num, UINT profile_slot)
+{
+	frame.command_allocators.resize(list_slot_num);
+	for (ComPtr<ID3D12CommandAllocator>& command_allocator : frame.command_allocators)
+	{
+		ThrowIfFailed(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&command_allocator)));
+	}
+	frame.constants.Create(device.Get(), frame_constants_size);
+	frame.pass_constants = 0;
+	frame.model_constants = 0;
+	frame.indirect_counts = 0;
+	frame.fence_value = 0;
+	frame.profile_slot = profile_slot;
+	frame.draw_num = 0;
+	frame.triangle_num = 0;
+	frame.state_change_num = 0;
+}
+
+void Renderer::CreateFrameCommandLists(FrameContext& frame)
+{
+	for (ComPtr<ID3D12CommandAllocator>& command_allocator : frame.command_allocators)
+	{
+		ComPtr<ID3D12GraphicsCommandList> command_list;
+		ThrowIfFailed(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, command_allocator.Get(),
+			pipeline_state.Get(), IID_PPV_ARGS(&command_list)));
+		ThrowIfFailed(command_list->Close());
+		frame.command_lists.push_back(command_list);
+	}
+}
+
+void Renderer::PopulateCommandList(FrameContext& frame)
+{
+	PROFILE_SCOPE("PopulateCommandList");
+	const UINT frame_end_slot = static_cast<UINT>(frame.command_lists.size()) - 1;
+
+	// Constants are written up front, the frame allocator is not thread safe
+	const UINT draw_num = std::min(model_loader.GetMaterialNum(), max_draw_call_num);
+	PassConstants pass_constants = {};
+	pass_constants.view_projection = view_projection;
+	frame.pass_constants = frame.constants.Allocate(pass_constants);
+	DrawConstants draw_constants = {};
+	draw_constants.world = world;
+	frame.model_constants = frame.constants.Allocate(draw_constants);
+
+	// Barriers come from the render graph, the back buffer changes every frame
+	graph_resources[frame_graph.back_buffer_resource] = render_targets[frame_index].Get();
+	graph_views[frame_graph.back_buffer_resource] = CD3DX12_CPU_DESCRIPTOR_HANDLE(rtv_heap->GetCPUDescriptorHandleForHeapStart(),
+		frame_index, rtv_descriptor_size);
+
+	// Clears, then the barriers of the scene pass so the draw lists start from the right states.
+	// Timestamps bracket each graph pass, the graph is built once so its names stay put.
+	ID3D12GraphicsCommandList* command_list = ResetCommandList(frame, 0);
+	gpu_profiler.BeginFrame(frame.profile_slot);
+	gpu_profiler.BeginRange(command_list, frame.profile_slot, render_graph.GetPassName(frame_graph.clear_pass).c_str());
+	D3D12CommandRecorder recorder(command_list, recording_context);
+	RecordClearPass(recorder, render_graph, frame_graph);
+	gpu_profiler.EndRange(command_list, frame.profile_slot);
+	gpu_profiler.BeginRange(command_list, frame.profile_slot, render_graph.GetPassName(frame_graph.scene_pass).c_str());
+	recorder.RecordBatch(render_graph, frame_graph.scene_pass);
 	ThrowIfFailed(command_list->Close());
-	ID3D12CommandList* command_lists[] = { command_list.Get() };
-	command_queue->ExecuteCommandLists(_countof(command_lists), command_lists);
 
-	// Create synchronization objects
-	ThrowIfFailed(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence)));
-	fence_value = 1;
-	fence_event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-	if (fence_event == nullptr)
+	// Record draws on worker threads, small frames stay on a single list
+	const UINT max_list_num = frame_end_slot - 1;
+	UINT submitted_draw_num = draw_num;
+	if (use_indirect && draw_num > 0)
 	{
-		ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+		// One list is enough, its cost does not depend on the draw count
+		recording_list_num = 1;
+		std::vector<UINT> counts(indirect_draw_builder.GetGroups().size());
+		indirect_draw_builder.WriteCounts(draw_num, counts.data());
+		frame.indirect_counts = frame.constants.Allocate(counts.data(), indirect_draw_builder.GetCountBufferSize());
+	}
+	else
+	{
+		// Culled draws drop out of the packet stream
+		draw_stages.BuildDrawPackets(frame_view, draw_num, GetDrawStageOptions(), job_system);
+		submitted_draw_num = static_cast<UINT>(draw_stages.GetDrawPackets().size());
+		recording_list_num = DrawStages::GetListNum(submitted_draw_num, max_list_num);
+	}
+	const std::vector<DrawPacket>& draw_packets = draw_stages.GetDrawPackets();
+	if (!use_indirect && !IsReplayingBundles())
+	{
+		// The model is drawn untransformed, per-object transforms only change what is written here
+		frame.draw_constants.resize(draw_num);
+		for (const DrawPacket& packet : draw_packets)
+		{
+			DrawConstants packet_constants = {};
+			packet_constants.world = world;
+			frame.draw_constants[packet.draw_id] = frame.constants.Allocate(packet_constants);
+		}
+	}
+	frame.draw_num = submitted_draw_num;
+	frame.triangle_num = 0;
+	for (UINT draw = 0; draw < submitted_draw_num; draw++)
+	{
+		const UINT material_id = use_indirect ? draw : draw_packets[draw].draw_id;
+		frame.triangle_num += model_loader.GetDrawCallParams(material_id).index_num / 3;
+	}
+	// Indirect commands each set their material constant
+	frame.state_change_num = use_indirect ? submitted_draw_num : draw_stages.GetSortedStateChanges().GetTotal();
+	std::fill(recording_times.begin(), recording_times.end(), 0.f);
+	const bool replay_bundles = IsReplayingBundles();
+	if (replay_bundles && bundle_set.IsStale(draw_num, recording_list_num, use_sorted_draws))
+	{
+		InvalidateBundles();
+		draw_bundles.resize(recording_list_num);
+		bundle_set.Record(draw_packets, draw_num, recording_list_num, use_sorted_draws);
+	}
+	job_system.ParallelFor(recording_list_num, [&](uint32_t list_index)
+	{
+		const UINT first_draw = DrawStages::GetListDraw(submitted_draw_num, recording_list_num, list_index);
+		const UINT last_draw = DrawStages::GetListDraw(submitted_draw_num, recording_list_num, list_index + 1);
+		if (replay_bundles && !draw_bundles[list_index].bundle)
+		{
+			DrawBundle& draw_bundle = draw_bundles[list_index];
+			draw_bundle.first_draw = first_draw;
+			draw_bundle.last_draw = last_draw;
+			RecordBundle(draw_bundle);
+		}
+		RecordDraws(frame, list_index + 1, first_draw, last_draw);
+	});
+
+	command_list = ResetCommandList(frame, frame_end_slot);
+	gpu_profiler.EndRange(command_list, frame.profile_slot);
+	D3D12CommandRecorder end_recorder(command_list, recording_context);
+	RecordFrameEnd(end_recorder, render_graph);
+	ThrowIfFailed(command_list->Close());
+
+	frame.submitted_lists.clear();
+	for (UINT list_slot = 0; list_slot <= recording_list_num; list_slot++)
+	{
+		frame.submitted_lists.push_back(frame.command_lists[list_slot].Get());
 	}
+	frame.submitted_lists.push_back(frame.command_lists[frame_end_slot].Get());
 }
 
-void Renderer::PopulateCommandList()
+void Renderer::SetDrawState(ID3D12GraphicsCommandList* list, const FrameContext& frame)
 {
-	// Reset allocators and lists
-	ThrowIfFailed(command_allocator->Reset());
+	// Every list starts from default state, so each one binds everything it uses
+	list->SetGraphicsRootSignature(root_signature.Get());
+	ID3D12DescriptorHeap* heaps[] = { descriptor_heap.GetHeap() };
+	list->SetDescriptorHeaps(_countof(heaps), heaps);
+	list->SetGraphicsRootConstantBufferView(0, frame.pass_constants);
+	list->SetGraphicsRootConstantBufferView(D3D12CommandRecorder::draw_constants_parameter, frame.model_constants);
+	list->RSSetViewports(1, &view_port);
+	list->RSSetScissorRects(1, &scissor_rect);
+	D3D12CommandRecorder recorder(list, recording_context);
+	BeginSceneDraws(recorder, frame_graph);
+	list->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	list->IASetVertexBuffers(0, 1, &vertex_buffer_view);
+	list->IASetIndexBuffer(&index_buffer_view);
+}
 
-	ThrowIfFailed(command_list->Reset(command_allocator.Get(), pipeline_state.Get()));
+void Renderer::RecordDraws(FrameContext& frame, UINT list_slot, UINT first_draw, UINT last_draw)
+{
+	PROFILE_SCOPE("Record draws");
+	high_resolution_clock::time_point start_time = high_resolution_clock::now();
 
-	// Set initial state
-	command_list->SetGraphicsRootSignature(root_signature.Get());
-	ID3D12DescriptorHeap* heaps[] = { cbv_srv_heap.Get() };
-	command_list->SetDescriptorHeaps(_countof(heaps), heaps);
+	ID3D12GraphicsCommandList* command_list = ResetCommandList(frame, list_slot);
+	SetDrawState(command_list, frame);
 
-	const UINT cbv_srv_descriptor_size = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-	CD3DX12_GPU_DESCRIPTOR_HANDLE cbv_srv_handle(cbv_srv_heap->GetGPUDescriptorHandleForHeapStart());
-	command_list->SetGraphicsRootDescriptorTable(0, cbv_srv_handle);
-	command_list->RSSetViewports(1, &view_port);
-	command_list->RSSetScissorRects(1, &scissor_rect);
+	if (use_indirect)
+	{
+		RecordIndirectDraws(command_list, frame);
+	}
+	else if (IsReplayingBundles())
+	{
+		command_list->ExecuteBundle(draw_bundles[list_slot - 1].bundle.Get());
+	}
+	else
+	{
+		D3D12CommandRecorder recorder(command_list, recording_context, &frame.draw_constants);
+		const std::vector<DrawPacket>& draw_packets = draw_stages.GetDrawPackets();
+		SubmitDrawPackets(draw_packets.data() + first_draw, draw_packets.data() + last_draw, &recorder);
+	}
+	ThrowIfFailed(command_list->Close());
 
-	// Resource barrier from present to RT
-	command_list->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(
-		render_targets[frame_index].Get(),
-		D3D12_RESOURCE_STATE_PRESENT,
-		D3D12_RESOURCE_STATE_RENDER_TARGET
-	));
+	duration<float, std::milli> recording_time = high_resolution_clock::now() - start_time;
+	recording_times[list_slot - 1] = recording_time.count();
+}
 
-	// Record commands
-	CD3DX12_CPU_DESCRIPTOR_HANDLE rtv_handle(rtv_heap->GetCPUDescriptorHandleForHeapStart(),
-		frame_index, rtv_descriptor_size);
-	CD3DX12_CPU_DESCRIPTOR_HANDLE dsv_handle(dsv_heap->GetCPUDescriptorHandleForHeapStart());
-	command_list->OMSetRenderTargets(1, &rtv_handle, FALSE, &dsv_handle);
-	const float clear_color[] = { 0.f, 0.f, 0.f, 1.f };
-	command_list->ClearRenderTargetView(rtv_handle, clear_color, 0, nullptr);
-	command_list->ClearDepthStencilView(dsv_handle, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
-	command_list->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-	command_list->IASetVertexBuffers(0, 1, &vertex_buffer_view);
-	command_list->IASetIndexBuffer(&index_buffer_view);
-	for (UINT material_id = 0; 
-		material_id < model_loader.GetMaterialNum() && \
-		material_id < max_draw_call_num; 
-		material_id++)
-	{
-		UINT offset = per_mateial_srv_heap_offset[material_id];
-		cbv_srv_handle.InitOffsetted(cbv_srv_heap->GetGPUDescriptorHandleForHeapStart(), offset, cbv_srv_descriptor_size);
-		command_list->SetGraphicsRootDescriptorTable(1, cbv_srv_handle);
+ID3D12GraphicsCommandList* Renderer::ResetCommandList(FrameContext& frame, UINT list_slot)
+{
+	// The frame fence has retired, so its allocators are idle
+	ID3D12CommandAllocator* command_allocator = frame.command_allocators[list_slot].Get();
+	ID3D12GraphicsCommandList* command_list = frame.command_lists[list_slot].Get();
+	ThrowIfFailed(command_allocator->Reset());
+	ThrowIfFailed(command_list->Reset(command_allocator, pipeline_state.Get()));
+	return command_list;
+}
+
+void Renderer::RecordBundle(DrawBundle& draw_bundle)
+{
+	ThrowIfFailed(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_BUNDLE,
+		IID_PPV_ARGS(&draw_bundle.command_allocator)));
+	ThrowIfFailed(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_BUNDLE, draw_bundle.command_allocator.Get(),
+		pipeline_state.Get(), IID_PPV_ARGS(&draw_bundle.bundle)));
+
+	// Root signature and heaps must match the calling list, root arguments are inherited from it
+	ID3D12GraphicsCommandList* bundle = draw_bundle.bundle.Get();
+	bundle->SetGraphicsRootSignature(root_signature.Get());
+	ID3D12DescriptorHeap* heaps[] = { descriptor_heap.GetHeap() };
+	bundle->SetDescriptorHeaps(_countof(heaps), heaps);
+	bundle->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	bundle->IASetVertexBuffers(0, 1, &vertex_buffer_view);
+	bundle->IASetIndexBuffer(&index_buffer_view);
+
+	// Depth order is frozen at recording time, state grouping stays valid
+	D3D12CommandRecorder recorder(bundle, recording_context);
+	const std::vector<DrawPacket>& draw_packets = draw_stages.GetDrawPackets();
+	SubmitDrawPackets(draw_packets.data() + draw_bundle.first_draw, draw_packets.data() + draw_bundle.last_draw, &recorder);
+	ThrowIfFailed(bundle->Close());
+}
+
+void Renderer::CreateDrawStages()
+{
+	const UINT material_num = model_loader.GetMaterialNum();
+	std::vector<OcclusionBounds> draw_bounds(material_num);
+	std::vector<OccluderMesh> meshes(material_num);
+	for (UINT material_id = 0; material_id < material_num; material_id++)
+	{
+		const MaterialBounds bounds = model_loader.GetBounds(material_id);
+		draw_bounds[material_id] = {
+			{ bounds.min.x, bounds.min.y, bounds.min.z },
+			{ bounds.max.x, bounds.max.y, bounds.max.z } };
+		const DrawCallParams params = model_loader.GetDrawCallParams(material_id);
+		meshes[material_id] = { &model_loader.GetVertexBuffer()->position, sizeof(FullVertex),
+			model_loader.GetIndexBuffer() + params.start_index, params.index_num, params.start_vertex };
+	}
+	draw_stages.SetDraws(draw_bounds, material_key_id);
+	draw_stages.SelectOccluders(meshes);
+}
+
+void Renderer::RecordIndirectDraws(ID3D12GraphicsCommandList* command_list, const FrameContext& frame)
+{
+	// Texture indices travel in the argument buffer, so all draws form one group and one call
+	const UINT64 counts_offset = frame.constants.GetOffset(frame.indirect_counts);
+	const std::vector<IndirectDrawGroup>& groups = indirect_draw_builder.GetGroups();
+	for (UINT group_id = 0; group_id < groups.size(); group_id++)
+	{
+		const IndirectDrawGroup& group = groups[group_id];
+		command_list->ExecuteIndirect(
+			command_signature.Get(),
+			group.command_num,
+			indirect_argument_buffer.Get(),
+			group.first_command * sizeof(IndirectDrawCommand),
+			frame.constants.GetResource(),
+			counts_offset + group_id * sizeof(UINT));
+	}
+}
+
+void Renderer::CreateIndirectArguments()
+{
+	static_assert(sizeof(IndirectDrawArguments) == sizeof(D3D12_DRAW_INDEXED_ARGUMENTS),
+		"Argument buffer layout must match the command signature");
+
+	static_assert(sizeof(IndirectDrawCommand) == sizeof(UINT) + sizeof(D3D12_DRAW_INDEXED_ARGUMENTS),
+		"Argument buffer layout must match the command signature");
+
+	// Each record sets the texture index root constant, then draws
+	D3D12_INDIRECT_ARGUMENT_DESC indirect_arguments[2] = {};
+	indirect_arguments[0].Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
+	indirect_arguments[0].Constant.RootParameterIndex = 3;
+	indirect_arguments[0].Constant.DestOffsetIn32BitValues = 0;
+	indirect_arguments[0].Constant.Num32BitValuesToSet = 1;
+	indirect_arguments[1].Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+
+	D3D12_COMMAND_SIGNATURE_DESC command_signature_descriptor = {};
+	command_signature_descriptor.ByteStride = sizeof(IndirectDrawCommand);
+	command_signature_descriptor.NumArgumentDescs = _countof(indirect_arguments);
+	command_signature_descriptor.pArgumentDescs = indirect_arguments;
+	ThrowIfFailed(device->CreateCommandSignature(&command_signature_descriptor, root_signature.Get(), IID_PPV_ARGS(&command_signature)));
+
+	// Draw table of the model plus per-instance data, one instance per draw for now
+	std::vector<IndirectDrawInput> draws(model_loader.GetMaterialNum());
+	for (UINT material_id = 0; material_id < model_loader.GetMaterialNum(); material_id++)
+	{
 		DrawCallParams params = model_loader.GetDrawCallParams(material_id);
-		command_list->DrawIndexedInstanced(params.index_num, 1, params.start_index, params.start_vertex, 0);
-	}
-	
-	// Resource barrier from RT to present
-	command_list->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(
-		render_targets[frame_index].Get(),
-		D3D12_RESOURCE_STATE_RENDER_TARGET,
-		D3D12_RESOURCE_STATE_PRESENT
-	));
+		draws[material_id].index_num = params.index_num;
+		draws[material_id].start_index = params.start_index;
+		draws[material_id].start_vertex = params.start_vertex;
+		draws[material_id].instance_num = 1;
+		draws[material_id].start_instance = 0;
+		draws[material_id].material_index = material_texture_index[material_id];
+		draws[material_id].group_key = 0;
+	}
+	indirect_draw_builder.Build(draws);
+	if (draws.empty())
+	{
+		return;
+	}
 
-	// Close command list
-	ThrowIfFailed(command_list->Close());
+	// Kept UAV-capable so a culling compute pass can rewrite it later. A previous
+	// model's buffer may still be read by frames in flight.
+	if (indirect_argument_buffer)
+	{
+		gpu_memory.Release(indirect_argument_buffer, indirect_argument_buffer_allocation);
+	}
+	gpu_memory.CreatePlacedResource(
+		CD3DX12_RESOURCE_DESC::Buffer(indirect_draw_builder.GetArgumentBufferSize(), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
+		D3D12_RESOURCE_STATE_COMMON,
+		nullptr,
+		indirect_argument_buffer,
+		indirect_argument_buffer_allocation);
+	indirect_argument_buffer->SetName(L"Indirect argument buffer");
+	uploader.UploadBuffer(indirect_argument_buffer.Get(), indirect_draw_builder.GetCommands().data(),
+		indirect_draw_builder.GetArgumentBufferSize());
 }
 
-void Renderer::WaitForPreviousFrame()
+void Renderer::BuildRenderGraph()
 {
-	// WAITING FOR THE FRAME TO COMPLETE BEFORE CONTINUING IS NOT BEST PRACTICE.
-	// Signal and increment the fence value.
-	const UINT64 prev_fence_value = fence_value;
-	ThrowIfFailed(command_queue->Signal(fence.Get(), prev_fence_value));
-	fence_value++;
+	// Depth only lives within the frame, so it is a transient of the graph
+	CD3DX12_RESOURCE_DESC depth_texture_descriptor(
+		D3D12_RESOURCE_DIMENSION_TEXTURE2D,
+		0,
+		this->width,
+		this->height,
+		1,
+		1,
+		DXGI_FORMAT_D32_FLOAT,
+		1,
+		0,
+		D3D12_TEXTURE_LAYOUT_UNKNOWN,
+		D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL | D3D12_RESOURCE_FLAG_DENY_SHADER_RESOURCE
+	);
+	const D3D12_RESOURCE_ALLOCATION_INFO depth_allocation_info = device->GetResourceAllocationInfo(0, 1, &depth_texture_descriptor);
+
+	frame_graph = BuildFrameGraph(render_graph, depth_allocation_info.SizeInBytes, depth_allocation_info.Alignment);
+
+	// One heap holds every transient at its planned offset
+	CD3DX12_HEAP_DESC transient_heap_descriptor(render_graph.GetTransientHeapSize(), D3D12_HEAP_TYPE_DEFAULT,
+		D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT, D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES);
+	ThrowIfFailed(device->CreateHeap(&transient_heap_descriptor, IID_PPV_ARGS(&transient_heap)));
+	transient_heap->SetName(L"Transient heap");
+
+	D3D12_CLEAR_VALUE clear_value;
+	clear_value.Format = DXGI_FORMAT_D32_FLOAT;
+	clear_value.DepthStencil.Depth = 1.f;
+	clear_value.DepthStencil.Stencil = 0;
 
-	if (fence->GetCompletedValue() < prev_fence_value)
+	ThrowIfFailed(device->CreatePlacedResource(
+		transient_heap.Get(),
+		render_graph.GetTransientOffset(frame_graph.depth_resource),
+		&depth_texture_descriptor,
+		static_cast<D3D12_RESOURCE_STATES>(render_graph.GetInitialState(frame_graph.depth_resource)),
+		&clear_value,
+		IID_PPV_ARGS(&depth_stencil)));
+	depth_stencil->SetName(L"Depth stencil");
+
+	device->CreateDepthStencilView(depth_stencil.Get(), nullptr, dsv_heap->GetCPUDescriptorHandleForHeapStart());
+
+	graph_resources.assign(render_graph.GetResourceNum(), nullptr);
+	graph_resources[frame_graph.depth_resource] = depth_stencil.Get();
+	graph_views.assign(render_graph.GetResourceNum(), D3D12_CPU_DESCRIPTOR_HANDLE{});
+	graph_views[frame_graph.depth_resource] = dsv_heap->GetCPUDescriptorHandleForHeapStart();
+
+	recording_context.resources = &graph_resources;
+	recording_context.views = &graph_views;
+	recording_context.descriptor_heap = &descriptor_heap;
+	recording_context.material_descriptors = &material_descriptors;
+	recording_context.pipeline_state = pipeline_state.Get();
+	recording_context.model_loader = &model_loader;
+
+	std::wstring transient_memory = L"Transient memory: " +
+		std::to_wstring(render_graph.GetTransientHeapSize() / 1024) + L" KB aliased, " +
+		std::to_wstring(render_graph.GetTransientUnaliasedSize() / 1024) + L" KB unaliased\n";
+	OutputDebugString(transient_memory.c_str());
+}
+
+void Renderer::InvalidateBundles()
+{
+	// Frames still in flight may reference the old bundles, keep them until this frame retires.
+	// Bundle memory belongs to the driver, so count the arguments of what it holds: a material
+	// constant and a draw per packet, the bytes of an IndirectDrawCommand.
+	for (DrawBundle& draw_bundle : draw_bundles)
 	{
-		ThrowIfFailed(fence->SetEventOnCompletion(prev_fence_value, fence_event));
-		WaitForSingleObject(fence_event, INFINITE);
+		if (draw_bundle.bundle)
+		{
+			const UINT64 command_size = static_cast<UINT64>(draw_bundle.last_draw - draw_bundle.first_draw) * sizeof(IndirectDrawCommand);
+			deferred_releases.ReleaseObject(draw_bundle, command_size);
+		}
 	}
+	draw_bundles.clear();
+	bundle_set.Clear();
+}
+
+DrawStageOptions Renderer::GetDrawStageOptions() const
+{
+	DrawStageOptions options;
+	options.frustum_culling = use_frustum_culling;
+	options.occlusion_culling = use_occlusion_culling;
+	options.sorted_draws = use_sorted_draws;
+	return options;
+}
+
+void Renderer::MoveToNextFrame()
+{
+	// Tag the frame just submitted with its own fence value
+	frames[frame_context_index].fence_value = fence_value;
+	descriptor_heap.FinishFrame(fence_value);
+	SignalFence();
 
 	frame_index = swap_chain->GetCurrentBackBufferIndex();
+	frame_context_index = (frame_context_index + 1) % frames_in_flight;
+
+	// Block only when the CPU got a full set of frames ahead of the GPU
+	{
+		PROFILE_SCOPE("Wait for GPU");
+		WaitForFence(frames[frame_context_index].fence_value);
+	}
+	const UINT64 completed_fence_value = fence->GetCompletedValue();
+	descriptor_heap.Retire(completed_fence_value);
+	deferred_releases.Retire(completed_fence_value);
+	gpu_profiler.Collect(completed_fence_value, frame_statistics);
+	frames[frame_context_index].constants.Reset();
+}
+
+void Renderer::WaitForFence(UINT64 value)
+{
+	if (fence->GetCompletedValue() < value)
+	{
+		ThrowIfFailed(fence->SetEventOnCompletion(value, fence_event));
+		WaitForSingleObject(fence_event, INFINITE);
+	}
+}
+
+void Renderer::WaitForGpu()
+{
+	const UINT64 flush_fence_value = fence_value;
+	SignalFence();
+	WaitForFence(flush_fence_value);
+	deferred_releases.Retire(flush_fence_value);
+	gpu_profiler.Collect(flush_fence_value, frame_statistics);
+}
+
+void Renderer::SignalFence()
+{
+	// Anything released from now on may still be used by the next submission
+	ThrowIfFailed(command_queue->Signal(fence.Get(), fence_value));
+	fence_value++;
+	deferred_releases.SetRecordingFenceValue(fence_value);
+}
+
+void Renderer::WriteProfileTrace() const
+{
+	// Open in chrome://tracing or ui.perfetto.dev
+	std::ofstream trace_file(GetBinPath(L"profile_trace.json"));
+	Profiler::Get().WriteChromeTrace(trace_file);
+	OutputDebugString(L"Profile trace written to profile_trace.json\n");
+}
+
+void Renderer::WriteFrameStatistics() const
+{
+	// Raw frames as CSV, their percentiles as JSON
+	const std::vector<FrameSample> samples = frame_statistics.GetSamples();
+	const FrameStatisticsSummary summary = FrameStatistics::Summarize(samples);
+	std::ofstream csv_file(GetBinPath(L"frame_statistics.csv"));
+	FrameStatistics::WriteCsv(csv_file, samples);
+	std::ofstream json_file(GetBinPath(L"frame_statistics.json"));
+	FrameStatistics::WriteJson(json_file, summary);
+	json_file << "\n";
+
+	std::wstring msg = L"Frame time p50 " + std::to_wstring(summary.frame_time.p50) +
+		L" ms, p99 " + std::to_wstring(summary.frame_time.p99) + L" ms over " + std::to_wstring(summary.frame_num) + L" frames, upload ring peak " +
+		std::to_wstring(uploader.GetRingHighWaterMark() / 1024) + L" KB\n";
+	OutputDebugString(msg.c_str());
+}
+
+void Renderer::SetBenchmarkOptions(const BenchmarkOptions& options)
+{
+	benchmark_options = options;
+	if (!options.model_file.empty())
+	{
+		model_file = std::wstring(options.model_file.begin(), options.model_file.end());
+	}
+}
+
+void Renderer::StartBenchmark()
+{
+	CameraPath path = CameraPath::MakeOrbit();
+	if (!benchmark_options.path_file.empty())
+	{
+		std::ifstream path_file(benchmark_options.path_file);
+		if (!path_file || !path.Load(path_file))
+		{
+			OutputDebugString(L"Invalid camera path file\n");
+			ThrowIfFailed(E_INVALIDARG);
+		}
+	}
+	if (path.GetDuration() / benchmark_options.time_step >= FrameStatistics::capacity)
+	{
+		OutputDebugString(L"Camera path is longer than the frame statistics keep, the report misses early frames\n");
+	}
+	benchmark = CameraBenchmark(path, benchmark_options.time_step);
+	benchmark_running = true;
+}
+
+void Renderer::FinishBenchmark()
+{
+	// Late GPU timestamps have to land before the report reads them
+	WaitForGpu();
+	benchmark_running = false;
+
+	const std::wstring report_path = benchmark_options.report_file.empty() ? GetBinPath(L"benchmark_report.json") :
+		std::wstring(benchmark_options.report_file.begin(), benchmark_options.report_file.end());
+	std::ofstream report_file(report_path);
+	BenchmarkMemory memory;
+	memory.upload_ring_size = uploader.GetRingSize();
+	memory.upload_ring_high_water_mark = uploader.GetRingHighWaterMark();
+	benchmark.WriteReport(report_file, frame_statistics, std::string(model_file.begin(), model_file.end()), memory);
+	OutputDebugString((L"Benchmark report written to " + report_path + L"\n").c_str());
+
+	// Posted, the window thread may be waiting for this thread's next frame
+	PostMessage(Win32Window::GetHwnd(), WM_CLOSE, 0, 0);
 }
 
 std::wstring Renderer::GetBinPath(std::wstring shader_file) const
@@ -4,11 +4,78 @@
 
 #include "win32_window.h"
 #include <model_loader.h>
+#include "copy_queue_uploader.h"
+#include "gpu_memory_allocator.h"
+#include "constant_buffer_allocator.h"
+#include "job_system.h"
+#include "asset_loader.h"
+#include "indirect_draw_builder.h"
+#include "bindless_texture_table.h"
+#include "descriptor_heap_manager.h"
+#include "deferred_release_queue.h"
+#include "draw_packet.h"
+#include "frame_stages.h"
+#include "camera_controller.h"
+#include "render_graph.h"
+#include "frame_graph.h"
+#include "d3d12_command_recorder.h"
+#include "gpu_profiler.h"
+#include "camera_benchmark.h"
+
+struct PassConstants
+{
+	XMMATRIX view_projection;
+};
+
+struct DrawConstants
+{
+	XMMATRIX world;
+};
+
+// Static draw sequence of one recording slot, replayed with ExecuteBundle
+struct DrawBundle
+{
+	ComPtr<ID3D12CommandAllocator> command_allocator;
+	ComPtr<ID3D12GraphicsCommandList> bundle;
+	UINT first_draw;
+	UINT last_draw;
+};
+
+// Command list slots of a frame: frame begin, one per recording task, frame end
+struct FrameContext
+{
+	std::vector<ComPtr<ID3D12CommandAllocator>> command_allocators;
+	std::vector<ComPtr<ID3D12GraphicsCommandList>> command_lists;
+	std::vector<ID3D12CommandList*> submitted_lists;
+	ConstantBufferAllocator constants;
+	D3D12_GPU_VIRTUAL_ADDRESS pass_constants;
+	// Bound by every list, what bundles and indirect draws use
+	D3D12_GPU_VIRTUAL_ADDRESS model_constants;
+	// One slice per recorded draw packet, indexed by draw id
+	std::vector<D3D12_GPU_VIRTUAL_ADDRESS> draw_constants;
+	D3D12_GPU_VIRTUAL_ADDRESS indirect_counts;
+	UINT64 fence_value;
+	// Timestamp query slot of the GPU profiler
+	UINT profile_slot;
+	// What the recorded lists submit, for frame statistics
+	UINT draw_num;
+	UINT64 triangle_num;
+	UINT state_change_num;
+};
+
+// Closed lists recorded for one back buffer, resubmitted while the scene is unchanged
+struct CachedFrame
+{
+	FrameContext frame;
+	UINT64 scene_version;
+};
 
 class Renderer
 {
 public:
-	Renderer(UINT width, UINT height) : width(width), height(height), title(L"DX12 renderer"), frame_index(0), rtv_descriptor_size(0),
+	Renderer(UINT width, UINT height, UINT frames_in_flight = 2) : width(width), height(height), title(L"DX12 renderer"), frame_index(0), rtv_descriptor_size(0),
+		frames_in_flight(frames_in_flight < 1 ? 1 : (frames_in_flight > frame_number ? frame_number : frames_in_flight)),
+		frame_context_index(0), asset_scheduler(job_system), asset_loader(job_system, asset_scheduler), recording_list_num(0),
 		//model_file(L"CornellBox-Original.obj")
 		//model_file(L"cube.obj")
 		model_file(L"12221_Cat_v1_l3.obj")
@@ -17,14 +84,21 @@ public:
 		scissor_rect = CD3DX12_RECT(0, 0, static_cast<LONG>(width), static_cast<LONG>(height));
 		vertex_buffer_view = {};
 		fence_value = 0;
+		assets_upload_fence_value = 0;
+		bound_descriptor_generation = 0;
+		texture_descriptor_first = 0;
+		texture_descriptor_num = 0;
+		frame_graph = {};
+		recording_context = {};
+		scene_version = 1;
+		rendered_scene_version = 0;
 		fence_event = nullptr;
 		aspect_ratio = static_cast<float>(width) / static_cast<float>(height);
 
-		world_view_projection = XMMatrixIdentity();
+		view_projection = XMMatrixIdentity();
 		world = XMMatrixTranslation(0, 0, 0) * XMMatrixScaling(1.0, 1.0, 1.0);
-		view = XMMatrixIdentity();
-		eye_position = XMVECTOR({ 0.0f, 1.0f, -5.0f });
-		projection = XMMatrixPerspectiveFovLH(60.f*XM_PI / 180.f, aspect_ratio, 0.001f, 100.f);
+		camera = CameraController().GetSnapshot();
+		frame_view = FrameView::FromCamera(camera, aspect_ratio);
 	};
 	virtual ~Renderer() {};
 
@@ -33,19 +107,39 @@ public:
 	virtual void OnRender();
 	virtual void OnDestroy();
 
+	// Renderer hotkeys, the camera keys are handled by CameraController
 	virtual void OnKeyDown(UINT8 key);
-	virtual void OnKeyUp(UINT8 key);
+	void SetCamera(const CameraSnapshot& camera);
+	// Set before OnInit, a benchmark replaces window input with a camera path and exits when done
+	void SetBenchmarkOptions(const BenchmarkOptions& options);
 
 	UINT GetWidth() const { return width; }
 	UINT GetHeight() const { return height; }
+	// CPU time in milliseconds each recording task spent on its command list last frame
+	const std::vector<float>& GetRecordingTimes() const { return recording_times; }
+	// State changes of last frame's draws in material order and in submitted order
+	const DrawStateChanges& GetUnsortedStateChanges() const { return draw_stages.GetUnsortedStateChanges(); }
+	const DrawStateChanges& GetSortedStateChanges() const { return draw_stages.GetSortedStateChanges(); }
+	UINT GetFrustumCulledNum() const { return draw_stages.GetFrustumCulledNum(); }
+	UINT GetOcclusionCulledNum() const { return draw_stages.GetOcclusionCulledNum(); }
+	const FrameStatistics& GetFrameStatistics() const { return frame_statistics; }
 	const WCHAR* GetTitle() const { return title.c_str(); }
+	// Frames are needed continuously while the camera moves or assets are still streaming in
+	bool IsAnimating() const { return benchmark_running || camera.moving || !uploader.IsUploadComplete(assets_upload_fence_value); }
+	// Benchmarks render uncapped, pacing would hide the frame cost
+	UINT GetTargetFps() const { return benchmark_running ? 0 : target_fps; }
 
 protected:
 	UINT width;
 	UINT height;
 	std::wstring title;
 
-	static const UINT frame_number = 2;
+	static const UINT frame_number = 3;
+	static const UINT64 upload_ring_size = 64 * 1024 * 1024;
+	static const UINT64 frame_constants_size = 1024 * 1024;
+	static const UINT max_recording_list_num = 8;
+	static const UINT persistent_descriptor_num = 1024;
+	static const UINT transient_descriptor_num = 4096;
 
 	// Pipeline objects.
 	ComPtr<ID3D12Device> device;
@@ -53,13 +147,12 @@ protected:
 	ComPtr<IDXGISwapChain3> swap_chain;
 	ComPtr<ID3D12DescriptorHeap> rtv_heap;
 	ComPtr<ID3D12DescriptorHeap> dsv_heap;
-	ComPtr<ID3D12DescriptorHeap> cbv_srv_heap;
+	DescriptorHeapManager descriptor_heap;
+	UINT bound_descriptor_generation;
 	UINT rtv_descriptor_size;
 	ComPtr<ID3D12Resource> depth_stencil;
 	ComPtr<ID3D12Resource> render_targets[frame_number];
-	ComPtr<ID3D12CommandAllocator> command_allocator;
 	ComPtr<ID3D12PipelineState> pipeline_state;
-	ComPtr<ID3D12GraphicsCommandList> command_list;
 
 
 	ComPtr<ID3D12RootSignature> root_signature;
@@ -70,47 +163,139 @@ protected:
 	std::wstring model_file;
 	ModelLoader model_loader;
 
-	ComPtr<ID3D12Resource> upload_vertex_buffer;
+	CopyQueueUploader uploader;
+	UINT64 assets_upload_fence_value;
+	GpuMemoryAllocator gpu_memory;
+
 	ComPtr<ID3D12Resource> vertex_buffer;
+	GpuAllocation vertex_buffer_allocation;
 	D3D12_VERTEX_BUFFER_VIEW vertex_buffer_view;
 
-	ComPtr<ID3D12Resource> upload_index_buffer;
 	ComPtr<ID3D12Resource> index_buffer;
+	GpuAllocation index_buffer_allocation;
 	D3D12_INDEX_BUFFER_VIEW index_buffer_view;
 
-	XMMATRIX world_view_projection;
-	ComPtr<ID3D12Resource> constant_buffer;
-	UINT8* constant_buffer_data_begin;
+	XMMATRIX view_projection;
 
-	std::vector<ComPtr<ID3D12Resource>> upload_textures;
 	std::vector<ComPtr<ID3D12Resource>> textures;
-	std::vector<UINT> per_mateial_srv_heap_offset;
+	std::vector<GpuAllocation> texture_allocations;
+	// Bindless: every texture sits in one SRV range, draws pick theirs by index
+	BindlessTextureTable texture_table;
+	UINT texture_descriptor_first;
+	UINT texture_descriptor_num;
+	std::vector<UINT> material_texture_index;
+	// Dense material id of every draw for the sort key, and the heap index of every id
+	std::vector<UINT> material_key_id;
+	std::vector<UINT> material_descriptors;
+
+	// Frames the CPU may record ahead of the GPU
+	UINT frames_in_flight;
+	UINT frame_context_index;
+	std::vector<FrameContext> frames;
+	// The frame's lists between the profiler's timestamp lists, rebuilt every submission
+	std::vector<ID3D12CommandList*> executed_lists;
+
+	// Worker threads shared by asset loading, culling and draw recording
+	JobSystem job_system;
+	AsyncScheduler asset_scheduler;
+	AssetLoader asset_loader;
+
+	// Draw recording split across worker threads
+	UINT recording_list_num;
+	std::vector<float> recording_times;
+
+	// Bundles are rebuilt only when the model or its drawn material set changes
+	bool use_bundles = true;
+	std::vector<DrawBundle> draw_bundles;
+	DrawBundleSet bundle_set;
+
+	// Culling, draw keys, sorting and the list split, the same stages headless runs use.
+	// Draws are submitted in draw key order: grouped by state, front to back inside a state.
+	DrawStages draw_stages;
+	bool use_sorted_draws = true;
+
+	// Bumped by camera motion and key presses, recording is skipped while it stays put
+	bool use_command_list_cache = true;
+	CachedFrame cached_frames[frame_number];
+	UINT64 scene_version;
+	UINT64 rendered_scene_version;
+
+	// Draws outside the view frustum are skipped. With either culling on, the
+	// visible set changes with the view, so bundles are not replayed meanwhile.
+	bool use_frustum_culling = true;
+	// Draws hidden behind occluder materials in a CPU depth buffer are skipped
+	bool use_occlusion_culling = true;
+
+	// GPU-driven mode: draw arguments live in a GPU buffer consumed by ExecuteIndirect
+	bool use_indirect = false;
+	IndirectDrawBuilder indirect_draw_builder;
+	ComPtr<ID3D12CommandSignature> command_signature;
+	ComPtr<ID3D12Resource> indirect_argument_buffer;
+	GpuAllocation indirect_argument_buffer_allocation;
+
+	// Frame passes and the barriers between them, the back buffer is rebound every frame.
+	// Transient attachments are placed in transient_heap at offsets planned by the graph.
+	RenderGraph render_graph;
+	ComPtr<ID3D12Heap> transient_heap;
+	std::vector<ID3D12Resource*> graph_resources;
+	std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> graph_views;
+	// Commands go through D3D12CommandRecorder, the same stream a null device validates headless
+	D3D12RecordingContext recording_context;
+	FrameGraph frame_graph;
+
+	// Frame GPU time, resolved a few frames late; pass timings only when the build enables the profiler
+	GpuProfiler gpu_profiler;
+	// Per-frame costs for percentile reports, GPU times arrive through gpu_profiler
+	FrameStatistics frame_statistics;
+	high_resolution_clock::time_point frame_start_time;
+
+	// Fixed-step camera path playback with a per-segment report
+	BenchmarkOptions benchmark_options;
+	CameraBenchmark benchmark;
+	bool benchmark_running = false;
 
 	// Synchronization objects.
 	UINT frame_index;
 	HANDLE fence_event;
 	ComPtr<ID3D12Fence> fence;
 	UINT64 fence_value;
+	// Objects replaced while the GPU may still use them, freed once their fence passes
+	DeferredReleaseQueue deferred_releases;
 
 	float aspect_ratio;
 
 	void LoadPipeline();
 	void LoadAssets();
-	void PopulateCommandList();
-	void WaitForPreviousFrame();
+	void CreateFrameContext(FrameContext& frame, UINT list_slot_num, UINT profile_slot);
+	void CreateFrameCommandLists(FrameContext& frame);
+	void PopulateCommandList(FrameContext& frame);
+	void SetDrawState(ID3D12GraphicsCommandList* list, const FrameContext& frame);
+	void RecordDraws(FrameContext& frame, UINT list_slot, UINT first_draw, UINT last_draw);
+	ID3D12GraphicsCommandList* ResetCommandList(FrameContext& frame, UINT list_slot);
+	void RecordBundle(DrawBundle& draw_bundle);
+	void CreateDrawStages();
+	DrawStageOptions GetDrawStageOptions() const;
+	bool IsReplayingBundles() const { return use_bundles && !use_indirect && DrawBundleSet::CanReplay(GetDrawStageOptions()); }
+	void RecordIndirectDraws(ID3D12GraphicsCommandList* command_list, const FrameContext& frame);
+	void CreateIndirectArguments();
+	void InvalidateBundles();
+	void BuildRenderGraph();
+	void MoveToNextFrame();
+	void WaitForFence(UINT64 value);
+	void WaitForGpu();
+	void WriteProfileTrace() const;
+	void WriteFrameStatistics() const;
+	void StartBenchmark();
+	void FinishBenchmark();
+	void SignalFence();
 	std::wstring GetBinPath(std::wstring shader_file) const;
 
+	// The model is drawn untransformed, so its bounds are already world space for the draw stages
 	XMMATRIX world;
-	XMMATRIX view;
-	XMMATRIX projection;
-
-	XMVECTOR eye_position;
-	float angle = 0.f;
-
-	float delta_forward = 0.f;
-	float delta_rotation = 0.f;
+	FrameView frame_view;
 
-	high_resolution_clock::time_point base_time;
+	CameraSnapshot camera;
 
 	UINT max_draw_call_num;
+	UINT target_fps = 60;
 };
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include "ring_allocator.h"
+
+#include <algorithm>
+
+RingAllocator::RingAllocator()
+{
+	Reset(0);
+}
+
+RingAllocator::RingAllocator(uint64_t size)
+{
+	Reset(size);
+}
+
+void RingAllocator::Reset(uint64_t size)
+{
+	max_size = size;
+	head = 0;
+	tail = 0;
+	used_size = 0;
+	open_region_size = 0;
+	high_water_mark = 0;
+	regions.clear();
+}
+
+uint64_t RingAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+	if (size == 0 || size > max_size || used_size == max_size)
+	{
+		return invalid_offset;
+	}
+
+	// Nothing is in flight, so the ring can restart from the beginning
+	if (used_size == 0)
+	{
+		head = 0;
+		tail = 0;
+	}
+
+	const uint64_t aligned_tail = (tail + alignment - 1) & ~(alignment - 1);
+	uint64_t offset = invalid_offset;
+	uint64_t consumed = 0;
+
+	if (tail >= head)
+	{
+		if (aligned_tail + size <= max_size)
+		{
+			offset = aligned_tail;
+			consumed = aligned_tail + size - tail;
+		}
+		else if (size <= head)
+		{
+			// Skip the end of the ring and wrap around to zero
+			offset = 0;
+			consumed = max_size - tail + size;
+		}
+	}
+	else if (aligned_tail + size <= head)
+	{
+		offset = aligned_tail;
+		consumed = aligned_tail + size - tail;
+	}
+
+	if (offset == invalid_offset)
+	{
+		return invalid_offset;
+	}
+
+	tail = offset + size;
+	if (tail == max_size)
+	{
+		tail = 0;
+	}
+	used_size += consumed;
+	open_region_size += consumed;
+	high_water_mark = std::max(high_water_mark, used_size);
+	return offset;
+}
+
+void RingAllocator::FinishRegion(uint64_t fence_value)
+{
+	if (open_region_size == 0)
+	{
+		return;
+	}
+
+	Region region = {};
+	region.fence_value = fence_value;
+	region.end = tail;
+	region.size = open_region_size;
+	regions.push_back(region);
+	open_region_size = 0;
+}
+
+void RingAllocator::Retire(uint64_t completed_fence_value)
+{
+	while (!regions.empty() && regions.front().fence_value <= completed_fence_value)
+	{
+		head = regions.front().end;
+		used_size -= regions.front().size;
+		regions.pop_front();
+	}
+}
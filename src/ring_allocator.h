@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+// Offset allocator for a fixed-size ring. Allocations made between two
+// FinishRegion calls form a region tagged with a fence value; the region
+// space comes back once Retire sees that fence value completed.
+class RingAllocator
+{
+public:
+	static const uint64_t invalid_offset = ~0ull;
+
+	RingAllocator();
+	explicit RingAllocator(uint64_t size);
+
+	void Reset(uint64_t size);
+
+	uint64_t Allocate(uint64_t size, uint64_t alignment = 1);
+	void FinishRegion(uint64_t fence_value);
+	void Retire(uint64_t completed_fence_value);
+
+	uint64_t GetSize() const { return max_size; }
+	uint64_t GetUsedSize() const { return used_size; }
+	// Bytes allocated since the last FinishRegion, including skipped ring ends
+	uint64_t GetOpenRegionSize() const { return open_region_size; }
+	uint64_t GetHighWaterMark() const { return high_water_mark; }
+	size_t GetPendingRegionNum() const { return regions.size(); }
+	bool IsEmpty() const { return used_size == 0; }
+	bool IsFull() const { return used_size == max_size; }
+
+protected:
+	struct Region
+	{
+		uint64_t fence_value;
+		uint64_t end;
+		uint64_t size;
+	};
+
+	uint64_t max_size;
+	uint64_t head;
+	uint64_t tail;
+	uint64_t used_size;
+	uint64_t open_region_size;
+	uint64_t high_water_mark;
+	std::deque<Region> regions;
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Bounded lock-free queue for exactly one producer and one consumer thread.
+// Capacity must be a power of two.
+template<typename T, size_t Capacity>
+class SpscQueue
+{
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+	SpscQueue() : head(0), tail(0) {}
+
+	// Producer side, fails when the queue is full
+	bool Push(const T& value)
+	{
+		const size_t current_head = head.load(std::memory_order_relaxed);
+		if (current_head - tail.load(std::memory_order_acquire) == Capacity)
+		{
+			return false;
+		}
+		items[current_head & (Capacity - 1)] = value;
+		head.store(current_head + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer side, fails when the queue is empty
+	bool Pop(T& value)
+	{
+		const size_t current_tail = tail.load(std::memory_order_relaxed);
+		if (current_tail == head.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+		value = items[current_tail & (Capacity - 1)];
+		tail.store(current_tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool IsEmpty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+
+protected:
+	T items[Capacity];
+	// Separate cache lines so producer and consumer do not false share
+	alignas(64) std::atomic<size_t> head;
+	alignas(64) std::atomic<size_t> tail;
+};
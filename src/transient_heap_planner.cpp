@@ -0,0 +1,71 @@
+#include "transient_heap_planner.h"
+
+#include <algorithm>
+#include <numeric>
+
+static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+	return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+}
+
+void TransientHeapPlanner::Plan(const std::vector<TransientRequest>& requests)
+{
+	this->requests = requests;
+	offsets.assign(requests.size(), 0);
+	heap_size = 0;
+	unaliased_size = 0;
+
+	std::vector<uint32_t> order(requests.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+	{
+		return requests[a].size > requests[b].size;
+	});
+
+	struct Range
+	{
+		uint64_t begin;
+		uint64_t end;
+	};
+	std::vector<uint32_t> placed;
+	std::vector<Range> busy;
+	for (uint32_t request : order)
+	{
+		const TransientRequest& current = requests[request];
+		unaliased_size = AlignUp(unaliased_size, current.alignment) + current.size;
+
+		// Bytes taken by placed resources alive at the same time
+		busy.clear();
+		for (uint32_t other : placed)
+		{
+			if (requests[other].first_pass <= current.last_pass && current.first_pass <= requests[other].last_pass)
+			{
+				Range range = { offsets[other], offsets[other] + requests[other].size };
+				busy.push_back(range);
+			}
+		}
+		std::sort(busy.begin(), busy.end(), [](const Range& a, const Range& b) { return a.begin < b.begin; });
+
+		// First gap that fits, past the last busy range otherwise
+		uint64_t offset = 0;
+		for (const Range& range : busy)
+		{
+			offset = AlignUp(offset, current.alignment);
+			if (offset + current.size <= range.begin)
+			{
+				break;
+			}
+			offset = std::max(offset, range.end);
+		}
+		offset = AlignUp(offset, current.alignment);
+
+		offsets[request] = offset;
+		heap_size = std::max(heap_size, offset + current.size);
+		placed.push_back(request);
+	}
+}
+
+bool TransientHeapPlanner::SharesMemory(uint32_t a, uint32_t b) const
+{
+	return offsets[a] < offsets[b] + requests[b].size && offsets[b] < offsets[a] + requests[a].size;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// A resource alive from first_pass to last_pass, both inclusive
+struct TransientRequest
+{
+	uint64_t size;
+	uint64_t alignment;
+	uint32_t first_pass;
+	uint32_t last_pass;
+};
+
+// Packs transient resources into one heap. Resources whose lifetimes overlap
+// never share bytes, the others may alias. Largest first with first-fit
+// offsets keeps the heap close to the peak of live bytes.
+class TransientHeapPlanner
+{
+public:
+	void Plan(const std::vector<TransientRequest>& requests);
+
+	uint64_t GetOffset(uint32_t request) const { return offsets[request]; }
+	// Peak transient memory, the heap size to create
+	uint64_t GetHeapSize() const { return heap_size; }
+	// What the same resources take without aliasing
+	uint64_t GetUnaliasedSize() const { return unaliased_size; }
+	// True when two planned requests share any bytes
+	bool SharesMemory(uint32_t a, uint32_t b) const;
+
+protected:
+	std::vector<TransientRequest> requests;
+	std::vector<uint64_t> offsets;
+	uint64_t heap_size = 0;
+	uint64_t unaliased_size = 0;
+};
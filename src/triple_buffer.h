@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Lock-free hand-off of the latest value from one writer thread to one
+// reader thread. The writer never waits and the reader always gets the most
+// recent complete value; intermediate ones are dropped.
+template<typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer() : back(0), front(1), middle(2) {}
+
+	void Write(const T& value)
+	{
+		values[back] = value;
+		back = middle.exchange(back | fresh_flag, std::memory_order_acq_rel) & index_mask;
+	}
+
+	// Returns false and leaves value untouched when nothing new was written
+	bool Read(T& value)
+	{
+		if ((middle.load(std::memory_order_acquire) & fresh_flag) == 0)
+		{
+			return false;
+		}
+		front = middle.exchange(front, std::memory_order_acq_rel) & index_mask;
+		value = values[front];
+		return true;
+	}
+
+protected:
+	static const uint32_t index_mask = 3;
+	static const uint32_t fresh_flag = 4;
+
+	T values[3];
+	// Owned by the writer
+	uint32_t back;
+	// Owned by the reader
+	uint32_t front;
+	// Index of the shared slot plus a flag telling whether it holds an unread value
+	std::atomic<uint32_t> middle;
+};
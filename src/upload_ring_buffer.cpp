@@ -0,0 +1,111 @@
+#include "upload_ring_buffer.h"
+
+UploadRingBuffer::UploadRingBuffer() : upload_buffer_data_begin(nullptr)
+{
+}
+
+UploadRingBuffer::~UploadRingBuffer()
+{
+	Destroy();
+}
+
+void UploadRingBuffer::Create(ID3D12Device* device, UINT64 size)
+{
+	this->device = device;
+
+	ThrowIfFailed(device->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(size),
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&upload_buffer)));
+	upload_buffer->SetName(L"Upload ring buffer");
+
+	// Upload heaps may stay mapped for the whole lifetime of the resource
+	CD3DX12_RANGE read_range(0, 0);
+	ThrowIfFailed(upload_buffer->Map(0, &read_range, reinterpret_cast<void**>(&upload_buffer_data_begin)));
+
+	allocator.Reset(size);
+}
+
+void UploadRingBuffer::Destroy()
+{
+	if (upload_buffer && upload_buffer_data_begin)
+	{
+		upload_buffer->Unmap(0, nullptr);
+	}
+	upload_buffer_data_begin = nullptr;
+	upload_buffer.Reset();
+	device.Reset();
+	allocator.Reset(0);
+}
+
+bool UploadRingBuffer::Allocate(UINT64 size, UINT64 alignment, UploadAllocation& allocation)
+{
+	const UINT64 offset = allocator.Allocate(size, alignment);
+	if (offset == RingAllocator::invalid_offset)
+	{
+		return false;
+	}
+
+	allocation.resource = upload_buffer.Get();
+	allocation.offset = offset;
+	allocation.cpu_address = upload_buffer_data_begin + offset;
+	allocation.gpu_address = upload_buffer->GetGPUVirtualAddress() + offset;
+	return true;
+}
+
+bool UploadRingBuffer::UploadBuffer(ID3D12GraphicsCommandList* command_list, ID3D12Resource* destination,
+	const void* data, UINT64 size)
+{
+	UploadAllocation allocation;
+	if (!Allocate(size, 4, allocation))
+	{
+		return false;
+	}
+
+	memcpy(allocation.cpu_address, data, static_cast<size_t>(size));
+	command_list->CopyBufferRegion(destination, 0, allocation.resource, allocation.offset, size);
+	return true;
+}
+
+bool UploadRingBuffer::UploadTexture(ID3D12GraphicsCommandList* command_list, ID3D12Resource* destination,
+	const D3D12_SUBRESOURCE_DATA& data)
+{
+	D3D12_RESOURCE_DESC descriptor = destination->GetDesc();
+	D3D12_PLACED_SUBRESOURCE_FOOTPRINT layout;
+	UINT row_num;
+	UINT64 row_size;
+	UINT64 required_size;
+	device->GetCopyableFootprints(&descriptor, 0, 1, 0, &layout, &row_num, &row_size, &required_size);
+
+	UploadAllocation allocation;
+	if (!Allocate(required_size, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, allocation))
+	{
+		return false;
+	}
+
+	layout.Offset = allocation.offset;
+	D3D12_MEMCPY_DEST destination_data = {
+		allocation.cpu_address,
+		layout.Footprint.RowPitch,
+		SIZE_T(layout.Footprint.RowPitch) * SIZE_T(row_num)
+	};
+	MemcpySubresource(&destination_data, &data, static_cast<SIZE_T>(row_size), row_num, layout.Footprint.Depth);
+
+	CD3DX12_TEXTURE_COPY_LOCATION destination_location(destination, 0);
+	CD3DX12_TEXTURE_COPY_LOCATION source_location(allocation.resource, layout);
+	command_list->CopyTextureRegion(&destination_location, 0, 0, 0, &source_location, nullptr);
+	return true;
+}
+
+void UploadRingBuffer::FinishRegion(UINT64 fence_value)
+{
+	allocator.FinishRegion(fence_value);
+}
+
+void UploadRingBuffer::Retire(UINT64 completed_fence_value)
+{
+	allocator.Retire(completed_fence_value);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "dx12_labs.h"
+#include "ring_allocator.h"
+
+struct UploadAllocation
+{
+	ID3D12Resource* resource;
+	UINT64 offset;
+	UINT8* cpu_address;
+	D3D12_GPU_VIRTUAL_ADDRESS gpu_address;
+};
+
+// Persistently mapped upload heap shared by every CPU -> GPU copy.
+class UploadRingBuffer
+{
+public:
+	UploadRingBuffer();
+	~UploadRingBuffer();
+
+	void Create(ID3D12Device* device, UINT64 size);
+	void Destroy();
+
+	bool Allocate(UINT64 size, UINT64 alignment, UploadAllocation& allocation);
+	bool UploadBuffer(ID3D12GraphicsCommandList* command_list, ID3D12Resource* destination,
+		const void* data, UINT64 size);
+	bool UploadTexture(ID3D12GraphicsCommandList* command_list, ID3D12Resource* destination,
+		const D3D12_SUBRESOURCE_DATA& data);
+
+	void FinishRegion(UINT64 fence_value);
+	void Retire(UINT64 completed_fence_value);
+
+	UINT64 GetSize() const { return allocator.GetSize(); }
+	UINT64 GetUsedSize() const { return allocator.GetUsedSize(); }
+	UINT64 GetOpenRegionSize() const { return allocator.GetOpenRegionSize(); }
+	UINT64 GetHighWaterMark() const { return allocator.GetHighWaterMark(); }
+
+protected:
+	ComPtr<ID3D12Device> device;
+	ComPtr<ID3D12Resource> upload_buffer;
+	UINT8* upload_buffer_data_begin;
+	RingAllocator allocator;
+};
@@ -0,0 +1,76 @@
+#include "upload_scheduler.h"
+
+UploadScheduler::UploadScheduler(QueueSync& queue_sync) :
+	queue_sync(queue_sync), next_fence_value(1), required_value(0), waited_value(0),
+	batch_open(false), current_allocator(0), allocator_num(0), wait_num(0)
+{
+}
+
+uint32_t UploadScheduler::BeginBatch()
+{
+	if (batch_open)
+	{
+		return current_allocator;
+	}
+
+	// Recycle every allocator whose batch has finished on the copy queue
+	const uint64_t completed_value = queue_sync.GetCompletedCopyValue();
+	while (!in_flight_allocators.empty() && in_flight_allocators.front().fence_value <= completed_value)
+	{
+		free_allocators.push_back(in_flight_allocators.front().allocator_index);
+		in_flight_allocators.pop_front();
+	}
+
+	if (free_allocators.empty())
+	{
+		current_allocator = allocator_num++;
+	}
+	else
+	{
+		current_allocator = free_allocators.back();
+		free_allocators.pop_back();
+	}
+	batch_open = true;
+	return current_allocator;
+}
+
+uint64_t UploadScheduler::SubmitBatch()
+{
+	const uint64_t fence_value = next_fence_value++;
+	queue_sync.SignalCopy(fence_value);
+
+	InFlightAllocator in_flight = {};
+	in_flight.allocator_index = current_allocator;
+	in_flight.fence_value = fence_value;
+	in_flight_allocators.push_back(in_flight);
+	batch_open = false;
+	return fence_value;
+}
+
+void UploadScheduler::RequireUpload(uint64_t fence_value)
+{
+	if (fence_value > required_value)
+	{
+		required_value = fence_value;
+	}
+}
+
+void UploadScheduler::InsertWaits()
+{
+	// Queue waits are monotonic, so one wait on the newest value covers all older ones
+	if (required_value <= waited_value)
+	{
+		return;
+	}
+	if (!IsComplete(required_value))
+	{
+		queue_sync.WaitForCopyOnDirect(required_value);
+		wait_num++;
+	}
+	waited_value = required_value;
+}
+
+bool UploadScheduler::IsComplete(uint64_t fence_value) const
+{
+	return queue_sync.GetCompletedCopyValue() >= fence_value;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+// Queue operations the scheduler needs. CopyQueueUploader forwards them
+// to D3D12; anything else (e.g. a recording mock) can stand in for it.
+class QueueSync
+{
+public:
+	virtual ~QueueSync() {};
+
+	virtual void SignalCopy(uint64_t fence_value) = 0;
+	virtual void WaitForCopyOnDirect(uint64_t fence_value) = 0;
+	virtual uint64_t GetCompletedCopyValue() const = 0;
+};
+
+// Decides which copy allocator a batch records into, which fence value it
+// signals, and the minimal set of GPU waits the direct queue has to insert.
+class UploadScheduler
+{
+public:
+	explicit UploadScheduler(QueueSync& queue_sync);
+
+	uint32_t BeginBatch();
+	uint64_t SubmitBatch();
+
+	// The next direct submission reads data uploaded by this batch
+	void RequireUpload(uint64_t fence_value);
+	// Called right before the direct queue executes its command lists
+	void InsertWaits();
+
+	bool IsBatchOpen() const { return batch_open; }
+	bool IsComplete(uint64_t fence_value) const;
+	uint64_t GetLastSubmittedValue() const { return next_fence_value - 1; }
+	uint32_t GetAllocatorNum() const { return allocator_num; }
+	uint32_t GetWaitNum() const { return wait_num; }
+
+protected:
+	struct InFlightAllocator
+	{
+		uint32_t allocator_index;
+		uint64_t fence_value;
+	};
+
+	QueueSync& queue_sync;
+	uint64_t next_fence_value;
+	uint64_t required_value;
+	uint64_t waited_value;
+	bool batch_open;
+	uint32_t current_allocator;
+	uint32_t allocator_num;
+	uint32_t wait_num;
+	std::vector<uint32_t> free_allocators;
+	std::deque<InFlightAllocator> in_flight_allocators;
+};
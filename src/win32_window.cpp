@@ -1,6 +1,14 @@
 #include "win32_window.h"
 
 HWND Win32Window::hwnd = nullptr;
+CameraController Win32Window::camera_controller;
+TripleBuffer<CameraSnapshot> Win32Window::camera_snapshots;
+SpscQueue<UINT8, 256> Win32Window::key_queue;
+std::atomic<bool> Win32Window::frame_requested(true);
+std::atomic<bool> Win32Window::render_thread_stopping(false);
+HANDLE Win32Window::render_wake_event = nullptr;
+std::thread Win32Window::render_thread;
+std::exception_ptr Win32Window::render_exception;
 
 int Win32Window::Run(Renderer* pRenderer, HINSTANCE hInstance, int nCmdShow)
 {
@@ -35,7 +43,18 @@ int Win32Window::Run(Renderer* pRenderer, HINSTANCE hInstance, int nCmdShow)
 	// Initialize the sample. OnInit is defined in each child-implementation of DXSample.
 	pRenderer->OnInit();
 	ShowWindow(hwnd, nCmdShow);
-	// Main sample loop.
+#ifdef ENABLE_PROFILER
+	SetTimer(hwnd, profile_title_timer, profile_title_interval, nullptr);
+#endif
+
+	render_wake_event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+	camera_snapshots.Write(camera_controller.GetSnapshot());
+	render_thread = std::thread(&Win32Window::RenderLoop, pRenderer);
+	RenderThreadJoiner render_thread_joiner;
+
+	// Main sample loop: drain messages, step the camera while it moves and
+	// block until the next message otherwise.
+	high_resolution_clock::time_point camera_time = high_resolution_clock::now();
 	MSG msg = {};
 	while (msg.message != WM_QUIT)
 	{
@@ -43,7 +62,29 @@ int Win32Window::Run(Renderer* pRenderer, HINSTANCE hInstance, int nCmdShow)
 		{
 			TranslateMessage(&msg);
 			DispatchMessage(&msg);
+			continue;
 		}
+
+		high_resolution_clock::time_point current_time = high_resolution_clock::now();
+		duration<float> time_passed = current_time - camera_time;
+		camera_time = current_time;
+		if (camera_controller.Update(time_passed.count()))
+		{
+			camera_snapshots.Write(camera_controller.GetSnapshot());
+			WakeRenderThread();
+		}
+		const DWORD timeout = camera_controller.IsMoving() ? 1000 / camera_update_rate : INFINITE;
+		MsgWaitForMultipleObjects(0, nullptr, FALSE, timeout, QS_ALLINPUT);
+	}
+
+	// WM_CLOSE already joined it unless the window went away some other way
+	StopRenderThread();
+	CloseHandle(render_wake_event);
+	render_wake_event = nullptr;
+	if (render_exception)
+	{
+		// The GPU state is unknown after a failed frame, the caller reports the error
+		std::rethrow_exception(render_exception);
 	}
 
 	pRenderer->OnDestroy();
@@ -51,10 +92,100 @@ int Win32Window::Run(Renderer* pRenderer, HINSTANCE hInstance, int nCmdShow)
 	return static_cast<int>(msg.wParam);
 }
 
-LRESULT Win32Window::WindowProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
+void Win32Window::RenderLoop(Renderer* pRenderer)
 {
-	Renderer* pRender = reinterpret_cast<Renderer*>(GetWindowLongPtr(hWnd, GWLP_USERDATA));
+	SteadyClock clock;
+	FrameScheduler frame_scheduler(clock, pRenderer->GetTargetFps());
+	HANDLE timer = CreateWaitableTimerEx(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+	if (timer == nullptr)
+	{
+		// High resolution timers need Windows 10 1803
+		timer = CreateWaitableTimer(nullptr, FALSE, nullptr);
+	}
+
+	try
+	{
+		while (!render_thread_stopping)
+		{
+			UINT8 key;
+			while (key_queue.Pop(key))
+			{
+				pRenderer->OnKeyDown(key);
+				frame_scheduler.RequestFrame();
+			}
+			CameraSnapshot camera;
+			if (camera_snapshots.Read(camera))
+			{
+				pRenderer->SetCamera(camera);
+				frame_scheduler.RequestFrame();
+			}
+			if (frame_requested.exchange(false))
+			{
+				frame_scheduler.RequestFrame();
+			}
+
+			frame_scheduler.SetAnimating(pRenderer->IsAnimating());
+			if (frame_scheduler.ShouldRender())
+			{
+				pRenderer->OnUpdate();
+				pRenderer->OnRender();
+				frame_scheduler.OnFrameRendered();
+				continue;
+			}
+			WaitForWake(timer, frame_scheduler.GetWaitTime());
+		}
+	}
+	catch (...)
+	{
+		// Exceptions must not leave the thread, the window thread rethrows it after joining
+		render_exception = std::current_exception();
+		PostMessage(hwnd, WM_CLOSE, 0, 0);
+	}
+
+	if (timer != nullptr)
+	{
+		CloseHandle(timer);
+	}
+}
+
+void Win32Window::WaitForWake(HANDLE timer, uint64_t wait_time)
+{
+	if (wait_time == FrameScheduler::infinite_wait || timer == nullptr)
+	{
+		const DWORD timeout = wait_time == FrameScheduler::infinite_wait ? INFINITE : static_cast<DWORD>((wait_time + 999) / 1000);
+		WaitForSingleObject(render_wake_event, timeout);
+		return;
+	}
 
+	// Relative due time in 100 ns units
+	LARGE_INTEGER due_time;
+	due_time.QuadPart = -static_cast<LONGLONG>(wait_time * 10);
+	SetWaitableTimer(timer, &due_time, 0, nullptr, nullptr, FALSE);
+	HANDLE handles[] = { render_wake_event, timer };
+	WaitForMultipleObjects(_countof(handles), handles, FALSE, INFINITE);
+	CancelWaitableTimer(timer);
+}
+
+void Win32Window::StopRenderThread()
+{
+	if (render_thread.joinable())
+	{
+		render_thread_stopping = true;
+		WakeRenderThread();
+		render_thread.join();
+	}
+}
+
+void Win32Window::WakeRenderThread()
+{
+	if (render_wake_event)
+	{
+		SetEvent(render_wake_event);
+	}
+}
+
+LRESULT Win32Window::WindowProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
+{
 	switch (message)
 	{
 	case WM_CREATE:
@@ -67,29 +198,47 @@ LRESULT Win32Window::WindowProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM l
 
 	case WM_PAINT:
 	{
-		if (pRender)
-		{
-			pRender->OnUpdate();
-			pRender->OnRender();
-		}
+		// The render thread draws, exposure only asks it for a frame
+		ValidateRect(hWnd, nullptr);
+		frame_requested = true;
+		WakeRenderThread();
 	}
 	return 0;
 
 	case WM_KEYDOWN:
 	{
-		if (pRender)
-		{
-			pRender->OnKeyDown(static_cast<UINT8>(wParam));
-		}
+		camera_controller.OnKeyDown(static_cast<UINT8>(wParam));
+		// A full queue drops the key rather than blocking the message pump
+		key_queue.Push(static_cast<UINT8>(wParam));
+		WakeRenderThread();
 	}
 	return 0;
 
 	case WM_KEYUP:
 	{
-		if (pRender)
+		camera_controller.OnKeyUp(static_cast<UINT8>(wParam));
+	}
+	return 0;
+
+	case WM_TIMER:
+	{
+		// Set from the window thread, the render thread never waits on the message pump
+		Renderer* pRenderer = reinterpret_cast<Renderer*>(GetWindowLongPtr(hWnd, GWLP_USERDATA));
+		const std::string summary = Profiler::Get().GetSummary();
+		std::wstring title = pRenderer->GetTitle();
+		if (!summary.empty())
 		{
-			pRender->OnKeyUp(static_cast<UINT8>(wParam));
+			title += L" | " + std::wstring(summary.begin(), summary.end());
 		}
+		SetWindowText(hWnd, title.c_str());
+	}
+	return 0;
+
+	case WM_CLOSE:
+	{
+		// The render thread draws into this window's swap chain, it has to finish before the window goes away
+		StopRenderThread();
+		DestroyWindow(hWnd);
 	}
 	return 0;
 
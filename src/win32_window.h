@@ -1,9 +1,20 @@
 #pragma once
 
 #include "renderer.h"
+#include "frame_scheduler.h"
+#include "camera_controller.h"
+#include "spsc_queue.h"
+#include "triple_buffer.h"
+
+#include <atomic>
+#include <exception>
+#include <thread>
 
 class Renderer;
 
+// The window thread pumps messages and moves the camera; a render thread
+// renders from the latest camera snapshot and consumes key presses through a
+// lock-free queue, so neither waits on the other.
 class Win32Window
 {
 public:
@@ -12,8 +23,34 @@ public:
 
 protected:
 	static LRESULT CALLBACK WindowProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
+	static void RenderLoop(Renderer* pRenderer);
+	static void WaitForWake(HANDLE timer, uint64_t wait_time);
+	static void WakeRenderThread();
+	static void StopRenderThread();
+
+	// Stops and joins the render thread when Run leaves, also during unwinding,
+	// so a joinable std::thread never reaches its destructor
+	struct RenderThreadJoiner
+	{
+		~RenderThreadJoiner() { StopRenderThread(); }
+	};
 
 private:
 	static HWND hwnd;
-};
 
+	// Camera integration steps per second while a camera key is held
+	static const DWORD camera_update_rate = 240;
+	// The profiler summary in the title is refreshed on a window timer
+	static const UINT_PTR profile_title_timer = 1;
+	static const UINT profile_title_interval = 500;
+
+	static CameraController camera_controller;
+	static TripleBuffer<CameraSnapshot> camera_snapshots;
+	static SpscQueue<UINT8, 256> key_queue;
+	static std::atomic<bool> frame_requested;
+	static std::atomic<bool> render_thread_stopping;
+	static HANDLE render_wake_event;
+	static std::thread render_thread;
+	// Set by the render thread before it exits on an error, rethrown by Run once it is joined
+	static std::exception_ptr render_exception;
+};
@@ -9,6 +9,18 @@ int WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, INT nC
 	{
 		OutputDebugString(L"Start the application\n");
 		Renderer render(1280, 720);
+
+		int argument_num = 0;
+		LPWSTR* wide_arguments = CommandLineToArgvW(GetCommandLineW(), &argument_num);
+		std::vector<std::string> arguments;
+		for (int i = 1; wide_arguments && i < argument_num; i++)
+		{
+			std::wstring argument = wide_arguments[i];
+			arguments.push_back(std::string(argument.begin(), argument.end()));
+		}
+		LocalFree(wide_arguments);
+		render.SetBenchmarkOptions(ParseBenchmarkOptions(arguments));
+
 		return Win32Window::Run(&render, hInstance, nCmdShow);
 	}
 	catch (com_exception e)
@@ -17,4 +29,10 @@ int WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, INT nC
 		OutputDebugString(e.get_wstring());
 		return 1;
 	}
+	catch (const std::exception& e)
+	{
+		OutputDebugString(L"Exception:\n");
+		OutputDebugStringA(e.what());
+		return 1;
+	}
 }
\ No newline at end of file
@@ -0,0 +1,170 @@
+#include "test.h"
+#include "async_scheduler.h"
+#include "async_task.h"
+
+#include <stdexcept>
+#include <string>
+
+static Task<int> MakeValue(int value)
+{
+	co_return value;
+}
+
+static Task<int> AddValues(int a, int b)
+{
+	const int first = co_await MakeValue(a);
+	const int second = co_await MakeValue(b);
+	co_return first + second;
+}
+
+static Task<int> Fail(std::string message)
+{
+	throw std::runtime_error(message);
+	co_return 0;
+}
+
+static Task<int> RunOnWorker(AsyncScheduler& scheduler, int value, LoadPriority priority = LoadPriority::Normal,
+	CancellationToken token = CancellationToken())
+{
+	co_await scheduler.Schedule(priority, token);
+	co_return value;
+}
+
+TEST(TaskIsLazyAndReturnsItsValue)
+{
+	Task<int> task = AddValues(2, 3);
+	CHECK(!task.IsReady());
+	task.Start();
+	// Nothing suspends on another thread, the whole chain ran inside Start
+	CHECK(task.IsReady());
+	CHECK_EQUAL(task.GetResult(), 5);
+}
+
+TEST(TaskRethrowsTheCoroutineException)
+{
+	JobSystem jobs(1);
+	bool thrown = false;
+	try
+	{
+		SyncWait(jobs, Fail("broken"));
+	}
+	catch (const std::runtime_error& error)
+	{
+		thrown = std::string(error.what()) == "broken";
+	}
+	CHECK(thrown);
+}
+
+TEST(TaskWhenAllKeepsTheInputOrder)
+{
+	JobSystem jobs(4);
+	AsyncScheduler scheduler(jobs, 2);
+	std::vector<Task<int>> tasks;
+	for (int value = 0; value < 32; value++)
+	{
+		tasks.push_back(RunOnWorker(scheduler, value));
+	}
+	const std::vector<int> results = SyncWait(jobs, WhenAll(std::move(tasks)));
+	CHECK_EQUAL(results.size(), size_t(32));
+	for (int value = 0; value < 32; value++)
+	{
+		CHECK_EQUAL(results[value], value);
+	}
+	CHECK_EQUAL(scheduler.GetQueuedNum(), 0u);
+}
+
+TEST(TaskWhenAllFinishesEveryTaskBeforeRethrowing)
+{
+	JobSystem jobs(2);
+	AsyncScheduler scheduler(jobs);
+	std::vector<Task<int>> tasks;
+	tasks.push_back(RunOnWorker(scheduler, 1));
+	tasks.push_back(Fail("first"));
+	tasks.push_back(Fail("second"));
+	tasks.push_back(RunOnWorker(scheduler, 4));
+	std::string message;
+	try
+	{
+		SyncWait(jobs, WhenAll(std::move(tasks)));
+	}
+	catch (const std::runtime_error& error)
+	{
+		message = error.what();
+	}
+	CHECK(message == "first");
+	CHECK_EQUAL(scheduler.GetQueuedNum(), 0u);
+}
+
+TEST(SchedulerStartsQueuedLoadsByPriority)
+{
+	// Without workers the queued loads only run inside SyncWait, one at a time
+	JobSystem jobs(1);
+	AsyncScheduler scheduler(jobs, 1);
+	std::vector<int> order;
+	auto load = [&](int id, LoadPriority priority) -> Task<int>
+	{
+		co_await scheduler.Schedule(priority);
+		order.push_back(id);
+		co_return id;
+	};
+	std::vector<Task<int>> tasks;
+	tasks.push_back(load(0, LoadPriority::Background));
+	tasks.push_back(load(1, LoadPriority::Normal));
+	tasks.push_back(load(2, LoadPriority::Background));
+	tasks.push_back(load(3, LoadPriority::Urgent));
+	tasks.push_back(load(4, LoadPriority::Normal));
+	for (Task<int>& task : tasks)
+	{
+		task.Start();
+	}
+	// The first load took the only slot, the rest wait in priority then submission order
+	CHECK_EQUAL(scheduler.GetQueuedNum(), 4u);
+	SyncWait(jobs, WhenAll(std::move(tasks)));
+	CHECK(order == std::vector<int>({ 0, 3, 1, 4, 2 }));
+}
+
+TEST(SchedulerCancelledLoadsThrowWithoutRunning)
+{
+	JobSystem jobs(1);
+	AsyncScheduler scheduler(jobs, 1);
+	CancellationSource early;
+	early.Cancel();
+	bool cancelled = false;
+	try
+	{
+		SyncWait(jobs, RunOnWorker(scheduler, 1, LoadPriority::Urgent, early.GetToken()));
+	}
+	catch (const LoadCancelled&)
+	{
+		cancelled = true;
+	}
+	CHECK(cancelled);
+
+	// Cancelled while queued behind a running load
+	CancellationSource late;
+	int body_num = 0;
+	auto load = [&](CancellationToken token) -> Task<int>
+	{
+		co_await scheduler.Schedule(LoadPriority::Normal, token);
+		body_num++;
+		co_return 0;
+	};
+	Task<int> running = load(CancellationToken());
+	Task<int> queued = load(late.GetToken());
+	running.Start();
+	queued.Start();
+	CHECK_EQUAL(scheduler.GetQueuedNum(), 1u);
+	late.Cancel();
+	SyncWait(jobs, running);
+	cancelled = false;
+	try
+	{
+		SyncWait(jobs, queued);
+	}
+	catch (const LoadCancelled&)
+	{
+		cancelled = true;
+	}
+	CHECK(cancelled);
+	CHECK_EQUAL(body_num, 1);
+}
@@ -0,0 +1,53 @@
+#include "test.h"
+#include "bindless_texture_table.h"
+
+TEST(BindlessTexturesGetConsecutiveIndices)
+{
+	BindlessTextureTable table(10, 11);
+	bool is_new = false;
+	CHECK_EQUAL(table.Assign("a.png", is_new), 11u);
+	CHECK(is_new);
+	CHECK_EQUAL(table.Assign("b.png", is_new), 12u);
+	CHECK(is_new);
+	// A shared file keeps its descriptor and needs no new view
+	CHECK_EQUAL(table.Assign("a.png", is_new), 11u);
+	CHECK(!is_new);
+	CHECK_EQUAL(table.GetTextureNum(), 2u);
+	CHECK(table.GetTexturePaths() == std::vector<std::string>({ "a.png", "b.png" }));
+}
+
+TEST(BindlessMaterialsWithoutTextureUseTheEmptyView)
+{
+	BindlessTextureTable table(10, 11);
+	bool is_new = true;
+	CHECK_EQUAL(table.Assign("", is_new), 10u);
+	CHECK(!is_new);
+	CHECK_EQUAL(table.GetTextureNum(), 0u);
+}
+
+TEST(BindlessResetMovesTheRange)
+{
+	BindlessTextureTable table;
+	bool is_new = false;
+	CHECK_EQUAL(table.Assign("a.png", is_new), 1u);
+	table.Reset(40, 41);
+	CHECK_EQUAL(table.GetEmptyIndex(), 40u);
+	CHECK_EQUAL(table.GetTextureNum(), 0u);
+	CHECK_EQUAL(table.Assign("b.png", is_new), 41u);
+	CHECK_EQUAL(table.Assign("a.png", is_new), 42u);
+	CHECK(is_new);
+}
+
+TEST(BindlessMaterialIdsAreDenseAndMapBackToDescriptors)
+{
+	// Heap indices far past what a 16-bit draw key field can hold
+	BindlessTextureTable table(100000, 100001);
+	bool is_new = false;
+	const uint32_t a = table.Assign("a.png", is_new);
+	const uint32_t b = table.Assign("b.png", is_new);
+	CHECK_EQUAL(table.GetMaterialId(table.GetEmptyIndex()), 0u);
+	CHECK_EQUAL(table.GetMaterialId(a), 1u);
+	CHECK_EQUAL(table.GetMaterialId(b), 2u);
+	const std::vector<uint32_t> descriptors = table.GetMaterialDescriptors();
+	CHECK(descriptors == std::vector<uint32_t>({ 100000, 100001, 100002 }));
+}
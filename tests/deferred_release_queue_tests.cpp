@@ -0,0 +1,133 @@
+#include "test.h"
+#include "deferred_release_queue.h"
+#include "heap_allocator.h"
+#include "ring_allocator.h"
+
+#include <memory>
+#include <string>
+
+TEST(DeferredReleasesWaitForTheirFence)
+{
+	DeferredReleaseQueue queue;
+	std::vector<std::string> released;
+	queue.Release(2, [&]() { released.push_back("a"); }, 100);
+	queue.Release(3, [&]() { released.push_back("b"); }, 50);
+	CHECK_EQUAL(queue.GetPendingSize(), 150ull);
+	CHECK_EQUAL(queue.Retire(1), 0ull);
+	CHECK(released.empty());
+	CHECK_EQUAL(queue.Retire(2), 100ull);
+	CHECK(released == std::vector<std::string>({ "a" }));
+	CHECK_EQUAL(queue.GetPendingNum(), size_t(1));
+	CHECK_EQUAL(queue.Retire(5), 50ull);
+	CHECK(released == std::vector<std::string>({ "a", "b" }));
+	CHECK_EQUAL(queue.GetPendingSize(), 0ull);
+	// Nothing runs twice
+	CHECK_EQUAL(queue.Retire(5), 0ull);
+	CHECK_EQUAL(released.size(), size_t(2));
+}
+
+TEST(DeferredReleasesDoNotRelyOnSubmissionOrder)
+{
+	DeferredReleaseQueue queue;
+	std::vector<uint64_t> released;
+	for (uint64_t fence_value : { 4, 2, 6, 3 })
+	{
+		queue.Release(fence_value, [&released, fence_value]() { released.push_back(fence_value); });
+	}
+	queue.Retire(3);
+	// Completed entries run in the order they were queued
+	CHECK(released == std::vector<uint64_t>({ 2, 3 }));
+	queue.Retire(4);
+	CHECK(released == std::vector<uint64_t>({ 2, 3, 4 }));
+	CHECK_EQUAL(queue.GetPendingNum(), size_t(1));
+}
+
+TEST(DeferredUntaggedReleasesUseTheRecordingFence)
+{
+	DeferredReleaseQueue queue;
+	queue.SetRecordingFenceValue(7);
+	std::weak_ptr<int> watched;
+	{
+		std::shared_ptr<int> object = std::make_shared<int>(1);
+		watched = object;
+		queue.ReleaseObject(object, 64);
+	}
+	// The queue holds the last reference until fence 7
+	CHECK(!watched.expired());
+	queue.Retire(6);
+	CHECK(!watched.expired());
+	CHECK_EQUAL(queue.Retire(7), 64ull);
+	CHECK(watched.expired());
+}
+
+TEST(DeferredReleasesQueuedDuringRetireWaitForTheNextOne)
+{
+	DeferredReleaseQueue queue;
+	uint32_t inner_num = 0;
+	queue.Release(1, [&]()
+	{
+		// Already complete, but it only runs on the next Retire
+		queue.Release(1, [&]() { inner_num++; });
+	});
+	queue.Retire(1);
+	CHECK_EQUAL(inner_num, 0u);
+	CHECK_EQUAL(queue.GetPendingNum(), size_t(1));
+	queue.Retire(1);
+	CHECK_EQUAL(inner_num, 1u);
+}
+
+TEST(DeferredFlushRunsEverything)
+{
+	DeferredReleaseQueue queue;
+	uint32_t released_num = 0;
+	queue.Release(~0ull - 1, [&]() { released_num++; }, 8);
+	queue.Release(10, [&]() { released_num++; }, 8);
+	CHECK_EQUAL(queue.Flush(), 16ull);
+	CHECK_EQUAL(released_num, 2u);
+	CHECK_EQUAL(queue.GetPendingNum(), size_t(0));
+}
+
+TEST(DeferredHeapBlocksComeBackWithTheirSize)
+{
+	// How GpuMemoryAllocator::Release frees a placed resource's block
+	DeferredReleaseQueue queue;
+	HeapAllocatorList allocators(1024, 64);
+	allocators.AddHeap(1024);
+	HeapAllocatorList::Block block = {};
+	CHECK(allocators.Allocate(1000, 1, block));
+	queue.Release(4, [&allocators, block]() { allocators.Free(block); }, 1000);
+	CHECK_EQUAL(queue.GetPendingSize(), 1000ull);
+
+	// The GPU may still read the block, so it stays taken until the fence passes
+	HeapAllocatorList::Block reused = {};
+	CHECK_EQUAL(queue.Retire(3), 0ull);
+	CHECK(!allocators.Allocate(512, 1, reused));
+	CHECK_EQUAL(queue.Retire(4), 1000ull);
+	CHECK(allocators.Allocate(1024, 1, reused));
+	CHECK_EQUAL(reused.offset, 0ull);
+}
+
+TEST(DeferredUploadRegionsRetireTheRing)
+{
+	// How CopyQueueUploader returns ring regions, tagged with the copy fence value of their batch
+	DeferredReleaseQueue queue;
+	RingAllocator ring(256);
+	uint64_t fence_value = 0;
+	for (uint64_t size : { 100, 60 })
+	{
+		ring.Allocate(size);
+		fence_value++;
+		CHECK_EQUAL(ring.GetOpenRegionSize(), size);
+		queue.Release(fence_value, [&ring, fence_value]() { ring.Retire(fence_value); }, ring.GetOpenRegionSize());
+		ring.FinishRegion(fence_value);
+		CHECK_EQUAL(ring.GetOpenRegionSize(), 0ull);
+	}
+	CHECK_EQUAL(queue.GetPendingSize(), 160ull);
+	CHECK_EQUAL(ring.Allocate(100), RingAllocator::invalid_offset);
+
+	CHECK_EQUAL(queue.Retire(1), 100ull);
+	CHECK_EQUAL(ring.GetUsedSize(), 60ull);
+	CHECK_EQUAL(ring.Allocate(100), 0ull);
+	CHECK_EQUAL(queue.Retire(2), 60ull);
+	CHECK_EQUAL(queue.GetPendingSize(), 0ull);
+}
@@ -0,0 +1,79 @@
+#include "test.h"
+#include "descriptor_allocator.h"
+
+TEST(DescriptorFreeListIsFirstFit)
+{
+	DescriptorFreeList free_list(16);
+	CHECK_EQUAL(free_list.Allocate(4), 0u);
+	CHECK_EQUAL(free_list.Allocate(4), 4u);
+	CHECK_EQUAL(free_list.Allocate(4), 8u);
+	free_list.Free(0, 4);
+	free_list.Free(8, 2);
+	// The first range large enough wins, not the best fitting one
+	CHECK_EQUAL(free_list.Allocate(2), 0u);
+	CHECK_EQUAL(free_list.Allocate(3), 12u);
+	CHECK_EQUAL(free_list.Allocate(2), 2u);
+	CHECK_EQUAL(free_list.Allocate(2), 8u);
+	CHECK_EQUAL(free_list.Allocate(2), DescriptorFreeList::invalid_index);
+	CHECK_EQUAL(free_list.Allocate(0), DescriptorFreeList::invalid_index);
+	CHECK_EQUAL(free_list.GetAllocatedNum(), 15u);
+}
+
+TEST(DescriptorFreeListMergesNeighbours)
+{
+	DescriptorFreeList free_list(12);
+	const uint32_t a = free_list.Allocate(4);
+	const uint32_t b = free_list.Allocate(4);
+	const uint32_t c = free_list.Allocate(4);
+	free_list.Free(a, 4);
+	free_list.Free(c, 4);
+	CHECK_EQUAL(free_list.GetFreeRangeNum(), 2u);
+	CHECK_EQUAL(free_list.GetLargestFreeRange(), 4u);
+	// Freeing the middle joins both sides into one range
+	free_list.Free(b, 4);
+	CHECK_EQUAL(free_list.GetFreeRangeNum(), 1u);
+	CHECK_EQUAL(free_list.GetLargestFreeRange(), 12u);
+	CHECK_EQUAL(free_list.GetAllocatedNum(), 0u);
+	CHECK_EQUAL(free_list.Allocate(12), 0u);
+}
+
+TEST(DescriptorFreeListGrowAppendsAndMerges)
+{
+	DescriptorFreeList free_list(8);
+	CHECK_EQUAL(free_list.Allocate(6), 0u);
+	CHECK_EQUAL(free_list.Allocate(4), DescriptorFreeList::invalid_index);
+	free_list.Grow(16);
+	CHECK_EQUAL(free_list.GetSize(), 16u);
+	// The two free descriptors at the old end join the new space
+	CHECK_EQUAL(free_list.GetFreeRangeNum(), 1u);
+	CHECK_EQUAL(free_list.Allocate(4), 6u);
+	// Shrinking is ignored
+	free_list.Grow(4);
+	CHECK_EQUAL(free_list.GetSize(), 16u);
+	CHECK_EQUAL(free_list.GetAllocatedNum(), 10u);
+}
+
+TEST(DescriptorFreeListResetForgetsAllocations)
+{
+	DescriptorFreeList free_list(8);
+	free_list.Allocate(3);
+	free_list.Reset(4);
+	CHECK_EQUAL(free_list.GetAllocatedNum(), 0u);
+	CHECK_EQUAL(free_list.GetLargestFreeRange(), 4u);
+	free_list.Reset(0);
+	CHECK_EQUAL(free_list.Allocate(1), DescriptorFreeList::invalid_index);
+}
+
+TEST(DescriptorRangesCoalesceSortedUniqueIndices)
+{
+	std::vector<uint32_t> indices = { 7, 3, 4, 4, 5, 10, 8, 0 };
+	std::vector<DescriptorRange> ranges;
+	CoalesceDescriptorRanges(indices, ranges);
+	CHECK(indices == std::vector<uint32_t>({ 0, 3, 4, 5, 7, 8, 10 }));
+	CHECK_EQUAL(ranges.size(), size_t(4));
+	CHECK_EQUAL(ranges[1].first, 3u);
+	CHECK_EQUAL(ranges[1].count, 3u);
+	CHECK_EQUAL(ranges[2].first, 7u);
+	CHECK_EQUAL(ranges[2].count, 2u);
+	CHECK_EQUAL(ranges[3].count, 1u);
+}
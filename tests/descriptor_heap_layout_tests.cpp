@@ -0,0 +1,86 @@
+#include "test.h"
+#include "descriptor_heap_layout.h"
+
+TEST(DescriptorLayoutCommitCopiesStagedRanges)
+{
+	DescriptorHeapLayout layout;
+	layout.Reset(16, 8);
+	CHECK_EQUAL(layout.GetHeapSize(), 24u);
+	CHECK(layout.TakeStagedRanges().empty());
+
+	// Views staged out of order and twice still make one copy range per run
+	for (uint32_t index : { 5u, 3u, 4u, 9u, 3u, 10u })
+	{
+		layout.Stage(index);
+	}
+	const std::vector<DescriptorRange> ranges = layout.TakeStagedRanges();
+	CHECK_EQUAL(ranges.size(), size_t(2));
+	CHECK_EQUAL(ranges[0].first, 3u);
+	CHECK_EQUAL(ranges[0].count, 3u);
+	CHECK_EQUAL(ranges[1].first, 9u);
+	CHECK_EQUAL(ranges[1].count, 2u);
+	// The next Commit copies nothing again
+	CHECK(layout.TakeStagedRanges().empty());
+}
+
+TEST(DescriptorLayoutGrowCopiesThePersistentRange)
+{
+	DescriptorHeapLayout layout;
+	layout.Reset(4, 8);
+	const uint32_t generation = layout.GetGeneration();
+	CHECK_EQUAL(layout.AllocatePersistent(3), 0u);
+	CHECK_EQUAL(layout.AllocatePersistent(2), DescriptorHeapLayout::invalid_index);
+
+	// Doubles, or more until the request fits
+	CHECK_EQUAL(layout.GetGrownPersistentNum(2), 8u);
+	CHECK_EQUAL(layout.GetGrownPersistentNum(20), 32u);
+
+	// A view staged before the heaps grow is carried over by the copy, not lost
+	layout.Stage(2);
+	const DescriptorRange copied = layout.Grow(layout.GetGrownPersistentNum(2));
+	CHECK_EQUAL(copied.first, 0u);
+	CHECK_EQUAL(copied.count, 4u);
+	CHECK_EQUAL(layout.GetGeneration(), generation + 1);
+	CHECK_EQUAL(layout.GetPersistentCapacity(), 8u);
+	CHECK_EQUAL(layout.GetHeapSize(), 16u);
+	CHECK_EQUAL(layout.AllocatePersistent(2), 3u);
+	CHECK_EQUAL(layout.GetPersistentNum(), 5u);
+	const std::vector<DescriptorRange> ranges = layout.TakeStagedRanges();
+	CHECK_EQUAL(ranges.size(), size_t(1));
+	CHECK_EQUAL(ranges[0].first, 2u);
+
+	// Reset means new heaps as well
+	layout.Reset(4, 8);
+	CHECK_EQUAL(layout.GetGeneration(), generation + 2);
+	CHECK_EQUAL(layout.GetPersistentNum(), 0u);
+}
+
+TEST(DescriptorLayoutTransientRingResetsOnTheFence)
+{
+	DescriptorHeapLayout layout;
+	layout.Reset(16, 8);
+
+	// Transient tables sit behind the persistent range
+	CHECK_EQUAL(layout.AllocateTransient(3), 16u);
+	CHECK_EQUAL(layout.AllocateTransient(2), 19u);
+	layout.FinishFrame(1);
+	CHECK_EQUAL(layout.AllocateTransient(3), 21u);
+	layout.FinishFrame(2);
+	CHECK_EQUAL(layout.GetTransientNum(), 8u);
+	CHECK_EQUAL(layout.AllocateTransient(1), DescriptorHeapLayout::invalid_index);
+
+	// Nothing comes back before the frame's fence completes
+	layout.Retire(0);
+	CHECK_EQUAL(layout.AllocateTransient(1), DescriptorHeapLayout::invalid_index);
+	layout.Retire(1);
+	CHECK_EQUAL(layout.GetTransientNum(), 3u);
+	CHECK_EQUAL(layout.AllocateTransient(4), 16u);
+	layout.FinishFrame(3);
+	layout.Retire(3);
+	CHECK_EQUAL(layout.GetTransientNum(), 0u);
+
+	// A grown heap moves the ring behind the larger persistent range
+	layout.Grow(32);
+	CHECK_EQUAL(layout.AllocateTransient(2), 32u);
+	CHECK_EQUAL(layout.GetHeapSize(), 40u);
+}
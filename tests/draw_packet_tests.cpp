@@ -0,0 +1,74 @@
+#include "test.h"
+#include "draw_packet.h"
+
+#include <algorithm>
+#include <random>
+
+// Counts what the recorder would see
+class CountingSink : public DrawCommandSink
+{
+public:
+	void SetPass(uint32_t pass) override { calls.push_back(0x10000000 | pass); }
+	void SetPipeline(uint32_t pipeline) override { calls.push_back(0x20000000 | pipeline); }
+	void SetMaterial(uint32_t material) override { calls.push_back(0x30000000 | material); }
+	void Draw(uint32_t draw_id) override { calls.push_back(draw_id); }
+
+	std::vector<uint32_t> calls;
+};
+
+TEST(DrawKeyPacksFieldsMostSignificantFirst)
+{
+	const uint64_t key = DrawKey::Make(3, 0x123, 0xBEEF, 2.f);
+	CHECK_EQUAL(DrawKey::GetPass(key), 3u);
+	CHECK_EQUAL(DrawKey::GetPipeline(key), 0x123u);
+	CHECK_EQUAL(DrawKey::GetMaterial(key), 0xBEEFu);
+	// Nearer draws sort first inside a state bucket, depth behind the eye clamps to zero
+	CHECK(DrawKey::Make(0, 0, 1, 1.f) < DrawKey::Make(0, 0, 1, 2.f));
+	CHECK(DrawKey::Make(0, 0, 1, 100.f) < DrawKey::Make(0, 0, 2, 0.5f));
+	CHECK_EQUAL(DrawKey::Make(0, 0, 1, -5.f), DrawKey::Make(0, 0, 1, 0.f));
+}
+
+TEST(RadixSortMatchesStableSort)
+{
+	std::mt19937 random(3);
+	for (uint32_t packet_num : { 0u, 1u, 2u, 100u, 5000u })
+	{
+		std::vector<DrawPacket> packets(packet_num);
+		for (uint32_t packet = 0; packet < packet_num; packet++)
+		{
+			// Few distinct materials and depths, so equal keys test stability
+			packets[packet].key = DrawKey::Make(random() % 2, 0, random() % 8, static_cast<float>(random() % 16));
+			packets[packet].draw_id = packet;
+		}
+		std::vector<DrawPacket> expected = packets;
+		std::stable_sort(expected.begin(), expected.end(), [](const DrawPacket& a, const DrawPacket& b) { return a.key < b.key; });
+		std::vector<DrawPacket> scratch;
+		RadixSortDrawPackets(packets, scratch);
+		bool same = packets.size() == expected.size();
+		for (size_t packet = 0; same && packet < packets.size(); packet++)
+		{
+			same = packets[packet].key == expected[packet].key && packets[packet].draw_id == expected[packet].draw_id;
+		}
+		CHECK(same);
+	}
+}
+
+TEST(SubmitEmitsOnlyChangedState)
+{
+	std::vector<DrawPacket> packets = {
+		{ DrawKey::Make(0, 0, 1, 1.f), 10 },
+		{ DrawKey::Make(0, 0, 1, 2.f), 11 },
+		{ DrawKey::Make(0, 0, 2, 1.f), 12 },
+		{ DrawKey::Make(0, 1, 2, 1.f), 13 },
+	};
+	CountingSink sink;
+	const DrawStateChanges changes = SubmitDrawPackets(packets.data(), packets.data() + packets.size(), &sink);
+	CHECK_EQUAL(changes.pass_changes, 1u);
+	CHECK_EQUAL(changes.pipeline_changes, 2u);
+	CHECK_EQUAL(changes.material_changes, 2u);
+	CHECK_EQUAL(changes.draw_num, 4u);
+	CHECK_EQUAL(changes.GetTotal(), 5u);
+	CHECK(sink.calls == std::vector<uint32_t>({ 0x10000000, 0x20000000, 0x30000001, 10, 11, 0x30000002, 12, 0x20000001, 13 }));
+	// Counting without a sink gives the same numbers
+	CHECK_EQUAL(SubmitDrawPackets(packets.data(), packets.data() + packets.size(), nullptr).GetTotal(), 5u);
+}
@@ -0,0 +1,77 @@
+#include "test.h"
+#include "frame_scheduler.h"
+
+TEST(SchedulerRendersTheFirstFrameImmediately)
+{
+	ManualClock clock(5000);
+	FrameScheduler scheduler(clock);
+	CHECK(scheduler.ShouldRender());
+	CHECK_EQUAL(scheduler.GetWaitTime(), 0ull);
+	scheduler.OnFrameRendered();
+	CHECK_EQUAL(scheduler.GetFrameNum(), 1ull);
+	// Nothing requested and nothing animating, the loop may block until woken
+	CHECK(scheduler.IsIdle());
+	CHECK_EQUAL(scheduler.GetWaitTime(), FrameScheduler::infinite_wait);
+	clock.Advance(1000000);
+	CHECK(!scheduler.ShouldRender());
+}
+
+TEST(SchedulerCapsRequestsAtTheTargetRate)
+{
+	ManualClock clock;
+	FrameScheduler scheduler(clock, 50);
+	CHECK_EQUAL(scheduler.GetFrameInterval(), 20000ull);
+	scheduler.OnFrameRendered();
+	clock.Advance(5000);
+	scheduler.RequestFrame();
+	CHECK(!scheduler.ShouldRender());
+	CHECK_EQUAL(scheduler.GetWaitTime(), 15000ull);
+	clock.Advance(15000);
+	CHECK(scheduler.ShouldRender());
+	scheduler.OnFrameRendered();
+	// Several requests inside one interval render once
+	scheduler.RequestFrame();
+	scheduler.RequestFrame();
+	clock.Advance(25000);
+	CHECK_EQUAL(scheduler.GetWaitTime(), 0ull);
+	scheduler.OnFrameRendered();
+	CHECK(scheduler.IsIdle());
+	CHECK_EQUAL(scheduler.GetFrameNum(), 3ull);
+}
+
+TEST(SchedulerAnimatesEveryInterval)
+{
+	ManualClock clock;
+	FrameScheduler scheduler(clock, 100);
+	scheduler.SetAnimating(true);
+	uint32_t rendered_num = 0;
+	// One simulated second in 1 ms steps renders at the target rate
+	for (uint32_t step = 0; step < 1000; step++)
+	{
+		if (scheduler.ShouldRender())
+		{
+			scheduler.OnFrameRendered();
+			rendered_num++;
+		}
+		clock.Advance(1000);
+	}
+	CHECK_EQUAL(rendered_num, 100u);
+	scheduler.SetAnimating(false);
+	CHECK_EQUAL(scheduler.GetWaitTime(), FrameScheduler::infinite_wait);
+}
+
+TEST(SchedulerWithoutTargetRendersEveryRequest)
+{
+	ManualClock clock;
+	FrameScheduler scheduler(clock, 0);
+	CHECK_EQUAL(scheduler.GetFrameInterval(), 0ull);
+	scheduler.OnFrameRendered();
+	scheduler.RequestFrame();
+	CHECK(scheduler.ShouldRender());
+	scheduler.OnFrameRendered();
+	CHECK(!scheduler.ShouldRender());
+	// Changing the rate applies to the frame already waiting
+	scheduler.SetTargetFps(10);
+	scheduler.RequestFrame();
+	CHECK_EQUAL(scheduler.GetWaitTime(), 100000ull);
+}
@@ -0,0 +1,261 @@
+#include "test.h"
+#include "test_camera.h"
+#include "test_scene.h"
+#include "frame_graph.h"
+#include "frame_stages.h"
+#include "job_system.h"
+#include "null_device.h"
+
+#include <algorithm>
+#include <cmath>
+
+static CameraSnapshot MakeCamera(float x, float y, float z, float angle)
+{
+	CameraSnapshot camera = {};
+	camera.eye_position[0] = x;
+	camera.eye_position[1] = y;
+	camera.eye_position[2] = z;
+	camera.angle = angle;
+	return camera;
+}
+
+static std::vector<uint32_t> GetDrawIds(const DrawStages& stages)
+{
+	std::vector<uint32_t> draw_ids;
+	for (const DrawPacket& packet : stages.GetDrawPackets())
+	{
+		draw_ids.push_back(packet.draw_id);
+	}
+	return draw_ids;
+}
+
+TEST(FrameViewAtTheOriginIsThePerspective)
+{
+	const FrameView view = FrameView::FromCamera(MakeCamera(0.f, 0.f, 0.f, 0.f), 16.f / 9.f);
+	float expected[16];
+	MakePerspective(expected, FrameView::fov, 16.f / 9.f, FrameView::near_plane, FrameView::far_plane);
+	for (uint32_t i = 0; i < 16; i++)
+	{
+		CHECK(std::fabs(view.view_projection[i] - expected[i]) < 1e-5f);
+	}
+}
+
+TEST(FrameViewCentersWhatTheCameraFaces)
+{
+	// Turned to +X, a point ahead lands in the middle of the screen
+	const FrameView view = FrameView::FromCamera(MakeCamera(1.f, 2.f, 3.f, 1.5707963f), 1.f);
+	const float point[4] = { 11.f, 2.f, 3.f, 1.f };
+	float clip[4] = {};
+	for (uint32_t column = 0; column < 4; column++)
+	{
+		for (uint32_t row = 0; row < 4; row++)
+		{
+			clip[column] += point[row] * view.view_projection[row * 4 + column];
+		}
+	}
+	CHECK(std::fabs(clip[0] / clip[3]) < 1e-5f);
+	CHECK(std::fabs(clip[1] / clip[3]) < 1e-5f);
+	CHECK(std::fabs(clip[3] - 10.f) < 1e-4f);
+	CHECK(clip[2] / clip[3] > 0.f && clip[2] / clip[3] < 1.f);
+
+	const float min[3] = { 3.f, 0.f, 0.f };
+	const float max[3] = { 5.f, 4.f, 6.f };
+	CHECK(std::fabs(view.GetDepth(min, max) - 3.f) < 1e-5f);
+}
+
+TEST(DrawStagesCullThenSortByMaterialAndDepth)
+{
+	// Camera at z = -5 looking down +Z, the last box is behind it
+	const float boxes[4][6] = {
+		{ -0.5f, 0.f, 4.f, 0.5f, 1.f, 5.f },
+		{ 1.f, 0.f, 0.f, 2.f, 1.f, 1.f },
+		{ -0.5f, 0.f, 1.f, 0.5f, 1.f, 2.f },
+		{ -0.5f, 0.f, -10.f, 0.5f, 1.f, -9.f } };
+	std::vector<OcclusionBounds> bounds;
+	for (const float* box : boxes)
+	{
+		bounds.push_back({ { box[0], box[1], box[2] }, { box[3], box[4], box[5] } });
+	}
+	DrawStages stages;
+	stages.SetDraws(bounds, { 2, 1, 2, 0 });
+	JobSystem jobs(2);
+	const FrameView view = FrameView::FromCamera(MakeCamera(0.f, 0.5f, -5.f, 0.f), 1.f);
+
+	DrawStageOptions options;
+	stages.BuildDrawPackets(view, 4, options, jobs);
+	CHECK(GetDrawIds(stages) == std::vector<uint32_t>({ 1, 2, 0 }));
+	CHECK_EQUAL(stages.GetFrustumCulledNum(), 1u);
+	CHECK_EQUAL(stages.GetOcclusionCulledNum(), 0u);
+	CHECK_EQUAL(stages.GetUnsortedStateChanges().material_changes, 3u);
+	CHECK_EQUAL(stages.GetSortedStateChanges().material_changes, 2u);
+
+	// Every stage off keeps all draws in draw id order
+	options.frustum_culling = false;
+	options.sorted_draws = false;
+	stages.BuildDrawPackets(view, 4, options, jobs);
+	CHECK(GetDrawIds(stages) == std::vector<uint32_t>({ 0, 1, 2, 3 }));
+
+	// Draws past draw_num are left out
+	stages.BuildDrawPackets(view, 2, options, jobs);
+	CHECK(GetDrawIds(stages) == std::vector<uint32_t>({ 0, 1 }));
+}
+
+TEST(DrawStagesOccludeBehindLargeDraws)
+{
+	std::vector<float> positions;
+	std::vector<uint32_t> indices;
+	std::vector<OcclusionBounds> bounds;
+	std::vector<OccluderMesh> meshes;
+	const float boxes[3][6] = {
+		{ -4.f, 0.f, 0.f, 4.f, 3.f, 0.2f },
+		{ -0.5f, 0.f, 2.f, 0.5f, 1.f, 3.f },
+		{ -0.5f, 0.f, -2.f, 0.5f, 1.f, -1.5f } };
+	std::vector<uint32_t> first_indices;
+	for (const float* box : boxes)
+	{
+		first_indices.push_back(static_cast<uint32_t>(indices.size()));
+		bounds.push_back(AddBoxMesh(box, box + 3, positions, indices));
+	}
+	for (uint32_t first_index : first_indices)
+	{
+		meshes.push_back({ positions.data(), 3 * sizeof(float), indices.data() + first_index, 36, 0 });
+	}
+
+	DrawStages stages;
+	stages.SetDraws(bounds, { 0, 1, 2 });
+	stages.SelectOccluders(meshes);
+	// Only the wall is large next to the scene
+	CHECK_EQUAL(stages.GetOccluderNum(), 1u);
+
+	JobSystem jobs(2);
+	const FrameView view = FrameView::FromCamera(MakeCamera(0.f, 1.f, -5.f, 0.f), 1.f);
+	DrawStageOptions options;
+	stages.BuildDrawPackets(view, 3, options, jobs);
+	CHECK(GetDrawIds(stages) == std::vector<uint32_t>({ 0, 2 }));
+	CHECK_EQUAL(stages.GetOcclusionCulledNum(), 1u);
+
+	options.occlusion_culling = false;
+	stages.BuildDrawPackets(view, 3, options, jobs);
+	CHECK_EQUAL(stages.GetDrawPackets().size(), size_t(3));
+	CHECK_EQUAL(stages.GetOcclusionCulledNum(), 0u);
+}
+
+// What the renderer submits: the recorded bundles while they replay, the culled packets otherwise
+static std::vector<uint32_t> GetSubmittedDrawIds(DrawStages& stages, DrawBundleSet& bundles, const FrameView& view,
+	const DrawStageOptions& options, JobSystem& jobs)
+{
+	const uint32_t draw_num = 4;
+	stages.BuildDrawPackets(view, draw_num, options, jobs);
+	std::vector<uint32_t> draw_ids = GetDrawIds(stages);
+	if (DrawBundleSet::CanReplay(options))
+	{
+		const uint32_t list_num = DrawStages::GetListNum(draw_num, 8);
+		if (bundles.IsStale(draw_num, list_num, options.sorted_draws))
+		{
+			bundles.Record(stages.GetDrawPackets(), draw_num, list_num, options.sorted_draws);
+		}
+		draw_ids.clear();
+		for (const DrawPacket& packet : bundles.GetPackets())
+		{
+			draw_ids.push_back(packet.draw_id);
+		}
+	}
+	std::sort(draw_ids.begin(), draw_ids.end());
+	return draw_ids;
+}
+
+TEST(DrawBundlesReplayOnlyWithoutCulling)
+{
+	// Three boxes ahead of the camera at z = -5 and one behind it
+	const float boxes[4][6] = {
+		{ -0.5f, 0.f, 4.f, 0.5f, 1.f, 5.f },
+		{ 1.f, 0.f, 0.f, 2.f, 1.f, 1.f },
+		{ -0.5f, 0.f, 1.f, 0.5f, 1.f, 2.f },
+		{ -0.5f, 0.f, -10.f, 0.5f, 1.f, -9.f } };
+	std::vector<OcclusionBounds> bounds;
+	for (const float* box : boxes)
+	{
+		bounds.push_back({ { box[0], box[1], box[2] }, { box[3], box[4], box[5] } });
+	}
+	DrawStages stages;
+	stages.SetDraws(bounds, { 2, 1, 2, 0 });
+	JobSystem jobs(2);
+	const FrameView ahead = FrameView::FromCamera(MakeCamera(0.f, 0.5f, -5.f, 0.f), 1.f);
+	const FrameView behind = FrameView::FromCamera(MakeCamera(0.f, 0.5f, -5.f, 3.14159265f), 1.f);
+
+	// Occlusion off alone still culls to the frustum, so moving the view changes the draws
+	DrawBundleSet bundles;
+	DrawStageOptions options;
+	options.occlusion_culling = false;
+	CHECK(!DrawBundleSet::CanReplay(options));
+	CHECK(GetSubmittedDrawIds(stages, bundles, ahead, options, jobs) == std::vector<uint32_t>({ 0, 1, 2 }));
+	CHECK(GetSubmittedDrawIds(stages, bundles, behind, options, jobs) == std::vector<uint32_t>({ 3 }));
+	CHECK(bundles.GetPackets().empty());
+
+	// With both off every draw is submitted from any view, recorded once
+	options.frustum_culling = false;
+	CHECK(DrawBundleSet::CanReplay(options));
+	CHECK(GetSubmittedDrawIds(stages, bundles, ahead, options, jobs) == std::vector<uint32_t>({ 0, 1, 2, 3 }));
+	const std::vector<DrawPacket> recorded = bundles.GetPackets();
+	CHECK(GetSubmittedDrawIds(stages, bundles, behind, options, jobs) == std::vector<uint32_t>({ 0, 1, 2, 3 }));
+	CHECK(!bundles.IsStale(4, 1, true));
+	CHECK_EQUAL(bundles.GetPackets().size(), recorded.size());
+	for (size_t packet = 0; packet < recorded.size(); packet++)
+	{
+		CHECK_EQUAL(bundles.GetPackets()[packet].draw_id, recorded[packet].draw_id);
+	}
+
+	// Sorting changes the recorded order, a cleared set records again
+	CHECK(bundles.IsStale(4, 1, false));
+	bundles.Clear();
+	CHECK(bundles.IsStale(4, 1, true));
+	CHECK(bundles.GetPackets().empty());
+}
+
+TEST(DrawListsSplitEvenly)
+{
+	CHECK_EQUAL(DrawStages::GetListNum(0, 8), 0u);
+	CHECK_EQUAL(DrawStages::GetListNum(1, 8), 1u);
+	CHECK_EQUAL(DrawStages::GetListNum(DrawStages::min_draws_per_list, 8), 1u);
+	CHECK_EQUAL(DrawStages::GetListNum(DrawStages::min_draws_per_list + 1, 8), 2u);
+	CHECK_EQUAL(DrawStages::GetListNum(100000, 8), 8u);
+
+	// Ranges are contiguous, cover every draw and differ by at most one draw
+	const uint32_t draw_num = 1001;
+	const uint32_t list_num = DrawStages::GetListNum(draw_num, 8);
+	CHECK_EQUAL(DrawStages::GetListDraw(draw_num, list_num, 0), 0u);
+	CHECK_EQUAL(DrawStages::GetListDraw(draw_num, list_num, list_num), draw_num);
+	for (uint32_t list = 0; list < list_num; list++)
+	{
+		const uint32_t size = DrawStages::GetListDraw(draw_num, list_num, list + 1) - DrawStages::GetListDraw(draw_num, list_num, list);
+		CHECK(size == draw_num / list_num || size == draw_num / list_num + 1);
+	}
+}
+
+TEST(FrameGraphBatchesRecordAValidFrame)
+{
+	RenderGraph graph;
+	const FrameGraph frame_graph = BuildFrameGraph(graph, 1024, 65536);
+	NullDevice device;
+	device.CreateGraphResources(graph);
+	device.SetDescriptorHeapSize(1);
+	NullCommandList lists[3];
+	for (uint32_t frame = 0; frame < 2; frame++)
+	{
+		for (NullCommandList& list : lists)
+		{
+			list.Reset();
+		}
+		RecordClearPass(lists[0], graph, frame_graph);
+		lists[0].RecordBatch(graph, frame_graph.scene_pass);
+		BeginSceneDraws(lists[1], frame_graph);
+		RecordFrameEnd(lists[2], graph);
+		const NullCommandList* submitted[] = { &lists[0], &lists[1], &lists[2] };
+		device.Execute(submitted, 3);
+		device.Present(frame_graph.back_buffer_resource);
+	}
+	CHECK(device.IsValid());
+	CHECK_EQUAL(device.GetCounts().clear_num, 4u);
+	CHECK_EQUAL(lists[1].GetCommands()[0].arguments[0], frame_graph.back_buffer_resource);
+	CHECK_EQUAL(lists[1].GetCommands()[0].arguments[1], frame_graph.depth_resource);
+}
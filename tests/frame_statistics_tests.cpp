@@ -0,0 +1,96 @@
+#include "test.h"
+#include "frame_statistics.h"
+
+#include <atomic>
+#include <thread>
+
+TEST(FramePercentilesUseNearestRank)
+{
+	std::vector<float> values;
+	for (uint32_t value = 100; value >= 1; value--)
+	{
+		values.push_back(static_cast<float>(value));
+	}
+	const Percentiles percentiles = ComputePercentiles(values);
+	CHECK_EQUAL(percentiles.p50, 50.f);
+	CHECK_EQUAL(percentiles.p95, 95.f);
+	CHECK_EQUAL(percentiles.p99, 99.f);
+	CHECK_EQUAL(percentiles.max, 100.f);
+	CHECK_EQUAL(percentiles.mean, 50.5f);
+	CHECK_EQUAL(percentiles.sample_num, 100u);
+	CHECK_EQUAL(ComputePercentiles({}).sample_num, 0u);
+}
+
+TEST(FrameGpuTimeArrivesLate)
+{
+	FrameStatistics statistics;
+	const uint64_t first = statistics.AddFrame(16.f, 4.f, 10, 100, 3);
+	const uint64_t second = statistics.AddFrame(17.f, 5.f, 11, 110, 4);
+	statistics.SetGpuTime(first, 8.f);
+	const std::vector<FrameSample> samples = statistics.GetSamples();
+	CHECK_EQUAL(samples.size(), size_t(2));
+	CHECK_EQUAL(samples[0].gpu_time, 8.f);
+	CHECK_EQUAL(samples[1].frame, second);
+	CHECK(samples[1].gpu_time < 0.f);
+	// Frames without a GPU time stay out of its percentiles
+	const FrameStatisticsSummary summary = statistics.Summarize();
+	CHECK_EQUAL(summary.frame_num, 2u);
+	CHECK_EQUAL(summary.gpu_time.sample_num, 1u);
+	CHECK_EQUAL(summary.triangle_num.max, 110.f);
+}
+
+TEST(FrameRingKeepsTheLatestFrames)
+{
+	FrameStatistics statistics;
+	for (uint32_t frame = 0; frame < FrameStatistics::capacity + 10; frame++)
+	{
+		statistics.AddFrame(static_cast<float>(frame), 0.f, frame, 0, 0);
+	}
+	// A frame that left the ring keeps its slot's newer sample untouched
+	statistics.SetGpuTime(3, 1.f);
+	const std::vector<FrameSample> samples = statistics.GetSamples();
+	CHECK_EQUAL(samples.size(), size_t(FrameStatistics::capacity));
+	CHECK_EQUAL(samples.front().frame, 10ull);
+	CHECK(samples[FrameStatistics::capacity - 7].gpu_time < 0.f);
+	CHECK_EQUAL(statistics.GetSamples(5).front().frame, uint64_t(FrameStatistics::capacity + 5));
+}
+
+TEST(FrameSnapshotsNeverSeeTornSamples)
+{
+	// Every field is derived from the frame id, a torn copy would mix two frames
+	FrameStatistics statistics;
+	std::atomic<bool> done(false);
+	std::thread writer([&]()
+	{
+		for (uint32_t frame = 0; frame < 100000; frame++)
+		{
+			statistics.AddFrame(static_cast<float>(frame), static_cast<float>(frame), frame, frame, frame);
+			if (frame >= 2)
+			{
+				statistics.SetGpuTime(frame - 2, static_cast<float>(frame - 2));
+			}
+		}
+		done.store(true);
+	});
+	uint32_t torn_num = 0;
+	bool in_order = true;
+	while (!done.load())
+	{
+		const std::vector<FrameSample> samples = statistics.GetSamples(64);
+		for (size_t i = 0; i < samples.size(); i++)
+		{
+			const FrameSample& sample = samples[i];
+			const float value = static_cast<float>(sample.frame);
+			if (sample.frame_time != value || sample.cpu_time != value || sample.draw_num != sample.frame ||
+				sample.triangle_num != sample.frame || sample.state_change_num != sample.frame ||
+				(sample.gpu_time >= 0.f && sample.gpu_time != value))
+			{
+				torn_num++;
+			}
+			in_order = in_order && (i == 0 || samples[i - 1].frame < sample.frame);
+		}
+	}
+	writer.join();
+	CHECK_EQUAL(torn_num, 0u);
+	CHECK(in_order);
+}
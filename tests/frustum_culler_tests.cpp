@@ -0,0 +1,80 @@
+#include "test.h"
+#include "test_camera.h"
+#include "frustum_culler.h"
+#include "job_system.h"
+
+#include <random>
+
+static void SetBox(InstanceBounds& bounds, uint32_t instance, float x, float y, float z, float extent)
+{
+	const float min[3] = { x - extent, y - extent, z - extent };
+	const float max[3] = { x + extent, y + extent, z + extent };
+	bounds.Set(instance, min, max);
+}
+
+TEST(FrustumKeepsBoxesTouchingTheFrustum)
+{
+	float view_projection[16];
+	MakePerspective(view_projection);
+	const FrustumPlanes planes = FrustumPlanes::FromViewProjection(view_projection);
+	InstanceBounds bounds;
+	bounds.Resize(7);
+	SetBox(bounds, 0, 0.f, 0.f, 10.f, 1.f);     // straight ahead
+	SetBox(bounds, 1, 0.f, 0.f, -10.f, 1.f);    // behind the camera
+	SetBox(bounds, 2, 20.f, 0.f, 10.f, 1.f);    // right of the 90 degree frustum
+	SetBox(bounds, 3, 10.5f, 0.f, 10.f, 1.f);   // straddling the right plane
+	SetBox(bounds, 4, 0.f, -30.f, 10.f, 1.f);   // below
+	SetBox(bounds, 5, 0.f, 0.f, 200.f, 1.f);    // beyond the far plane
+	SetBox(bounds, 6, 0.f, 0.f, 0.f, 0.5f);     // around the eye, crossing the near plane
+
+	uint8_t visible[7] = {};
+	FrustumCuller culler;
+	culler.SetKernel(FrustumCuller::KERNEL_SCALAR);
+	CHECK_EQUAL(culler.CullRange(planes, bounds, 0, 7, visible), 3u);
+	const uint8_t expected[7] = { 1, 0, 0, 1, 0, 0, 1 };
+	for (uint32_t instance = 0; instance < 7; instance++)
+	{
+		CHECK_EQUAL(visible[instance], expected[instance]);
+	}
+}
+
+TEST(FrustumSimdKernelsMatchScalar)
+{
+	float view_projection[16];
+	MakePerspective(view_projection, 1.f, 16.f / 9.f);
+	const FrustumPlanes planes = FrustumPlanes::FromViewProjection(view_projection);
+	// Not a whole number of groups, so the scalar tail runs too
+	const uint32_t instance_num = 10007;
+	InstanceBounds bounds;
+	bounds.Resize(instance_num);
+	std::mt19937 random(11);
+	std::uniform_real_distribution<float> position(-60.f, 60.f);
+	std::uniform_real_distribution<float> extent(0.1f, 4.f);
+	for (uint32_t instance = 0; instance < instance_num; instance++)
+	{
+		SetBox(bounds, instance, position(random), position(random), position(random), extent(random));
+	}
+
+	FrustumCuller culler;
+	culler.SetKernel(FrustumCuller::KERNEL_SCALAR);
+	std::vector<uint8_t> expected(instance_num);
+	const uint32_t expected_num = culler.CullRange(planes, bounds, 0, instance_num, expected.data());
+	CHECK(expected_num > 0 && expected_num < instance_num);
+
+	std::vector<FrustumCuller::Kernel> kernels = { FrustumCuller::KERNEL_SSE2 };
+	if (FrustumCuller::HasAvx2())
+	{
+		kernels.push_back(FrustumCuller::KERNEL_AVX2);
+	}
+	JobSystem jobs(4);
+	for (FrustumCuller::Kernel kernel : kernels)
+	{
+		culler.SetKernel(kernel);
+		std::vector<uint8_t> visible(instance_num, 7);
+		CHECK_EQUAL(culler.CullRange(planes, bounds, 0, instance_num, visible.data()), expected_num);
+		CHECK(visible == expected);
+		std::vector<uint8_t> parallel_visible(instance_num, 7);
+		CHECK_EQUAL(culler.Cull(planes, bounds, instance_num, parallel_visible.data(), jobs), expected_num);
+		CHECK(parallel_visible == expected);
+	}
+}
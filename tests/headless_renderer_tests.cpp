@@ -0,0 +1,92 @@
+#include "test.h"
+#include "test_scene.h"
+#include "headless_renderer.h"
+#include "job_system.h"
+
+#include <algorithm>
+
+// A row of boxes in front of a wall and a row behind it, looking down +Z from z = -5
+static void LoadWallScene(HeadlessRenderer& renderer)
+{
+	std::vector<HeadlessDraw> draws;
+	std::vector<float> positions;
+	std::vector<uint32_t> indices;
+	auto add_box = [&](const float* min, const float* max, uint32_t texture_index)
+	{
+		HeadlessDraw draw = {};
+		draw.start_index = static_cast<uint32_t>(indices.size());
+		const OcclusionBounds bounds = AddBoxMesh(min, max, positions, indices);
+		std::copy(bounds.min, bounds.min + 3, draw.min);
+		std::copy(bounds.max, bounds.max + 3, draw.max);
+		draw.index_num = static_cast<uint32_t>(indices.size()) - draw.start_index;
+		draw.texture_index = texture_index;
+		draws.push_back(draw);
+	};
+	const float wall_min[3] = { -4.f, 0.f, 0.f };
+	const float wall_max[3] = { 4.f, 3.f, 0.2f };
+	add_box(wall_min, wall_max, 0);
+	for (uint32_t box = 0; box < 40; box++)
+	{
+		const float x = -1.f + 0.05f * box;
+		const float front_min[3] = { x, 0.f, -2.f };
+		const float front_max[3] = { x + 0.04f, 0.5f, -1.9f };
+		const float back_min[3] = { x, 0.f, 2.f };
+		const float back_max[3] = { x + 0.04f, 0.5f, 2.1f };
+		add_box(front_min, front_max, 1 + box % 3);
+		add_box(back_min, back_max, 1 + box % 3);
+	}
+	renderer.Load(draws, positions, indices, 4);
+}
+
+static CameraSnapshot MakeWallCamera()
+{
+	CameraSnapshot camera = {};
+	camera.eye_position[0] = 0.f;
+	camera.eye_position[1] = 1.f;
+	camera.eye_position[2] = -5.f;
+	return camera;
+}
+
+TEST(HeadlessWallHidesTheRowBehindIt)
+{
+	JobSystem jobs(2);
+	HeadlessRenderer renderer(jobs, 640, 360, 4);
+	LoadWallScene(renderer);
+	CHECK_EQUAL(renderer.GetOccluderNum(), 1u);
+
+	const HeadlessFrame frame = renderer.RenderFrame(MakeWallCamera());
+	CHECK_EQUAL(frame.occlusion_culled_num, 40u);
+	CHECK_EQUAL(frame.frustum_culled_num, 0u);
+	CHECK_EQUAL(frame.draw_num, 41u);
+	CHECK_EQUAL(frame.triangle_num, 41u * 12);
+	// 41 draws need two lists, between the clear and end lists
+	CHECK_EQUAL(frame.list_num, 4u);
+	CHECK(renderer.GetDevice().IsValid());
+	CHECK_EQUAL(renderer.GetDevice().GetCounts().draw_num, 41u);
+
+	DrawStageOptions options;
+	options.occlusion_culling = false;
+	renderer.SetOptions(options);
+	CHECK_EQUAL(renderer.RenderFrame(MakeWallCamera()).draw_num, 81u);
+}
+
+TEST(HeadlessFramesStayValidAroundTheScene)
+{
+	JobSystem jobs(2);
+	HeadlessRenderer renderer(jobs, 640, 360, 4);
+	LoadWallScene(renderer);
+	CameraSnapshot camera = MakeWallCamera();
+	uint32_t max_draw_num = 0;
+	for (uint32_t frame = 0; frame < 16; frame++)
+	{
+		camera.angle = frame * 0.4f;
+		const HeadlessFrame counts = renderer.RenderFrame(camera);
+		CHECK_EQUAL(counts.draw_num + counts.frustum_culled_num + counts.occlusion_culled_num, 81u);
+		max_draw_num = std::max(max_draw_num, counts.draw_num);
+	}
+	CHECK(renderer.GetDevice().IsValid());
+	CHECK_EQUAL(renderer.GetDevice().GetCounts().present_num, 16u);
+	// Pass constants, then one 256-byte slice per draw packet
+	CHECK(max_draw_num > 0);
+	CHECK_EQUAL(renderer.GetConstantHighWaterMark(), 256ull * max_draw_num + 64);
+}
@@ -0,0 +1,210 @@
+#include "test.h"
+#include "heap_allocator.h"
+
+#include <algorithm>
+#include <random>
+
+TEST(BuddySplitsDownToTheRequestedBlock)
+{
+	BuddyAllocator allocator(1024, 64);
+	CHECK_EQUAL(allocator.Allocate(64, 1), 0ull);
+	// Splitting 1024 down to 64 leaves one free buddy per level below the root
+	const HeapAllocatorStatistics statistics = allocator.GetStatistics();
+	CHECK_EQUAL(statistics.free_block_num, 4ull);
+	CHECK_EQUAL(statistics.largest_free_block, 512ull);
+	CHECK_EQUAL(statistics.used_size, 64ull);
+	CHECK_EQUAL(allocator.Allocate(64, 1), 64ull);
+	CHECK_EQUAL(allocator.Allocate(128, 1), 128ull);
+	CHECK_EQUAL(allocator.Allocate(512, 1), 512ull);
+}
+
+TEST(BuddyMergesFreedBuddies)
+{
+	BuddyAllocator allocator(1024, 64);
+	const uint64_t a = allocator.Allocate(64, 1);
+	const uint64_t b = allocator.Allocate(64, 1);
+	const uint64_t c = allocator.Allocate(256, 1);
+	allocator.Free(a);
+	// b still holds the buddy of a
+	CHECK_EQUAL(allocator.GetStatistics().largest_free_block, 512ull);
+	allocator.Free(b);
+	allocator.Free(c);
+	const HeapAllocatorStatistics statistics = allocator.GetStatistics();
+	CHECK_EQUAL(statistics.free_block_num, 1ull);
+	CHECK_EQUAL(statistics.largest_free_block, 1024ull);
+	CHECK_EQUAL(statistics.used_size, 0ull);
+	CHECK_EQUAL(allocator.Allocate(1024, 1), 0ull);
+}
+
+TEST(BuddyAlignsBlocksToTheirSize)
+{
+	BuddyAllocator allocator(1 << 20, 256);
+	allocator.Allocate(256, 1);
+	// A small resource with 64K alignment takes a whole 64K block
+	const uint64_t aligned = allocator.Allocate(1000, 64 * 1024);
+	CHECK(aligned != HeapAllocator::invalid_offset);
+	CHECK_EQUAL(aligned % (64 * 1024), 0ull);
+	for (uint64_t size = 300; size < 40000; size *= 3)
+	{
+		const uint64_t offset = allocator.Allocate(size, 1);
+		uint64_t block_size = 256;
+		while (block_size < size)
+		{
+			block_size *= 2;
+		}
+		CHECK_EQUAL(offset % block_size, 0ull);
+	}
+}
+
+TEST(BuddyReportsExhaustion)
+{
+	BuddyAllocator allocator(1024, 256);
+	CHECK_EQUAL(allocator.Allocate(2048, 1), HeapAllocator::invalid_offset);
+	CHECK_EQUAL(allocator.Allocate(0, 1), HeapAllocator::invalid_offset);
+	for (uint32_t block = 0; block < 4; block++)
+	{
+		CHECK(allocator.Allocate(200, 1) != HeapAllocator::invalid_offset);
+	}
+	CHECK_EQUAL(allocator.Allocate(1, 1), HeapAllocator::invalid_offset);
+	allocator.Free(512);
+	CHECK_EQUAL(allocator.Allocate(1, 1), 512ull);
+}
+
+TEST(BuddyIgnoresUnknownFrees)
+{
+	BuddyAllocator allocator(1024, 64);
+	const uint64_t offset = allocator.Allocate(64, 1);
+	allocator.Free(offset + 64);
+	allocator.Free(offset);
+	allocator.Free(offset);
+	CHECK_EQUAL(allocator.GetStatistics().free_block_num, 1ull);
+}
+
+TEST(BuddyStatisticsTrackFragmentation)
+{
+	BuddyAllocator allocator(1024, 64);
+	std::vector<uint64_t> offsets;
+	for (uint32_t block = 0; block < 16; block++)
+	{
+		offsets.push_back(allocator.Allocate(48, 1));
+	}
+	HeapAllocatorStatistics statistics = allocator.GetStatistics();
+	CHECK_EQUAL(statistics.requested_size, 16ull * 48);
+	CHECK_EQUAL(statistics.used_size, 1024ull);
+	CHECK(statistics.GetUtilization() == 0.75f);
+	CHECK(statistics.GetFragmentation() == 0.f);
+
+	// Every other block free: 512 bytes free, none of it larger than 64
+	for (uint32_t block = 0; block < 16; block += 2)
+	{
+		allocator.Free(offsets[block]);
+	}
+	statistics = allocator.GetStatistics();
+	CHECK_EQUAL(statistics.free_block_num, 8ull);
+	CHECK_EQUAL(statistics.largest_free_block, 64ull);
+	CHECK(statistics.GetFragmentation() == 1.f - 64.f / 512.f);
+	CHECK_EQUAL(allocator.Allocate(128, 1), HeapAllocator::invalid_offset);
+
+	HeapAllocatorStatistics total = statistics;
+	total += BuddyAllocator(4096, 64).GetStatistics();
+	CHECK_EQUAL(total.size, 1024ull + 4096);
+	CHECK_EQUAL(total.largest_free_block, 4096ull);
+}
+
+TEST(BuddyRandomAllocationsNeverOverlap)
+{
+	const uint64_t heap_size = 1 << 20;
+	BuddyAllocator allocator(heap_size, 256);
+	std::mt19937 random(7);
+	std::vector<std::pair<uint64_t, uint64_t>> live;
+	for (uint32_t step = 0; step < 20000; step++)
+	{
+		if (live.empty() || random() % 3 != 0)
+		{
+			const uint64_t size = 1 + random() % 20000;
+			const uint64_t offset = allocator.Allocate(size, 1);
+			if (offset != HeapAllocator::invalid_offset)
+			{
+				CHECK(offset + size <= heap_size);
+				live.push_back({ offset, size });
+			}
+		}
+		else
+		{
+			const size_t index = random() % live.size();
+			allocator.Free(live[index].first);
+			live[index] = live.back();
+			live.pop_back();
+		}
+	}
+	std::sort(live.begin(), live.end());
+	for (size_t index = 1; index < live.size(); index++)
+	{
+		CHECK(live[index - 1].first + live[index - 1].second <= live[index].first);
+	}
+	CHECK_EQUAL(allocator.GetStatistics().allocation_num, static_cast<uint64_t>(live.size()));
+	for (const std::pair<uint64_t, uint64_t>& allocation : live)
+	{
+		allocator.Free(allocation.first);
+	}
+	CHECK_EQUAL(allocator.GetStatistics().largest_free_block, heap_size);
+}
+
+TEST(HeapListFreesAndCoalescesThroughTheInterface)
+{
+	HeapAllocatorList allocators(1024, 64);
+	HeapAllocatorList::Block block = {};
+	CHECK(!allocators.Allocate(64, 1, block));
+	CHECK_EQUAL(allocators.AddHeap(allocators.GetNewHeapSize(64)), 0u);
+
+	std::vector<HeapAllocatorList::Block> blocks;
+	for (uint32_t index = 0; index < 4; index++)
+	{
+		CHECK(allocators.Allocate(256, 1, block));
+		CHECK_EQUAL(block.heap_index, 0u);
+		blocks.push_back(block);
+	}
+	CHECK(!allocators.Allocate(64, 1, block));
+	CHECK_EQUAL(allocators.GetStatistics().allocation_num, 4ull);
+
+	// Freeing the middle pair leaves two 256 blocks that are not buddies
+	allocators.Free(blocks[1]);
+	allocators.Free(blocks[2]);
+	CHECK_EQUAL(allocators.GetStatistics().largest_free_block, 256ull);
+	CHECK(!allocators.Allocate(512, 1, block));
+	allocators.Free(blocks[0]);
+	allocators.Free(blocks[3]);
+	const HeapAllocatorStatistics statistics = allocators.GetStatistics();
+	CHECK_EQUAL(statistics.allocation_num, 0ull);
+	CHECK_EQUAL(statistics.free_block_num, 1ull);
+	CHECK_EQUAL(statistics.largest_free_block, 1024ull);
+	CHECK(allocators.Allocate(1024, 1, block));
+	CHECK_EQUAL(block.offset, 0ull);
+}
+
+TEST(HeapListGrowsWithNewHeaps)
+{
+	HeapAllocatorList allocators(1024, 64);
+	allocators.AddHeap(allocators.GetNewHeapSize(1024));
+	HeapAllocatorList::Block first = {};
+	CHECK(allocators.Allocate(1024, 1, first));
+
+	// A full heap sends the request to a new one, oversized requests get a larger heap
+	HeapAllocatorList::Block block = {};
+	CHECK(!allocators.Allocate(512, 1, block));
+	CHECK_EQUAL(allocators.GetNewHeapSize(512), 1024ull);
+	CHECK_EQUAL(allocators.GetNewHeapSize(3000), 4096ull);
+	CHECK_EQUAL(allocators.AddHeap(allocators.GetNewHeapSize(3000)), 1u);
+	CHECK(allocators.Allocate(3000, 1, block));
+	CHECK_EQUAL(block.heap_index, 1u);
+	CHECK_EQUAL(allocators.GetHeapNum(), 2u);
+	CHECK_EQUAL(allocators.GetStatistics().size, 5120ull);
+
+	// Freed space in the first heap is used again before later heaps
+	allocators.Free(first);
+	CHECK(allocators.Allocate(512, 1, block));
+	CHECK_EQUAL(block.heap_index, 0u);
+	// Blocks of unknown heaps are ignored
+	allocators.Free({ 7, 0 });
+	CHECK_EQUAL(allocators.GetStatistics().allocation_num, 2ull);
+}
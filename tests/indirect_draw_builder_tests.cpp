@@ -0,0 +1,83 @@
+#include "test.h"
+#include "indirect_draw_builder.h"
+
+#include <cstddef>
+
+// The command signature is a root constant followed by D3D12_DRAW_INDEXED_ARGUMENTS
+static_assert(sizeof(IndirectDrawArguments) == 20, "D3D12_DRAW_INDEXED_ARGUMENTS is five 32-bit values");
+static_assert(sizeof(IndirectDrawCommand) == 24, "argument buffer stride");
+static_assert(offsetof(IndirectDrawCommand, draw) == 4, "draw arguments follow the material constant");
+static_assert(offsetof(IndirectDrawArguments, base_vertex_location) == 12, "base vertex is the fourth value");
+
+static IndirectDrawInput MakeDraw(uint32_t index_num, uint32_t start_index, uint32_t material_index, uint32_t group_key)
+{
+	IndirectDrawInput draw = {};
+	draw.index_num = index_num;
+	draw.start_index = start_index;
+	draw.start_vertex = start_index / 2;
+	draw.instance_num = 1;
+	draw.material_index = material_index;
+	draw.group_key = group_key;
+	return draw;
+}
+
+TEST(IndirectCommandsCopyTheDrawArguments)
+{
+	IndirectDrawBuilder builder;
+	builder.Build({ MakeDraw(36, 0, 7, 0), MakeDraw(6, 36, 9, 0) });
+	const std::vector<IndirectDrawCommand>& commands = builder.GetCommands();
+	CHECK_EQUAL(commands.size(), size_t(2));
+	CHECK_EQUAL(commands[1].material_index, 9u);
+	CHECK_EQUAL(commands[1].draw.index_count_per_instance, 6u);
+	CHECK_EQUAL(commands[1].draw.instance_count, 1u);
+	CHECK_EQUAL(commands[1].draw.start_index_location, 36u);
+	CHECK_EQUAL(commands[1].draw.base_vertex_location, 18);
+	CHECK_EQUAL(commands[1].draw.start_instance_location, 0u);
+	CHECK_EQUAL(builder.GetArgumentBufferSize(), 2ull * sizeof(IndirectDrawCommand));
+}
+
+TEST(IndirectCommandsGroupByKeyInDrawOrder)
+{
+	IndirectDrawBuilder builder;
+	builder.Build({ MakeDraw(3, 0, 0, 2), MakeDraw(3, 3, 1, 1), MakeDraw(3, 6, 2, 2), MakeDraw(3, 9, 3, 1), MakeDraw(3, 12, 4, 2) });
+	const std::vector<IndirectDrawGroup>& groups = builder.GetGroups();
+	CHECK_EQUAL(groups.size(), size_t(2));
+	CHECK_EQUAL(groups[0].group_key, 1u);
+	CHECK_EQUAL(groups[0].first_command, 0u);
+	CHECK_EQUAL(groups[0].command_num, 2u);
+	CHECK_EQUAL(groups[1].group_key, 2u);
+	CHECK_EQUAL(groups[1].first_command, 2u);
+	CHECK_EQUAL(groups[1].command_num, 3u);
+	CHECK(builder.GetDrawIds() == std::vector<uint32_t>({ 1, 3, 0, 2, 4 }));
+	CHECK_EQUAL(builder.GetCommands()[2].material_index, 0u);
+	CHECK_EQUAL(builder.GetCountBufferSize(), 2ull * sizeof(uint32_t));
+}
+
+TEST(IndirectCountsCoverTheActiveDrawPrefix)
+{
+	IndirectDrawBuilder builder;
+	builder.Build({ MakeDraw(3, 0, 0, 2), MakeDraw(3, 3, 1, 1), MakeDraw(3, 6, 2, 2), MakeDraw(3, 9, 3, 1), MakeDraw(3, 12, 4, 2) });
+	uint32_t counts[2] = {};
+	builder.WriteCounts(5, counts);
+	CHECK_EQUAL(counts[0], 2u);
+	CHECK_EQUAL(counts[1], 3u);
+	// Draws 0..2: draw 1 in the first group, draws 0 and 2 in the second
+	builder.WriteCounts(3, counts);
+	CHECK_EQUAL(counts[0], 1u);
+	CHECK_EQUAL(counts[1], 2u);
+	builder.WriteCounts(0, counts);
+	CHECK_EQUAL(counts[0], 0u);
+	CHECK_EQUAL(counts[1], 0u);
+}
+
+TEST(IndirectRebuildReplacesThePreviousBuffer)
+{
+	IndirectDrawBuilder builder;
+	builder.Build({ MakeDraw(3, 0, 0, 0), MakeDraw(3, 3, 1, 1) });
+	builder.Build({ MakeDraw(6, 0, 5, 0) });
+	CHECK_EQUAL(builder.GetCommands().size(), size_t(1));
+	CHECK_EQUAL(builder.GetGroups().size(), size_t(1));
+	CHECK_EQUAL(builder.GetDrawIds().size(), size_t(1));
+	builder.Build({});
+	CHECK_EQUAL(builder.GetArgumentBufferSize(), 0ull);
+}
@@ -0,0 +1,157 @@
+#include "test.h"
+#include "test_camera.h"
+#include "occlusion_culler.h"
+#include "frustum_culler.h"
+#include "job_system.h"
+
+#include <algorithm>
+#include <random>
+
+// Camera square facing a wall: a quad at z = 5 covering x and y in [-2, 2]
+static void DrawWall(OcclusionCuller& culler, JobSystem& jobs)
+{
+	float view_projection[16];
+	MakePerspective(view_projection);
+	culler.BeginFrame(view_projection);
+	const float positions[4][3] = { { -2.f, -2.f, 5.f }, { 2.f, -2.f, 5.f }, { 2.f, 2.f, 5.f }, { -2.f, 2.f, 5.f } };
+	const uint32_t indices[6] = { 0, 2, 1, 0, 3, 2 };
+	culler.AddOccluder(positions, sizeof(positions[0]), indices, 6, 0);
+	culler.Rasterize(jobs);
+}
+
+static OcclusionBounds MakeBox(float x, float y, float z, float extent)
+{
+	return { { x - extent, y - extent, z - extent }, { x + extent, y + extent, z + extent } };
+}
+
+TEST(OcclusionRasterizesTheOccluderDepth)
+{
+	JobSystem jobs(2);
+	OcclusionCuller culler(64, 64);
+	DrawWall(culler, jobs);
+	CHECK_EQUAL(culler.GetTriangleNum(), 2u);
+	// The wall spans the middle 40% of a 90 degree view
+	const float* depth = culler.GetDepth();
+	const float wall_depth = 100.f / 99.9f * (1.f - 0.1f / 5.f);
+	CHECK(std::fabs(depth[32 * 64 + 32] - wall_depth) < 1e-4f);
+	CHECK(std::fabs(depth[20 * 64 + 20] - wall_depth) < 1e-4f);
+	CHECK_EQUAL(depth[0], 1.f);
+	CHECK_EQUAL(depth[32 * 64 + 2], 1.f);
+	CHECK_EQUAL(depth[63 * 64 + 63], 1.f);
+}
+
+TEST(OcclusionHidesBoxesBehindTheOccluder)
+{
+	JobSystem jobs(2);
+	OcclusionCuller culler(128, 64);
+	DrawWall(culler, jobs);
+	CHECK(!culler.IsVisible(MakeBox(0.f, 0.f, 10.f, 1.f)));
+	CHECK(!culler.IsVisible(MakeBox(0.5f, -0.5f, 50.f, 3.f)));
+	// In front of the wall, beside it, or poking out from behind it
+	CHECK(culler.IsVisible(MakeBox(0.f, 0.f, 3.f, 1.f)));
+	CHECK(culler.IsVisible(MakeBox(8.f, 0.f, 10.f, 1.f)));
+	CHECK(culler.IsVisible(MakeBox(3.f, 0.f, 10.f, 2.f)));
+	// Reaching through the wall
+	CHECK(culler.IsVisible(MakeBox(0.f, 0.f, 5.5f, 1.f)));
+	// Crossing the near plane or behind the camera is conservatively visible, frustum culling drops those
+	CHECK(culler.IsVisible(MakeBox(0.f, 0.f, 0.f, 1.f)));
+	CHECK(culler.IsVisible(MakeBox(0.f, 0.f, -10.f, 1.f)));
+}
+
+TEST(OcclusionWithoutOccludersHidesNothingOnScreen)
+{
+	JobSystem jobs(2);
+	OcclusionCuller culler;
+	float view_projection[16];
+	MakePerspective(view_projection);
+	culler.BeginFrame(view_projection);
+	culler.Rasterize(jobs);
+	CHECK(culler.IsVisible(MakeBox(0.f, 0.f, 10.f, 1.f)));
+	CHECK(culler.IsVisible(MakeBox(0.f, 0.f, 90.f, 1.f)));
+}
+
+TEST(OcclusionOccludersCrossingTheNearPlaneAreSkipped)
+{
+	JobSystem jobs(2);
+	OcclusionCuller culler(64, 64);
+	float view_projection[16];
+	MakePerspective(view_projection);
+	culler.BeginFrame(view_projection);
+	const float positions[3][3] = { { -2.f, -2.f, -1.f }, { 2.f, -2.f, 5.f }, { 0.f, 2.f, 5.f } };
+	const uint32_t indices[3] = { 0, 1, 2 };
+	culler.AddOccluder(positions, sizeof(positions[0]), indices, 3, 0);
+	culler.Rasterize(jobs);
+	CHECK_EQUAL(culler.GetTriangleNum(), 0u);
+}
+
+TEST(OcclusionParallelTestMatchesSingleBoxes)
+{
+	JobSystem jobs(4);
+	OcclusionCuller culler;
+	DrawWall(culler, jobs);
+	std::vector<OcclusionBounds> bounds;
+	for (int x = -10; x <= 10; x++)
+	{
+		for (int z = 2; z < 30; z += 3)
+		{
+			bounds.push_back(MakeBox(x * 0.7f, 0.f, static_cast<float>(z), 0.3f));
+		}
+	}
+	std::vector<uint8_t> visible(bounds.size(), 1);
+	// Boxes already culled are left alone
+	visible[0] = 0;
+	culler.TestVisibility(bounds.data(), static_cast<uint32_t>(bounds.size()), visible.data(), jobs);
+	uint32_t hidden_num = 0;
+	for (size_t box = 1; box < bounds.size(); box++)
+	{
+		CHECK_EQUAL(visible[box] != 0, culler.IsVisible(bounds[box]));
+		hidden_num += visible[box] == 0;
+	}
+	CHECK_EQUAL(visible[0], 0);
+	CHECK(hidden_num > 0);
+}
+
+TEST(OcclusionAvx2KernelMatchesSse2)
+{
+	if (!FrustumCuller::HasAvx2())
+	{
+		return;
+	}
+	// Random triangles of all sizes, many crossing tile and 8 pixel group edges
+	std::mt19937 random(5);
+	std::uniform_real_distribution<float> spread(-6.f, 6.f);
+	std::uniform_real_distribution<float> distance(2.f, 40.f);
+	std::vector<float> positions;
+	std::vector<uint32_t> indices;
+	for (uint32_t triangle = 0; triangle < 300; triangle++)
+	{
+		const float x = spread(random);
+		const float y = spread(random);
+		const float z = distance(random);
+		const float size = 0.05f + (triangle % 7) * 0.5f;
+		for (uint32_t corner = 0; corner < 3; corner++)
+		{
+			indices.push_back(static_cast<uint32_t>(positions.size() / 3));
+			positions.push_back(x + spread(random) * size);
+			positions.push_back(y + spread(random) * size);
+			positions.push_back(z + spread(random) * 0.1f);
+		}
+	}
+
+	float view_projection[16];
+	MakePerspective(view_projection, 1.f, 16.f / 9.f);
+	JobSystem jobs(2);
+	std::vector<float> depths[2];
+	const OcclusionCuller::Kernel kernels[2] = { OcclusionCuller::KERNEL_SSE2, OcclusionCuller::KERNEL_AVX2 };
+	for (uint32_t kernel = 0; kernel < 2; kernel++)
+	{
+		OcclusionCuller culler;
+		culler.SetKernel(kernels[kernel]);
+		culler.BeginFrame(view_projection);
+		culler.AddOccluder(positions.data(), 3 * sizeof(float), indices.data(), static_cast<uint32_t>(indices.size()), 0);
+		culler.Rasterize(jobs);
+		depths[kernel].assign(culler.GetDepth(), culler.GetDepth() + culler.GetWidth() * culler.GetHeight());
+	}
+	CHECK(std::count(depths[0].begin(), depths[0].end(), 1.f) < static_cast<std::ptrdiff_t>(depths[0].size()));
+	CHECK(depths[0] == depths[1]);
+}
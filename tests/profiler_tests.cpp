@@ -0,0 +1,111 @@
+#include "test.h"
+#include "profiler.h"
+
+#include <sstream>
+#include <thread>
+
+// PROFILE_SCOPE compiles away without ENABLE_PROFILER, the tests use ProfileScope directly
+TEST(ProfilerScopesNestOnTheirThread)
+{
+	Profiler& profiler = Profiler::Get();
+	profiler.Clear();
+	{
+		ProfileScope outer("outer");
+		{
+			ProfileScope inner("inner");
+		}
+		ProfileScope sibling("sibling");
+	}
+	const std::vector<ProfileEvent> events = profiler.GetEvents();
+	CHECK_EQUAL(events.size(), size_t(3));
+	// Events are added when scopes end, innermost first
+	CHECK(std::string(events[0].name) == "inner");
+	CHECK(std::string(events[1].name) == "sibling");
+	CHECK(std::string(events[2].name) == "outer");
+	CHECK_EQUAL(events[0].depth, 1u);
+	CHECK_EQUAL(events[1].depth, 1u);
+	CHECK_EQUAL(events[2].depth, 0u);
+	for (const ProfileEvent& event : events)
+	{
+		CHECK(event.track == ProfileEvent::TRACK_CPU);
+		CHECK_EQUAL(event.thread_id, events[2].thread_id);
+		CHECK(events[2].begin <= event.begin && event.end <= events[2].end);
+	}
+	CHECK(events[0].end <= events[1].begin);
+}
+
+TEST(ProfilerThreadsGetTheirOwnIdsAndDepths)
+{
+	Profiler& profiler = Profiler::Get();
+	profiler.Clear();
+	ProfileScope main_scope("main");
+	std::thread worker([]() { ProfileScope worker_scope("worker"); });
+	worker.join();
+	const std::vector<ProfileEvent> events = profiler.GetEvents();
+	CHECK_EQUAL(events.size(), size_t(1));
+	// The open scope on this thread does not nest the worker's
+	CHECK_EQUAL(events[0].depth, 0u);
+	{
+		ProfileScope probe("probe");
+	}
+	const ProfileEvent probe = profiler.GetEvents().back();
+	CHECK_EQUAL(probe.depth, 1u);
+	CHECK(events[0].thread_id != probe.thread_id);
+}
+
+TEST(ProfilerAveragesCpuScopesPerFrameAndGpuRangesPerRange)
+{
+	Profiler& profiler = Profiler::Get();
+	profiler.Clear();
+	const uint64_t frame = profiler.GetFrame();
+	// Two 1 ms scopes in one frame count as 2 ms
+	profiler.BeginScope();
+	profiler.EndScope("work", Profiler::Now() - 1000000);
+	profiler.BeginScope();
+	profiler.EndScope("work", Profiler::Now() - 1000000);
+	profiler.AddGpuRange("pass", frame, 5000000, 8000000);
+	profiler.EndFrame();
+	CHECK(profiler.GetAverage("work", ProfileEvent::TRACK_CPU) >= 2.f);
+	CHECK(profiler.GetAverage("work", ProfileEvent::TRACK_CPU) < 3.f);
+	CHECK_EQUAL(profiler.GetAverage("pass", ProfileEvent::TRACK_GPU), 3.f);
+	CHECK_EQUAL(profiler.GetAverage("pass", ProfileEvent::TRACK_CPU), 0.f);
+	CHECK(profiler.GetSummary().find("GPU pass 3.00 ms") != std::string::npos);
+}
+
+TEST(ProfilerChromeTraceListsEveryEventRelativeToTheFirst)
+{
+	Profiler& profiler = Profiler::Get();
+	profiler.Clear();
+	const uint64_t frame = profiler.GetFrame();
+	profiler.AddGpuRange("Scene \"main\"", frame, 2000000, 2500000);
+	profiler.AddGpuRange("Clear", frame, 1000000, 1250000);
+	std::ostringstream trace;
+	profiler.WriteChromeTrace(trace);
+	const std::string text = trace.str();
+	CHECK(text.rfind("{\"traceEvents\":[", 0) == 0);
+	CHECK(text.find("\"args\":{\"name\":\"CPU\"}") != std::string::npos);
+	CHECK(text.find("\"args\":{\"name\":\"GPU\"}") != std::string::npos);
+	// Names are escaped, times are microseconds from the earliest event
+	CHECK(text.find("{\"name\":\"Scene \\\"main\\\"\",\"ph\":\"X\",\"ts\":1000.000,\"dur\":500.000,\"pid\":1,\"tid\":0") != std::string::npos);
+	CHECK(text.find("{\"name\":\"Clear\",\"ph\":\"X\",\"ts\":0.000,\"dur\":250.000,\"pid\":1") != std::string::npos);
+	CHECK(text.find("\"args\":{\"frame\":" + std::to_string(frame) + "}}") != std::string::npos);
+	CHECK(text.size() > 4 && text.compare(text.size() - 4, 4, "\n]}\n") == 0);
+}
+
+TEST(ProfilerKeepsOnlyTheRecentHistory)
+{
+	Profiler& profiler = Profiler::Get();
+	profiler.Clear();
+	profiler.AddGpuRange("old", profiler.GetFrame(), 0, 1);
+	for (uint64_t frame = 0; frame <= Profiler::history_frame_num; frame++)
+	{
+		profiler.EndFrame();
+	}
+	CHECK(profiler.GetEvents().empty());
+	// Stale scopes also leave the summary
+	for (uint64_t frame = 0; frame <= Profiler::summary_frame_num; frame++)
+	{
+		profiler.EndFrame();
+	}
+	CHECK(profiler.GetSummary().empty());
+}
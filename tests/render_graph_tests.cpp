@@ -0,0 +1,200 @@
+#include "test.h"
+#include "frame_graph.h"
+#include "null_device.h"
+#include "render_graph.h"
+
+#include <functional>
+#include <string>
+
+// Every barrier of the compiled graph as "batch type resource before>after"
+static std::vector<std::string> DescribeBarriers(const RenderGraph& graph)
+{
+	const char* type_names[] = { "transition", "begin", "end", "uav", "aliasing" };
+	std::vector<std::string> descriptions;
+	for (uint32_t batch = 0; batch < graph.GetBatchNum(); batch++)
+	{
+		for (const RenderGraphBarrier& barrier : graph.GetBarriers(batch))
+		{
+			descriptions.push_back(std::to_string(batch) + " " + type_names[barrier.type] + " " + graph.GetResourceName(barrier.resource) + " " +
+				std::to_string(barrier.state_before) + ">" + std::to_string(barrier.state_after));
+		}
+	}
+	return descriptions;
+}
+
+struct GraphCase
+{
+	const char* name;
+	std::function<void(RenderGraph&)> declare;
+	std::vector<std::string> barriers;
+};
+
+// States: 0 common and present, 4 render target, 8 unordered access, 0x40 + 0x80 = 192 shader resource, 0x400 = 1024 copy dest
+static const GraphCase graph_cases[] =
+{
+	{
+		"imported buffer returns to present after the last pass",
+		[](RenderGraph& graph)
+		{
+			const uint32_t back_buffer = graph.ImportResource("bb", RESOURCE_STATE_PRESENT, RESOURCE_STATE_PRESENT);
+			graph.Write(graph.AddPass("draw"), back_buffer, RESOURCE_STATE_RENDER_TARGET);
+		},
+		{ "0 transition bb 0>4", "1 transition bb 4>0" },
+	},
+	{
+		"consecutive uses in one state need no barrier",
+		[](RenderGraph& graph)
+		{
+			const uint32_t back_buffer = graph.ImportResource("bb", RESOURCE_STATE_PRESENT, RESOURCE_STATE_PRESENT);
+			graph.Write(graph.AddPass("clear"), back_buffer, RESOURCE_STATE_RENDER_TARGET);
+			graph.Write(graph.AddPass("draw"), back_buffer, RESOURCE_STATE_RENDER_TARGET);
+		},
+		{ "0 transition bb 0>4", "2 transition bb 4>0" },
+	},
+	{
+		"a transition across an idle pass is split",
+		[](RenderGraph& graph)
+		{
+			const uint32_t texture = graph.ImportResource("tex", RESOURCE_STATE_COPY_DEST, RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+			const uint32_t target = graph.ImportResource("rt", RESOURCE_STATE_RENDER_TARGET, RESOURCE_STATE_RENDER_TARGET);
+			graph.Write(graph.AddPass("upload"), texture, RESOURCE_STATE_COPY_DEST);
+			graph.Write(graph.AddPass("other"), target, RESOURCE_STATE_RENDER_TARGET);
+			const uint32_t shade = graph.AddPass("shade");
+			graph.Read(shade, texture, RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+			graph.Write(shade, target, RESOURCE_STATE_RENDER_TARGET);
+		},
+		{ "1 begin tex 1024>128", "2 end tex 1024>128" },
+	},
+	{
+		"the return to present is split when the last use is early",
+		[](RenderGraph& graph)
+		{
+			const uint32_t back_buffer = graph.ImportResource("bb", RESOURCE_STATE_PRESENT, RESOURCE_STATE_PRESENT);
+			const uint32_t target = graph.ImportResource("rt", RESOURCE_STATE_RENDER_TARGET, RESOURCE_STATE_RENDER_TARGET);
+			graph.Write(graph.AddPass("draw"), back_buffer, RESOURCE_STATE_RENDER_TARGET);
+			graph.Write(graph.AddPass("offscreen"), target, RESOURCE_STATE_RENDER_TARGET);
+		},
+		{ "0 transition bb 0>4", "1 begin bb 4>0", "2 end bb 4>0" },
+	},
+	{
+		"writes in unordered access are separated by uav barriers",
+		[](RenderGraph& graph)
+		{
+			const uint32_t buffer = graph.ImportResource("buf", RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_UNORDERED_ACCESS);
+			graph.Write(graph.AddPass("a"), buffer, RESOURCE_STATE_UNORDERED_ACCESS);
+			graph.Write(graph.AddPass("b"), buffer, RESOURCE_STATE_UNORDERED_ACCESS);
+			graph.Read(graph.AddPass("c"), buffer, RESOURCE_STATE_UNORDERED_ACCESS);
+		},
+		{ "1 uav buf 8>8", "2 uav buf 8>8" },
+	},
+	{
+		"reads share one combined state",
+		[](RenderGraph& graph)
+		{
+			const uint32_t texture = graph.ImportResource("tex", RESOURCE_STATE_COMMON, RESOURCE_STATE_COMMON);
+			graph.Read(graph.AddPass("vs"), texture, RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+			graph.Read(graph.AddPass("ps"), texture, RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		},
+		{ "0 transition tex 0>192", "2 transition tex 192>0" },
+	},
+	{
+		"transients sharing memory are activated by aliasing barriers",
+		[](RenderGraph& graph)
+		{
+			const uint32_t first = graph.CreateTransient("first", 1024, 256);
+			const uint32_t second = graph.CreateTransient("second", 1024, 256);
+			graph.Write(graph.AddPass("a"), first, RESOURCE_STATE_RENDER_TARGET);
+			graph.Write(graph.AddPass("b"), second, RESOURCE_STATE_UNORDERED_ACCESS);
+		},
+		// Nothing runs before the first, it may follow whichever used the memory last frame
+		{ "0 aliasing first 4>4", "1 aliasing second 8>8" },
+	},
+};
+
+TEST(RenderGraphBarrierTable)
+{
+	for (const GraphCase& graph_case : graph_cases)
+	{
+		RenderGraph graph;
+		graph_case.declare(graph);
+		graph.Compile();
+		const std::vector<std::string> barriers = DescribeBarriers(graph);
+		if (barriers != graph_case.barriers)
+		{
+			printf("  case: %s\n", graph_case.name);
+			for (const std::string& barrier : barriers)
+			{
+				printf("    %s\n", barrier.c_str());
+			}
+		}
+		CHECK(barriers == graph_case.barriers);
+		CHECK_EQUAL(graph.GetBatchNum(), graph.GetPassNum() + 1);
+	}
+}
+
+TEST(RenderGraphAliasingNamesTheOnlyPredecessor)
+{
+	RenderGraph graph;
+	const uint32_t first = graph.CreateTransient("first", 1024, 256);
+	const uint32_t second = graph.CreateTransient("second", 1024, 256);
+	graph.Write(graph.AddPass("a"), first, RESOURCE_STATE_RENDER_TARGET);
+	graph.Write(graph.AddPass("b"), second, RESOURCE_STATE_RENDER_TARGET);
+	graph.Compile();
+	CHECK_EQUAL(graph.GetTransientOffset(first), graph.GetTransientOffset(second));
+	CHECK_EQUAL(graph.GetTransientHeapSize(), 1024ull);
+	CHECK_EQUAL(graph.GetBarriers(1)[0].aliased_resource, first);
+	CHECK_EQUAL(graph.GetBarriers(0)[0].aliased_resource, RenderGraphBarrier::any_resource);
+}
+
+TEST(RenderGraphFrameReplaysCleanlyOnTheNullDevice)
+{
+	RenderGraph graph;
+	const FrameGraph frame_graph = BuildFrameGraph(graph, 1024, 65536);
+	NullDevice device;
+	device.CreateGraphResources(graph);
+	NullCommandList list;
+	for (uint32_t frame = 0; frame < 3; frame++)
+	{
+		list.Reset();
+		for (uint32_t batch = 0; batch < graph.GetBatchNum(); batch++)
+		{
+			list.RecordBatch(graph, batch);
+		}
+		const NullCommandList* lists[] = { &list };
+		device.Execute(lists, 1);
+		device.Present(frame_graph.back_buffer_resource);
+	}
+	CHECK(device.IsValid());
+	CHECK_EQUAL(device.GetState(frame_graph.back_buffer_resource), uint32_t(RESOURCE_STATE_PRESENT));
+}
+
+TEST(RenderGraphSplitBarriersStayInOneList)
+{
+	RenderGraph graph;
+	graph_cases[2].declare(graph);
+	graph.Compile();
+
+	// Every batch in one list is fine
+	NullDevice device;
+	device.CreateGraphResources(graph);
+	NullCommandList lists[3];
+	for (uint32_t batch = 0; batch < graph.GetBatchNum(); batch++)
+	{
+		lists[0].RecordBatch(graph, batch);
+	}
+	const NullCommandList* single[] = { &lists[0] };
+	device.Execute(single, 1);
+	CHECK(device.IsValid());
+
+	// The begin in batch 1 and the end in batch 2 land on different lists
+	NullDevice split_device;
+	split_device.CreateGraphResources(graph);
+	lists[1].RecordBatch(graph, 0);
+	lists[1].RecordBatch(graph, 1);
+	lists[2].RecordBatch(graph, 2);
+	lists[2].RecordBatch(graph, 3);
+	const NullCommandList* spanning[] = { &lists[1], &lists[2] };
+	split_device.Execute(spanning, 2);
+	CHECK_EQUAL(split_device.GetErrorNum(), 1u);
+	CHECK(split_device.GetErrors()[0].find("spans two command lists") != std::string::npos);
+}
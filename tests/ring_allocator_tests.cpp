@@ -0,0 +1,105 @@
+#include "test.h"
+#include "ring_allocator.h"
+
+// Stands in for the upload fence: frames signal increasing values, the GPU completes them later
+struct FakeFence
+{
+	uint64_t next_value = 1;
+	uint64_t completed_value = 0;
+
+	uint64_t Signal() { return next_value++; }
+	void Complete(uint64_t value) { completed_value = value; }
+};
+
+TEST(RingAllocatesAlignedOffsetsInOrder)
+{
+	RingAllocator ring(1024);
+	CHECK_EQUAL(ring.Allocate(100), 0ull);
+	CHECK_EQUAL(ring.Allocate(100, 256), 256ull);
+	CHECK_EQUAL(ring.Allocate(10, 512), 512ull);
+	// Alignment padding counts as used until the region retires
+	CHECK_EQUAL(ring.GetUsedSize(), 522ull);
+	CHECK_EQUAL(ring.Allocate(0), RingAllocator::invalid_offset);
+	CHECK_EQUAL(ring.Allocate(2048), RingAllocator::invalid_offset);
+}
+
+TEST(RingWrapsAroundOnceTheHeadRetires)
+{
+	RingAllocator ring(1000);
+	FakeFence fence;
+	CHECK_EQUAL(ring.Allocate(400), 0ull);
+	const uint64_t first = fence.Signal();
+	ring.FinishRegion(first);
+	CHECK_EQUAL(ring.Allocate(400), 400ull);
+	const uint64_t second = fence.Signal();
+	ring.FinishRegion(second);
+
+	// 200 bytes left at the end and nothing retired at the start
+	CHECK_EQUAL(ring.Allocate(300), RingAllocator::invalid_offset);
+	ring.Retire(fence.completed_value);
+	CHECK_EQUAL(ring.GetPendingRegionNum(), 2u);
+
+	fence.Complete(first);
+	ring.Retire(fence.completed_value);
+	CHECK_EQUAL(ring.GetUsedSize(), 400ull);
+	// The tail of the ring is skipped and the allocation starts over at zero
+	CHECK_EQUAL(ring.Allocate(300), 0ull);
+	CHECK_EQUAL(ring.GetUsedSize(), 400ull + 200 + 300);
+	ring.FinishRegion(fence.Signal());
+	// Between the new tail and the unretired second region
+	CHECK_EQUAL(ring.Allocate(100), 300ull);
+	CHECK_EQUAL(ring.Allocate(1), RingAllocator::invalid_offset);
+	CHECK(ring.IsFull());
+}
+
+TEST(RingReclaimsEverythingOnceAllFencesComplete)
+{
+	RingAllocator ring(4096);
+	FakeFence fence;
+	for (uint32_t frame = 0; frame < 100; frame++)
+	{
+		// Two frames in flight, the GPU completes the one before the last
+		CHECK(ring.Allocate(700 + frame % 5 * 100, 16) != RingAllocator::invalid_offset);
+		ring.FinishRegion(fence.Signal());
+		fence.Complete(fence.next_value - 2);
+		ring.Retire(fence.completed_value);
+		CHECK(ring.GetPendingRegionNum() <= 1);
+	}
+	fence.Complete(fence.next_value - 1);
+	ring.Retire(fence.completed_value);
+	CHECK(ring.IsEmpty());
+	CHECK_EQUAL(ring.GetPendingRegionNum(), 0u);
+}
+
+TEST(RingRetiresRegionsInFenceOrder)
+{
+	RingAllocator ring(1024);
+	ring.Allocate(100);
+	ring.FinishRegion(5);
+	ring.Allocate(100);
+	ring.FinishRegion(6);
+	ring.Allocate(100);
+	// An empty region is not recorded
+	ring.FinishRegion(7);
+	ring.FinishRegion(8);
+	CHECK_EQUAL(ring.GetPendingRegionNum(), 3u);
+	ring.Retire(5);
+	CHECK_EQUAL(ring.GetUsedSize(), 200ull);
+	ring.Retire(7);
+	CHECK(ring.IsEmpty());
+}
+
+TEST(RingHighWaterMarkKeepsThePeak)
+{
+	RingAllocator ring(1024);
+	ring.Allocate(600);
+	ring.FinishRegion(1);
+	ring.Retire(1);
+	ring.Allocate(200);
+	CHECK_EQUAL(ring.GetUsedSize(), 200ull);
+	CHECK_EQUAL(ring.GetHighWaterMark(), 600ull);
+	ring.Allocate(700);
+	CHECK_EQUAL(ring.GetHighWaterMark(), 900ull);
+	ring.Reset(1024);
+	CHECK_EQUAL(ring.GetHighWaterMark(), 0ull);
+}
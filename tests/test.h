@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Minimal test registry, the CPU-side modules have no other dependency to
+// pull in. TEST registers a function, CHECK records a failure and carries on.
+struct TestCase
+{
+	const char* name;
+	void (*function)();
+};
+
+std::vector<TestCase>& GetTestCases();
+void ReportTestFailure(const char* file, int line, const std::string& message);
+
+struct TestRegistration
+{
+	TestRegistration(const char* name, void (*function)()) { GetTestCases().push_back({ name, function }); }
+};
+
+#define TEST(name) \
+	static void name(); \
+	static TestRegistration name##_registration(#name, name); \
+	static void name()
+
+#define CHECK(condition) \
+	do { if (!(condition)) ReportTestFailure(__FILE__, __LINE__, #condition); } while (0)
+
+#define CHECK_EQUAL(actual, expected) \
+	do { \
+		const auto actual_value = (actual); \
+		const auto expected_value = (expected); \
+		if (!(actual_value == expected_value)) \
+			ReportTestFailure(__FILE__, __LINE__, std::string(#actual " == " #expected ", got ") + \
+				std::to_string(actual_value) + " and " + std::to_string(expected_value)); \
+	} while (0)
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cmath>
+
+// Row-major view projection of a camera at the origin looking down +Z,
+// clip = position * matrix with depth in [0, 1] like XMMatrixPerspectiveFovLH
+inline void MakePerspective(float* matrix, float fov = 1.5707963f, float aspect = 1.f, float near_plane = 0.1f, float far_plane = 100.f)
+{
+	const float y_scale = 1.f / std::tan(fov * 0.5f);
+	const float depth_scale = far_plane / (far_plane - near_plane);
+	for (int i = 0; i < 16; i++)
+	{
+		matrix[i] = 0.f;
+	}
+	matrix[0] = y_scale / aspect;
+	matrix[5] = y_scale;
+	matrix[10] = depth_scale;
+	matrix[11] = 1.f;
+	matrix[14] = -near_plane * depth_scale;
+}
@@ -0,0 +1,42 @@
+#include "test.h"
+
+#include <cstring>
+
+static uint32_t failure_num = 0;
+
+std::vector<TestCase>& GetTestCases()
+{
+	static std::vector<TestCase> test_cases;
+	return test_cases;
+}
+
+void ReportTestFailure(const char* file, int line, const std::string& message)
+{
+	failure_num++;
+	fprintf(stderr, "%s:%d: %s\n", file, line, message.c_str());
+}
+
+// Runs every test, or the ones whose name contains the first argument
+int main(int argument_num, char** argument_values)
+{
+	const char* filter = argument_num > 1 ? argument_values[1] : "";
+	uint32_t run_num = 0;
+	uint32_t failed_num = 0;
+	for (const TestCase& test_case : GetTestCases())
+	{
+		if (!strstr(test_case.name, filter))
+		{
+			continue;
+		}
+		const uint32_t previous_failure_num = failure_num;
+		test_case.function();
+		run_num++;
+		if (failure_num != previous_failure_num)
+		{
+			failed_num++;
+			fprintf(stderr, "FAILED %s\n", test_case.name);
+		}
+	}
+	printf("%u tests, %u failed\n", run_num, failed_num);
+	return failed_num == 0 ? 0 : 1;
+}
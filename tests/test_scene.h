@@ -0,0 +1,28 @@
+#pragma once
+
+#include "occlusion_culler.h"
+
+#include <cstdint>
+#include <vector>
+
+// Appends a box with four vertices per face, positions are float3. Returns its bounds.
+inline OcclusionBounds AddBoxMesh(const float* min, const float* max, std::vector<float>& positions, std::vector<uint32_t>& indices)
+{
+	// Corner bit 0 picks max x, bit 1 max y, bit 2 max z
+	const uint32_t faces[6][4] = { { 0, 2, 6, 4 }, { 1, 5, 7, 3 }, { 0, 4, 5, 1 }, { 2, 3, 7, 6 }, { 0, 1, 3, 2 }, { 4, 6, 7, 5 } };
+	const uint32_t first_vertex = static_cast<uint32_t>(positions.size() / 3);
+	for (uint32_t face = 0; face < 6; face++)
+	{
+		for (uint32_t corner : faces[face])
+		{
+			positions.push_back(corner & 1 ? max[0] : min[0]);
+			positions.push_back(corner & 2 ? max[1] : min[1]);
+			positions.push_back(corner & 4 ? max[2] : min[2]);
+		}
+		for (uint32_t index : { 0u, 1u, 2u, 0u, 2u, 3u })
+		{
+			indices.push_back(first_vertex + face * 4 + index);
+		}
+	}
+	return { { min[0], min[1], min[2] }, { max[0], max[1], max[2] } };
+}
@@ -0,0 +1,99 @@
+#include "test.h"
+#include "transient_heap_planner.h"
+
+#include <random>
+
+static bool LifetimesOverlap(const TransientRequest& a, const TransientRequest& b)
+{
+	return a.first_pass <= b.last_pass && b.first_pass <= a.last_pass;
+}
+
+TEST(TransientDisjointLifetimesShareMemory)
+{
+	TransientHeapPlanner planner;
+	planner.Plan({ { 1000, 256, 0, 1 }, { 800, 256, 2, 3 }, { 600, 256, 4, 4 } });
+	CHECK_EQUAL(planner.GetOffset(0), 0ull);
+	CHECK_EQUAL(planner.GetOffset(1), 0ull);
+	CHECK_EQUAL(planner.GetOffset(2), 0ull);
+	CHECK_EQUAL(planner.GetHeapSize(), 1000ull);
+	CHECK(planner.SharesMemory(0, 1));
+	CHECK(planner.SharesMemory(1, 2));
+	// Each aligned on its own: 1000 -> 1024, 1024 + 800 -> 2048, + 600
+	CHECK_EQUAL(planner.GetUnaliasedSize(), 2648ull);
+}
+
+TEST(TransientOverlappingLifetimesGetSeparateBytes)
+{
+	TransientHeapPlanner planner;
+	planner.Plan({ { 1000, 256, 0, 2 }, { 500, 256, 1, 3 }, { 300, 64, 2, 2 } });
+	CHECK(!planner.SharesMemory(0, 1));
+	CHECK(!planner.SharesMemory(0, 2));
+	CHECK(!planner.SharesMemory(1, 2));
+	// Largest first: 0 at 0, 1 at 1024, 2 after 1 at 1536
+	CHECK_EQUAL(planner.GetOffset(1), 1024ull);
+	CHECK_EQUAL(planner.GetOffset(2), 1536ull);
+	CHECK_EQUAL(planner.GetHeapSize(), 1836ull);
+}
+
+TEST(TransientFirstFitUsesGapsBetweenLiveResources)
+{
+	TransientHeapPlanner planner;
+	// 0 and 2 live throughout, 1 dies early and leaves a hole between them
+	planner.Plan({ { 4096, 1024, 0, 4 }, { 2048, 1024, 0, 1 }, { 1024, 1024, 0, 4 }, { 1536, 512, 2, 4 } });
+	CHECK_EQUAL(planner.GetOffset(0), 0ull);
+	CHECK_EQUAL(planner.GetOffset(1), 4096ull);
+	CHECK_EQUAL(planner.GetOffset(2), 6144ull);
+	CHECK_EQUAL(planner.GetOffset(3), 4096ull);
+	CHECK(planner.SharesMemory(1, 3));
+	CHECK_EQUAL(planner.GetHeapSize(), 7168ull);
+}
+
+TEST(TransientOffsetsHonorAlignment)
+{
+	TransientHeapPlanner planner;
+	planner.Plan({ { 100, 1, 0, 0 }, { 100, 65536, 0, 0 } });
+	CHECK_EQUAL(planner.GetOffset(0), 0ull);
+	CHECK_EQUAL(planner.GetOffset(1), 65536ull);
+	CHECK_EQUAL(planner.GetHeapSize(), 65636ull);
+	planner.Plan({});
+	CHECK_EQUAL(planner.GetHeapSize(), 0ull);
+}
+
+TEST(TransientRandomPlansNeverAliasLiveResources)
+{
+	std::mt19937 random(23);
+	TransientHeapPlanner planner;
+	for (uint32_t plan = 0; plan < 200; plan++)
+	{
+		std::vector<TransientRequest> requests(1 + random() % 24);
+		for (TransientRequest& request : requests)
+		{
+			request.size = 1 + random() % 100000;
+			request.alignment = 1ull << (random() % 17);
+			request.first_pass = random() % 10;
+			request.last_pass = request.first_pass + random() % 4;
+		}
+		planner.Plan(requests);
+		uint64_t live_peak = 0;
+		for (uint32_t pass = 0; pass < 14; pass++)
+		{
+			uint64_t live_size = 0;
+			for (const TransientRequest& request : requests)
+			{
+				live_size += request.first_pass <= pass && pass <= request.last_pass ? request.size : 0;
+			}
+			live_peak = std::max(live_peak, live_size);
+		}
+		CHECK(planner.GetHeapSize() >= live_peak);
+		CHECK(planner.GetHeapSize() <= planner.GetUnaliasedSize());
+		for (uint32_t a = 0; a < requests.size(); a++)
+		{
+			CHECK_EQUAL(planner.GetOffset(a) % requests[a].alignment, 0ull);
+			CHECK(planner.GetOffset(a) + requests[a].size <= planner.GetHeapSize());
+			for (uint32_t b = a + 1; b < requests.size(); b++)
+			{
+				CHECK(!LifetimesOverlap(requests[a], requests[b]) || !planner.SharesMemory(a, b));
+			}
+		}
+	}
+}
@@ -0,0 +1,91 @@
+#include "test.h"
+#include "upload_scheduler.h"
+
+#include <string>
+
+// Records queue operations in call order instead of talking to D3D12
+class RecordingQueueSync : public QueueSync
+{
+public:
+	void SignalCopy(uint64_t fence_value) override { operations.push_back("signal " + std::to_string(fence_value)); }
+	void WaitForCopyOnDirect(uint64_t fence_value) override { operations.push_back("wait " + std::to_string(fence_value)); }
+	uint64_t GetCompletedCopyValue() const override { return completed_value; }
+
+	std::vector<std::string> operations;
+	uint64_t completed_value = 0;
+};
+
+TEST(UploadBatchesSignalIncreasingFenceValues)
+{
+	RecordingQueueSync queue;
+	UploadScheduler scheduler(queue);
+	CHECK_EQUAL(scheduler.BeginBatch(), 0u);
+	CHECK(scheduler.IsBatchOpen());
+	// Uploads into an open batch share its allocator
+	CHECK_EQUAL(scheduler.BeginBatch(), 0u);
+	CHECK_EQUAL(scheduler.SubmitBatch(), 1ull);
+	CHECK(!scheduler.IsBatchOpen());
+	scheduler.BeginBatch();
+	CHECK_EQUAL(scheduler.SubmitBatch(), 2ull);
+	CHECK_EQUAL(scheduler.GetLastSubmittedValue(), 2ull);
+	CHECK(queue.operations == std::vector<std::string>({ "signal 1", "signal 2" }));
+}
+
+TEST(UploadAllocatorsRecycleOnlyAfterTheirFence)
+{
+	RecordingQueueSync queue;
+	UploadScheduler scheduler(queue);
+	CHECK_EQUAL(scheduler.BeginBatch(), 0u);
+	scheduler.SubmitBatch();
+	// Batch 1 is still on the copy queue, so a second allocator is needed
+	CHECK_EQUAL(scheduler.BeginBatch(), 1u);
+	scheduler.SubmitBatch();
+	CHECK_EQUAL(scheduler.GetAllocatorNum(), 2u);
+
+	queue.completed_value = 1;
+	CHECK_EQUAL(scheduler.BeginBatch(), 0u);
+	scheduler.SubmitBatch();
+	queue.completed_value = 3;
+	scheduler.BeginBatch();
+	scheduler.SubmitBatch();
+	CHECK_EQUAL(scheduler.GetAllocatorNum(), 2u);
+}
+
+TEST(UploadDirectQueueWaitsOnlyOnTheNewestRequiredValue)
+{
+	RecordingQueueSync queue;
+	UploadScheduler scheduler(queue);
+	for (uint32_t batch = 0; batch < 3; batch++)
+	{
+		scheduler.BeginBatch();
+		scheduler.RequireUpload(scheduler.SubmitBatch());
+	}
+	// An older requirement does not lower the wait
+	scheduler.RequireUpload(1);
+	scheduler.InsertWaits();
+	// Nothing new is required, the next frame submits without a wait
+	scheduler.InsertWaits();
+	CHECK(queue.operations == std::vector<std::string>({ "signal 1", "signal 2", "signal 3", "wait 3" }));
+	CHECK_EQUAL(scheduler.GetWaitNum(), 1u);
+}
+
+TEST(UploadCompletedBatchesNeedNoWait)
+{
+	RecordingQueueSync queue;
+	UploadScheduler scheduler(queue);
+	scheduler.BeginBatch();
+	const uint64_t fence_value = scheduler.SubmitBatch();
+	scheduler.RequireUpload(fence_value);
+	CHECK(!scheduler.IsComplete(fence_value));
+	queue.completed_value = fence_value;
+	CHECK(scheduler.IsComplete(fence_value));
+	scheduler.InsertWaits();
+	CHECK(queue.operations == std::vector<std::string>({ "signal 1" }));
+	CHECK_EQUAL(scheduler.GetWaitNum(), 0u);
+
+	// A later batch still pending gets its wait after the signal that produces it
+	scheduler.BeginBatch();
+	scheduler.RequireUpload(scheduler.SubmitBatch());
+	scheduler.InsertWaits();
+	CHECK(queue.operations == std::vector<std::string>({ "signal 1", "signal 2", "wait 2" }));
+}